@@ -1,11 +1,17 @@
 #include "A3Engine.h"
 
+#include "InstancingUtils.hpp"
+
 #include <CSCI441/FreeCam.hpp>
 #include <CSCI441/objects.hpp>
+#include <CSCI441/OpenGLUtils.hpp> // for CSCI441::Y_AXIS
 
 #include <glm/gtc/constants.hpp> // for glm::pi()
+#include <glm/gtc/matrix_transform.hpp> // for glm::translate(), glm::rotate(), glm::scale()
 #include <glm/gtc/type_ptr.hpp>  // for glm::value_ptr()
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
@@ -25,19 +31,38 @@ GLfloat getRand() {
 
 A3Engine::A3Engine()
     : CSCI441::OpenGLEngine(4, 1, 640, 480, "a3: Flight Simulator v0.41 alpha"),
+    _profiler(nullptr),
+    _hudText(nullptr),
     _mousePosition( {MOUSE_UNINITIALIZED, MOUSE_UNINITIALIZED} ),
     _leftMouseButtonState(GLFW_RELEASE),
     _pMainCam(nullptr),
     _cameraSpeed( {0.0f, 0.0f} ),
     _pCaedilas(nullptr),
+    _hasCrowd(GL_FALSE),
     _groundVAO(0),
     _numGroundPoints(0),
+    _buildingVAO(0),
+    _buildingVBO(0),
+    _buildingIBO(0),
+    _numBuildingIndices(0),
+    _buildingDataBuffer(0),
+    _buildingDataTexture(0),
+    _visibleBuildingBuffer(0),
+    _visibleBuildingCapacity(0),
     _lightingShaderProgram(nullptr),
     _lightingShaderUniformLocations( {-1, -1} ),
     _lightingShaderAttributeLocations( {-1} ),
-    _textureShaderProgram(nullptr),
-    _textureShaderUniformLocations( {-1, -1, -1, -1} ),
-    _textureShaderAttributeLocations( {-1, -1} )
+    _buildingShaderProgram(nullptr),
+    _buildingShaderUniformLocations( {-1, -1, -1, -1} ),
+    _buildingShaderAttributeLocations( {-1, -1, -1} ),
+    _crowdShaderProgram(nullptr),
+    _crowdShaderUniformLocations( {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1} ),
+    _crowdShaderAttributeLocations( {-1, -1, -1, -1, -1, -1, -1} ),
+    _skinnedShaderProgram(nullptr),
+    _skinnedShaderUniformLocations( {-1, -1, -1, -1, -1} ),
+    _skinnedShaderAttributeLocations( {-1, -1, -1, -1, -1} ),
+    _lastTime(0.0f),
+    _currTime(0.0f)
 {
     for(auto& _key : _keys) _key = GL_FALSE;
 }
@@ -47,7 +72,9 @@ A3Engine::~A3Engine() {
     delete _pMainCam;
     delete _pCaedilas;
     delete _lightingShaderProgram;
-    delete _textureShaderProgram;
+    delete _buildingShaderProgram;
+    delete _crowdShaderProgram;
+    delete _skinnedShaderProgram;
 }
 
 void A3Engine::handleKeyEvent(const GLint KEY, const GLint ACTION) {
@@ -66,11 +93,18 @@ void A3Engine::handleKeyEvent(const GLint KEY, const GLint ACTION) {
                 mReloadShaders();
                 _setLightingParameters();
                 _pCaedilas->setProgramUniformLocations(
-                    _textureShaderProgram->getShaderProgramHandle(),
-                    _textureShaderUniformLocations.mvpMatrix
+                    _skinnedShaderProgram->getShaderProgramHandle(),
+                    _skinnedShaderUniformLocations.mvpMatrix,
+                    _skinnedShaderUniformLocations.normalMatrix
                 );
                 break;
 
+            // show/hide the frame profiler readout
+            case GLFW_KEY_P:
+                _profiler->setEnabled( !_profiler->isEnabled() );
+                fprintf( stdout, "[INFO]: frame profiler %s\n", _profiler->isEnabled() ? "on" : "off" );
+                break;
+
             default: break; // suppress CLion warning
         }
     }
@@ -111,6 +145,10 @@ void A3Engine::handleCursorPositionEvent(const glm::vec2 currMousePosition) {
 // Engine Setup
 
 void A3Engine::mSetupGLFW() {
+    // surfaceless context for the benchmark
+    if( _benchmark.enabled ) {
+        setHeadlessContextHints(_benchmark);
+    }
     CSCI441::OpenGLEngine::mSetupGLFW();
 
     // set our callbacks
@@ -144,34 +182,98 @@ void A3Engine::mSetupShaders() {
     _lightingShaderAttributeLocations.vNormal         = _lightingShaderProgram->getAttributeLocation("vNormal");
 
 
-    // texture shaders
-    _textureShaderProgram = new CSCI441::ShaderProgram("shaders/texture.v.glsl", "shaders/texture.f.glsl" );
+    // instanced building shaders
+    _buildingShaderProgram = new CSCI441::ShaderProgram("shaders/A3BuildingShader.v.glsl", "shaders/A3BuildingShader.f.glsl" );
     // uniforms
-    _textureShaderUniformLocations.mvpMatrix      = _textureShaderProgram->getUniformLocation("mvpMatrix");
-    _textureShaderUniformLocations.texMap = _textureShaderProgram->getUniformLocation("texMap");
-    _textureShaderUniformLocations.lightDirection = _lightingShaderProgram->getUniformLocation("lightDirection");
-    _textureShaderUniformLocations.lightColor = _lightingShaderProgram->getUniformLocation("lightColor");
-
-    // attribute locations
-    _textureShaderAttributeLocations.vPos         = _textureShaderProgram->getAttributeLocation("vPos");
-    //_textureShaderAttributeLocations.vNormal      = _textureShaderProgram->getAttributeLocation("vNormal");
-    _textureShaderAttributeLocations.vTexCoord = _textureShaderProgram->getAttributeLocation("vTexCoord");
-
-    // static uniform
-    _textureShaderProgram->setProgramUniform(_textureShaderUniformLocations.texMap, 0);
+    _buildingShaderUniformLocations.viewProjMatrix = _buildingShaderProgram->getUniformLocation("viewProjMatrix");
+    _buildingShaderUniformLocations.lightDirection = _buildingShaderProgram->getUniformLocation("lightDirection");
+    _buildingShaderUniformLocations.lightColor     = _buildingShaderProgram->getUniformLocation("lightColor");
+    _buildingShaderUniformLocations.buildingData   = _buildingShaderProgram->getUniformLocation("buildingData");
+
+    // attributes
+    _buildingShaderAttributeLocations.vPos          = _buildingShaderProgram->getAttributeLocation("vPos");
+    _buildingShaderAttributeLocations.vNormal       = _buildingShaderProgram->getAttributeLocation("vNormal");
+    _buildingShaderAttributeLocations.buildingIndex = _buildingShaderProgram->getAttributeLocation("buildingIndex");
+
+    // static uniform, the building data always sits on texture unit 1
+    _buildingShaderProgram->setProgramUniform(_buildingShaderUniformLocations.buildingData, 1);
+
+    // instanced crowd shaders, sharing the skinned model's fragment shader
+    _crowdShaderProgram = new CSCI441::ShaderProgram("shaders/SkinnedMD5CrowdShader.v.glsl", "shaders/SkinnedMD5Shader.f.glsl" );
+    // uniforms
+    _crowdShaderUniformLocations.viewProjMatrix = _crowdShaderProgram->getUniformLocation("viewProjMatrix");
+    _crowdShaderUniformLocations.modelMatrix    = _crowdShaderProgram->getUniformLocation("modelMatrix");
+    _crowdShaderUniformLocations.normalMatrix   = _crowdShaderProgram->getUniformLocation("normalMatrix");
+    _crowdShaderUniformLocations.lightDirection = _crowdShaderProgram->getUniformLocation("lightDirection");
+    _crowdShaderUniformLocations.lightColor     = _crowdShaderProgram->getUniformLocation("lightColor");
+    _crowdShaderUniformLocations.crowdTime      = _crowdShaderProgram->getUniformLocation("crowdTime");
+    _crowdShaderUniformLocations.frameRate      = _crowdShaderProgram->getUniformLocation("frameRate");
+    _crowdShaderUniformLocations.numFrames      = _crowdShaderProgram->getUniformLocation("numFrames");
+    _crowdShaderUniformLocations.numJoints      = _crowdShaderProgram->getUniformLocation("numJoints");
+    _crowdShaderUniformLocations.bakedPalettes  = _crowdShaderProgram->getUniformLocation("bakedPalettes");
+    _crowdShaderUniformLocations.texMap         = _crowdShaderProgram->getUniformLocation("texMap");
+
+    // attributes
+    _crowdShaderAttributeLocations.vPos               = _crowdShaderProgram->getAttributeLocation("vPos");
+    _crowdShaderAttributeLocations.vNormal            = _crowdShaderProgram->getAttributeLocation("vNormal");
+    _crowdShaderAttributeLocations.vTexCoord          = _crowdShaderProgram->getAttributeLocation("vTexCoord");
+    _crowdShaderAttributeLocations.vJointIndices      = _crowdShaderProgram->getAttributeLocation("vJointIndices");
+    _crowdShaderAttributeLocations.vJointWeights      = _crowdShaderProgram->getAttributeLocation("vJointWeights");
+    _crowdShaderAttributeLocations.instancePlacement  = _crowdShaderProgram->getAttributeLocation("instancePlacement");
+    _crowdShaderAttributeLocations.instanceTimeOffset = _crowdShaderProgram->getAttributeLocation("instanceTimeOffset");
+
+    // static uniforms, the diffuse map on unit 0 and the baked palettes on unit 1
+    _crowdShaderProgram->setProgramUniform(_crowdShaderUniformLocations.texMap, 0);
+    _crowdShaderProgram->setProgramUniform(_crowdShaderUniformLocations.bakedPalettes, 1);
+
+    // skinned model shaders, Caedilas's joints are blended in the vertex shader
+    _skinnedShaderProgram = new CSCI441::ShaderProgram("shaders/SkinnedMD5Shader.v.glsl", "shaders/SkinnedMD5Shader.f.glsl" );
+    // uniforms
+    _skinnedShaderUniformLocations.mvpMatrix      = _skinnedShaderProgram->getUniformLocation("mvpMatrix");
+    _skinnedShaderUniformLocations.normalMatrix   = _skinnedShaderProgram->getUniformLocation("normalMatrix");
+    _skinnedShaderUniformLocations.texMap         = _skinnedShaderProgram->getUniformLocation("texMap");
+    _skinnedShaderUniformLocations.lightDirection = _skinnedShaderProgram->getUniformLocation("lightDirection");
+    _skinnedShaderUniformLocations.lightColor     = _skinnedShaderProgram->getUniformLocation("lightColor");
+
+    // attributes
+    _skinnedShaderAttributeLocations.vPos          = _skinnedShaderProgram->getAttributeLocation("vPos");
+    _skinnedShaderAttributeLocations.vNormal       = _skinnedShaderProgram->getAttributeLocation("vNormal");
+    _skinnedShaderAttributeLocations.vTexCoord     = _skinnedShaderProgram->getAttributeLocation("vTexCoord");
+    _skinnedShaderAttributeLocations.vJointIndices = _skinnedShaderProgram->getAttributeLocation("vJointIndices");
+    _skinnedShaderAttributeLocations.vJointWeights = _skinnedShaderProgram->getAttributeLocation("vJointWeights");
+
+    // static uniform, the diffuse map on unit 0 (Caedilas points the joint palette at unit 1 itself)
+    _skinnedShaderProgram->setProgramUniform(_skinnedShaderUniformLocations.texMap, 0);
+
+    // profiler readout
+    _hudText = new TextOverlay();
+    _hudText->setup();
 }
 
 void A3Engine::mSetupBuffers() {
-    _pCaedilas = new Caedilas(_textureShaderProgram->getShaderProgramHandle(),
-                        _textureShaderUniformLocations.mvpMatrix,
-                        //_textureShaderUniformLocations.normalMatrix,
-                        _textureShaderAttributeLocations.vPos,
-                        //_textureShaderAttributeLocations.vNormal,
-                        _textureShaderAttributeLocations.vTexCoord);
+    _pCaedilas = new Caedilas(_skinnedShaderProgram->getShaderProgramHandle(),
+                        _skinnedShaderUniformLocations.mvpMatrix,
+                        _skinnedShaderUniformLocations.normalMatrix,
+                        _skinnedShaderAttributeLocations.vPos,
+                        _skinnedShaderAttributeLocations.vNormal,
+                        _skinnedShaderAttributeLocations.vTexCoord,
+                        _skinnedShaderAttributeLocations.vJointIndices,
+                        _skinnedShaderAttributeLocations.vJointWeights);
 
     _pCaedilas->setWorldEdges(WORLD_SIZE, 1.0f, WORLD_SIZE);
     _createGroundBuffers();
+    _createBuildingBuffers();
     _generateEnvironment();
+    _createCrowd();
+
+    // in ProfileSection order
+    _profiler = new FrameProfiler();
+    _profiler->addSection("frame", false);
+    _profiler->addSection("update", false);
+    _profiler->addSection("ground", true);
+    _profiler->addSection("buildings", true);
+    _profiler->addSection("model", true);
+    _profiler->addSection("hud", true);
 }
 
 void A3Engine::_createGroundBuffers() {
@@ -214,6 +316,25 @@ void A3Engine::_createGroundBuffers() {
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 }
 
+void A3Engine::_createBuildingBuffers() {
+    glGenVertexArrays(1, &_buildingVAO);
+    glBindVertexArray(_buildingVAO);
+    _numBuildingIndices = createUnitCubeBuffers(_buildingShaderAttributeLocations.vPos, _buildingShaderAttributeLocations.vNormal,
+                                                _buildingVBO, _buildingIBO);
+
+    // one building index per instance, storage comes with the first _renderScene()
+    glGenBuffers(1, &_visibleBuildingBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, _visibleBuildingBuffer);
+    glEnableVertexAttribArray(_buildingShaderAttributeLocations.buildingIndex);
+    glVertexAttribIPointer(_buildingShaderAttributeLocations.buildingIndex, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)nullptr);
+    glVertexAttribDivisor(_buildingShaderAttributeLocations.buildingIndex, 1);
+    glBindVertexArray(0);
+
+    // the data itself is filled in by _generateEnvironment()
+    glGenBuffers(1, &_buildingDataBuffer);
+    glGenTextures(1, &_buildingDataTexture);
+}
+
 void A3Engine::_generateEnvironment() {
     //******************************************************************
     // parameters to make up our grid size and spacing, feel free to
@@ -229,7 +350,12 @@ void A3Engine::_generateEnvironment() {
     constexpr GLfloat TOP_END_POINT = GRID_LENGTH / 2.0f + 5.0f;
     //******************************************************************
 
-    srand( time(0) );                                                   // seed our RNG
+    srand( _benchmark.enabled ? BenchmarkSettings::SEED : time(0) );    // seed our RNG, fixed for benchmarks so every run builds the same city
+
+    // every building is a scaled and moved unit cube
+    BoundingBox unitCube;
+    unitCube.expand( glm::vec3(-0.5f) );
+    unitCube.expand( glm::vec3(0.5f) );
 
     // psych! everything's on a grid.
     for(int i = LEFT_END_POINT; i < RIGHT_END_POINT; i += GRID_SPACING_WIDTH) {
@@ -255,26 +381,84 @@ void A3Engine::_generateEnvironment() {
                 // store building properties
                 BuildingData currentBuilding = {modelMatrix, color};
                 _buildings.emplace_back( currentBuilding );
+                // bound it once here, buildings never move
+                _buildingBounds.add( BoundingSphere::fromBox( unitCube.transformed(modelMatrix) ) );
             }
         }
     }
+
+    const size_t maxBuildings = getMaxTextureBufferTexels() / TEXELS_PER_BUILDING;
+    if( _buildings.size() > maxBuildings ) {
+        fprintf( stderr, "[WARN]: the building data buffer can hold %zu of %zu buildings\n", maxBuildings, _buildings.size() );
+        _buildings.resize(maxBuildings);
+        _buildingBounds.x.resize(maxBuildings);
+        _buildingBounds.y.resize(maxBuildings);
+        _buildingBounds.z.resize(maxBuildings);
+        _buildingBounds.radius.resize(maxBuildings);
+    }
+
+    // buildings never move, so they are packed for the shader once here
+    std::vector<glm::vec4> texels;
+    texels.reserve(_buildings.size() * TEXELS_PER_BUILDING);
+    for( const BuildingData& building : _buildings ) {
+        for( int column = 0; column < 4; column++ ) {
+            texels.push_back( building.modelMatrix[column] );
+        }
+        texels.push_back( glm::vec4(building.color, 1.0f) );
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, _buildingDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(texels.size() * sizeof(glm::vec4)), texels.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, _buildingDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _buildingDataBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    fprintf( stdout, "[INFO]: packed %zu buildings into the building data buffer\n", _buildings.size() );
+}
+
+void A3Engine::_createCrowd() {
+    SkinnedMD5* model = _pCaedilas->getModel();
+    if( model == nullptr || !model->bakeAnimation() ) {
+        return;
+    }
+
+    // the buildings sit on odd grid points, so every even grid line is a street.  each copy stands on one,
+    // facing along it, somewhere else in the clip
+    constexpr GLfloat STREET_EXTENT = WORLD_SIZE * 0.9f;
+    const GLfloat clipLength = static_cast<GLfloat>(model->getNumBakedFrames()) / std::max(model->getFrameRate(), 1.0f);
+    std::vector<SkinnedMD5::CrowdInstance> crowd;
+    crowd.reserve(NUM_CROWD);
+    for( GLuint i = 0; i < NUM_CROWD; i++ ) {
+        const GLfloat street = 2.0f * glm::floor( (getRand() * 2.0f - 1.0f) * STREET_EXTENT / 2.0f );
+        const GLfloat along = (getRand() * 2.0f - 1.0f) * STREET_EXTENT;
+        const GLboolean alongX = getRand() < 0.5f;
+        const GLfloat heading = (alongX ? 0.0f : glm::half_pi<float>()) + (getRand() < 0.5f ? glm::pi<float>() : 0.0f);
+        const glm::vec3 position = alongX ? glm::vec3(along, 1.0f, street) : glm::vec3(street, 1.0f, along);
+        crowd.push_back( { glm::vec4(position, heading), getRand() * clipLength } );
+        // copies never leave their spot, so they are bound once here like the buildings
+        _crowdBounds.add( BoundingSphere{position, MODEL_CULL_RADIUS} );
+    }
+    model->setCrowd( crowd,
+                     _crowdShaderAttributeLocations.vPos, _crowdShaderAttributeLocations.vNormal, _crowdShaderAttributeLocations.vTexCoord,
+                     _crowdShaderAttributeLocations.vJointIndices, _crowdShaderAttributeLocations.vJointWeights,
+                     _crowdShaderAttributeLocations.instancePlacement, _crowdShaderAttributeLocations.instanceTimeOffset );
+    _hasCrowd = GL_TRUE;
 }
 
 void A3Engine::mSetupScene() {
-    _pMainCam = new ArcBallCam();
+    _pMainCam = new ArcballCam();
     _pMainCam->setTheta(glm::pi<float>() / -3.0f );
     _pMainCam->setPhi(glm::pi<float>() / 1.5f);
-    _pMainCam->setLookAtPoint(_pCaedilas->getLocation() + 1.0f);
+    _pMainCam->setLookAtPoint(_pCaedilas->getPosition() + 1.0f);
     _pMainCam->recomputeOrientation();
 
-    _pSecondaryCam = new ArcBallCam();
+    _pSecondaryCam = new ArcballCam();
     _pSecondaryCam->setTheta(_pCaedilas->getTheta() + glm::radians(-90.0f));
     _pSecondaryCam->setPhi(glm::pi<float>() / 2.0f);
-    _pSecondaryCam->setLookAtPoint(_pCaedilas->getLocation() + 1.0f);
+    _pSecondaryCam->setLookAtPoint(_pCaedilas->getPosition() + 1.0f);
     _pSecondaryCam->recomputeOrientation();
 
     _cameraSpeed = glm::vec2(0.25f, 0.02f);
-    _playerSpeed = glm::vec2(0.25f, 0.02f);
+    _playerSpeed = glm::vec2(15.0f, 1.2f);
 
     _setLightingParameters();
 }
@@ -298,11 +482,47 @@ void A3Engine::_setLightingParameters() {
       glm::value_ptr(lightColor)
       );
 
-  // send to texture shaders
+  // send to instanced building shaders
+  glProgramUniform3fv(
+      _buildingShaderProgram->getShaderProgramHandle(),
+      _buildingShaderUniformLocations.lightDirection,
+      1,
+      glm::value_ptr(lightDirection)
+      );
 
   glProgramUniform3fv(
-      _textureShaderProgram->getShaderProgramHandle(),
-      _textureShaderUniformLocations.lightColor,
+      _buildingShaderProgram->getShaderProgramHandle(),
+      _buildingShaderUniformLocations.lightColor,
+      1,
+      glm::value_ptr(lightColor)
+      );
+
+  // send to instanced crowd shaders
+  glProgramUniform3fv(
+      _crowdShaderProgram->getShaderProgramHandle(),
+      _crowdShaderUniformLocations.lightDirection,
+      1,
+      glm::value_ptr(lightDirection)
+      );
+
+  glProgramUniform3fv(
+      _crowdShaderProgram->getShaderProgramHandle(),
+      _crowdShaderUniformLocations.lightColor,
+      1,
+      glm::value_ptr(lightColor)
+      );
+
+  // send to skinned model shaders, _updateScene() turns the direction with Caedilas from then on
+  glProgramUniform3fv(
+      _skinnedShaderProgram->getShaderProgramHandle(),
+      _skinnedShaderUniformLocations.lightDirection,
+      1,
+      glm::value_ptr(lightDirection)
+      );
+
+  glProgramUniform3fv(
+      _skinnedShaderProgram->getShaderProgramHandle(),
+      _skinnedShaderUniformLocations.lightColor,
       1,
       glm::value_ptr(lightColor)
       );
@@ -316,8 +536,14 @@ void A3Engine::mCleanupShaders() {
     fprintf( stdout, "[INFO]: ...deleting Shaders.\n" );
     delete _lightingShaderProgram;
     _lightingShaderProgram = nullptr;
-    delete _textureShaderProgram;
-    _textureShaderProgram = nullptr;
+    delete _buildingShaderProgram;
+    _buildingShaderProgram = nullptr;
+    delete _crowdShaderProgram;
+    _crowdShaderProgram = nullptr;
+    delete _skinnedShaderProgram;
+    _skinnedShaderProgram = nullptr;
+    delete _hudText;
+    _hudText = nullptr;
 }
 
 void A3Engine::mCleanupBuffers() {
@@ -325,13 +551,29 @@ void A3Engine::mCleanupBuffers() {
     CSCI441::deleteObjectVAOs();
     glDeleteVertexArrays( 1, &_groundVAO );
     _groundVAO = 0;
+    glDeleteVertexArrays( 1, &_buildingVAO );
+    _buildingVAO = 0;
 
     fprintf( stdout, "[INFO]: ...deleting VBOs....\n" );
     CSCI441::deleteObjectVBOs();
+    glDeleteBuffers( 1, &_buildingVBO );
+    glDeleteBuffers( 1, &_buildingIBO );
+    glDeleteBuffers( 1, &_visibleBuildingBuffer );
+    glDeleteBuffers( 1, &_buildingDataBuffer );
+    _buildingVBO = _buildingIBO = _visibleBuildingBuffer = _buildingDataBuffer = 0;
+    _visibleBuildingCapacity = 0;
+
+    fprintf( stdout, "[INFO]: ...deleting textures....\n" );
+    glDeleteTextures( 1, &_buildingDataTexture );
+    _buildingDataTexture = 0;
 
     fprintf( stdout, "[INFO]: ...deleting models..\n" );
     delete _pCaedilas;
     _pCaedilas = nullptr;
+
+    fprintf( stdout, "[INFO]: ...deleting timer queries..\n" );
+    delete _profiler;
+    _profiler = nullptr;
 }
 
 void A3Engine::mCleanupScene() {
@@ -346,42 +588,117 @@ void A3Engine::mCleanupScene() {
 //
 // Rendering / Drawing Functions - this is where the magic happens!
 
-void A3Engine::_renderScene(const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
-    // use our lighting shader program
-    _lightingShaderProgram->useProgram();
-    CSCI441::setVertexAttributeLocations( _lightingShaderAttributeLocations.vPos, _lightingShaderAttributeLocations.vNormal );
+void A3Engine::_renderScene(const glm::mat4& viewMtx, const glm::mat4& projMtx, const bool profilePasses) const {
+    // everything below is only submitted, the setup/draw functions run in _renderQueue.flush() before we return
+    // so they can hold on to viewMtx, projMtx, and the buildings by reference
 
-    //// BEGIN DRAWING THE GROUND Caedilas ////
-    // draw the ground Caedilas
-    const glm::mat4 groundModelMtx = glm::scale( glm::mat4(1.0f), glm::vec3(WORLD_SIZE, 1.0f, WORLD_SIZE));
-    _computeAndSendMatrixUniforms(groundModelMtx, viewMtx, projMtx);
+    // while profiling each pass is flushed inside its own section so its GL work lands in its own query,
+    // otherwise everything waits for the single sorted flush at the end
+    const auto flushPass = [this, profilePasses](const GLuint section) {
+        if( !profilePasses ) return;
+        FrameProfiler::Scope scope(*_profiler, section);
+        _renderQueue.flush();
+    };
 
-    constexpr glm::vec3 groundColor(0.3f, 0.8f, 0.2f);
-    _lightingShaderProgram->setProgramUniform(_lightingShaderUniformLocations.materialColor, groundColor);
+    // anything entirely outside the view volume is never submitted
+    const Frustum frustum( projMtx * viewMtx );
 
-    glBindVertexArray(_groundVAO);
-    glDrawElements(GL_TRIANGLE_STRIP, _numGroundPoints, GL_UNSIGNED_SHORT, (void*)0);
+    //// BEGIN DRAWING THE GROUND Caedilas ////
+    // draw the ground Caedilas with our lighting shader program
+    BoundingBox groundBounds;
+    groundBounds.expand( glm::vec3(-WORLD_SIZE, 0.0f, -WORLD_SIZE) );
+    groundBounds.expand( glm::vec3( WORLD_SIZE, 0.0f,  WORLD_SIZE) );
+    RenderQueue::Item ground;
+    ground.program = _lightingShaderProgram->getShaderProgramHandle();
+    ground.vao = _groundVAO;
+    ground.mode = GL_TRIANGLE_STRIP;
+    ground.count = _numGroundPoints;
+    ground.indexType = GL_UNSIGNED_SHORT;
+    ground.setup = [this, &viewMtx, &projMtx] {
+        const glm::mat4 groundModelMtx = glm::scale( glm::mat4(1.0f), glm::vec3(WORLD_SIZE, 1.0f, WORLD_SIZE));
+        _computeAndSendMatrixUniforms(groundModelMtx, viewMtx, projMtx);
+
+        constexpr glm::vec3 groundColor(0.3f, 0.8f, 0.2f);
+        _lightingShaderProgram->setProgramUniform(_lightingShaderUniformLocations.materialColor, groundColor);
+    };
+    if( frustum.isVisible(groundBounds) ) {
+        _renderQueue.submit(std::move(ground));
+    }
+    flushPass(PROFILE_GROUND);
     //// END DRAWING THE GROUND Caedilas ////
 
     //// BEGIN DRAWING THE BUILDINGS ////
-    for( const BuildingData& currentBuilding : _buildings ) {
-        _computeAndSendMatrixUniforms(currentBuilding.modelMatrix, viewMtx, projMtx);
-
-        _lightingShaderProgram->setProgramUniform(_lightingShaderUniformLocations.materialColor, currentBuilding.color);
-
-        CSCI441::drawSolidCube(1.0);
+    frustum.cullSpheres( _buildingBounds, _visibleBuildings );
+    if( !_visibleBuildings.empty() ) {
+        // the building data never changes, only the indices of the ones in view are sent.  The two views of a frame
+        // see different buildings, so the old storage is orphaned rather than overwritten under a pending draw
+        glBindBuffer(GL_ARRAY_BUFFER, _visibleBuildingBuffer);
+        _visibleBuildingCapacity = std::max( _visibleBuildingCapacity, static_cast<GLuint>(_visibleBuildings.size()) );
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_visibleBuildingCapacity) * sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(_visibleBuildings.size() * sizeof(GLuint)), _visibleBuildings.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // every visible building is an instance of the same cube, its model matrix and color come from the building data
+        RenderQueue::Item buildings;
+        buildings.program = _buildingShaderProgram->getShaderProgramHandle();
+        buildings.vao = _buildingVAO;
+        buildings.count = _numBuildingIndices;
+        buildings.indexType = GL_UNSIGNED_SHORT;
+        buildings.instanceCount = static_cast<GLsizei>(_visibleBuildings.size());
+        buildings.setup = [this, &viewMtx, &projMtx] {
+            _buildingShaderProgram->setProgramUniform(_buildingShaderUniformLocations.viewProjMatrix, projMtx * viewMtx);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_BUFFER, _buildingDataTexture);
+            glActiveTexture(GL_TEXTURE0);
+        };
+        _renderQueue.submit(std::move(buildings));
     }
+    flushPass(PROFILE_BUILDINGS);
     //// END DRAWING THE BUILDINGS ////
 
     //// BEGIN DRAWING THE MODEL ////
-    _textureShaderProgram->useProgram();
-    CSCI441::setVertexAttributeLocations(_textureShaderAttributeLocations.vPos,
-//                                         _textureShaderAttributeLocations.vNormal,
-                                         _textureShaderAttributeLocations.vTexCoord);
+    RenderQueue::Item model;
+    model.program = _skinnedShaderProgram->getShaderProgramHandle();
+    // the MD5 model binds its own VAO, textures, and joint palette
+    model.draw = [this, &viewMtx, &projMtx] {
+        _pCaedilas->draw( viewMtx, projMtx );
+    };
+    if( frustum.isVisible( BoundingSphere{_pCaedilas->getPosition(), MODEL_CULL_RADIUS} ) ) {
+        _renderQueue.submit(std::move(model));
+    }
 
-    _pCaedilas->drawCaedilas( viewMtx, projMtx );
-    
+    // the crowd is spread over every street, only the copies in view are sent
+    if( _hasCrowd ) {
+        frustum.cullSpheres( _crowdBounds, _visibleCrowd );
+    }
+    if( _hasCrowd && !_visibleCrowd.empty() ) {
+        _pCaedilas->getModel()->setVisibleCrowd( _visibleCrowd );
+
+        RenderQueue::Item crowd;
+        crowd.program = _crowdShaderProgram->getShaderProgramHandle();
+        // every copy is animated from the baked palettes by its own clip time, no per-copy work here
+        crowd.setup = [this, &viewMtx, &projMtx] {
+            const SkinnedMD5* crowdModel = _pCaedilas->getModel();
+            const glm::mat4 modelMtx = Caedilas::getModelSpaceMatrix();
+            _crowdShaderProgram->setProgramUniform(_crowdShaderUniformLocations.viewProjMatrix, projMtx * viewMtx);
+            _crowdShaderProgram->setProgramUniform(_crowdShaderUniformLocations.modelMatrix, modelMtx);
+            _crowdShaderProgram->setProgramUniform(_crowdShaderUniformLocations.normalMatrix, glm::mat3(glm::transpose(glm::inverse(modelMtx))));
+            _crowdShaderProgram->setProgramUniform(_crowdShaderUniformLocations.crowdTime, _currTime);
+            _crowdShaderProgram->setProgramUniform(_crowdShaderUniformLocations.frameRate, crowdModel->getFrameRate());
+            _crowdShaderProgram->setProgramUniform(_crowdShaderUniformLocations.numFrames, static_cast<GLint>(crowdModel->getNumBakedFrames()));
+            _crowdShaderProgram->setProgramUniform(_crowdShaderUniformLocations.numJoints, static_cast<GLint>(crowdModel->getNumJoints()));
+        };
+        // the model binds its own VAO and textures
+        crowd.draw = [this] {
+            _pCaedilas->getModel()->drawCrowd(1);
+        };
+        _renderQueue.submit(std::move(crowd));
+    }
+    flushPass(PROFILE_MODEL);
     //// END DRAWING THE MODEL ////
+
+    // issue everything sorted by program and VAO
+    _renderQueue.flush();
 }
 
 void A3Engine::_updateScene() {
@@ -390,50 +707,42 @@ void A3Engine::_updateScene() {
     if (_pCaedilas != nullptr) {
       _pCaedilas->animate(_currTime - _lastTime);
     }
-    _lastTime = _currTime;
-
-    //_pSecondaryCam->setPhi(glm::pi<float>() / 1.0f);
-    
-    // turn right
+    // Caedilas walks and turns while the keys are held, at a rate so it is the same at any frame rate
+    GLfloat speed = 0.0f;
+    GLfloat turnRate = 0.0f;
+    if( _keys[GLFW_KEY_W] || _keys[GLFW_KEY_UP] ) {
+        speed += _playerSpeed.x;
+    }
+    if( _keys[GLFW_KEY_S] || _keys[GLFW_KEY_DOWN] ) {
+        speed -= _playerSpeed.x;
+    }
     if( _keys[GLFW_KEY_D] || _keys[GLFW_KEY_RIGHT] ) {
-        _pCaedilas->rotate(_cameraSpeed.y, 0.0f);
-        _pSecondaryCam->setTheta(_pCaedilas->getTheta() + glm::radians(-90.0f));
-        _pSecondaryCam->recomputeOrientation();
+        turnRate += _playerSpeed.y;
     }
-    // turn left
     if( _keys[GLFW_KEY_A] || _keys[GLFW_KEY_LEFT] ) {
-        _pCaedilas->rotate(-_cameraSpeed.y, 0.0f);
-        _pSecondaryCam->setTheta(_pCaedilas->getTheta() + glm::radians(-90.0f));
-        _pSecondaryCam->recomputeOrientation();
+        turnRate -= _playerSpeed.y;
     }
-    
-    
-    // move Caedilas, then move camera to match
-    // move forward
-    if( _keys[GLFW_KEY_W] || _keys[GLFW_KEY_UP] ) {
-      _pCaedilas->moveForward(_playerSpeed.x);
-      _pMainCam->setLookAtPoint(_pCaedilas->getLocation() + 1.0f);
-      _pMainCam->recomputeOrientation();
+    _pCaedilas->setSpeed(speed);
+    _pCaedilas->setTurnRate(turnRate);
 
-      _pSecondaryCam->setLookAtPoint(_pCaedilas->getLocation() + 1.0f);
-      _pSecondaryCam->recomputeOrientation();
-    }
-    // move forward
-    if( _keys[GLFW_KEY_S] || _keys[GLFW_KEY_DOWN] ) {
-      _pCaedilas->moveBackward(_playerSpeed.x);
-      _pMainCam->setLookAtPoint(_pCaedilas->getLocation() + 1.0f);
-      _pMainCam->recomputeOrientation();
+    // every player entity with a speed or turn rate moves in one pass
+    Player::getEntityStore().update( _currTime - _lastTime );
+    _lastTime = _currTime;
 
-      _pSecondaryCam->setLookAtPoint(_pCaedilas->getLocation() + 1.0f);
-      _pSecondaryCam->recomputeOrientation();
-    }
+    // then the cameras follow Caedilas
+    _pMainCam->setLookAtPoint(_pCaedilas->getPosition() + 1.0f);
+    _pMainCam->recomputeOrientation();
+
+    _pSecondaryCam->setTheta(_pCaedilas->getTheta() + glm::radians(-90.0f));
+    _pSecondaryCam->setLookAtPoint(_pCaedilas->getPosition() + 1.0f);
+    _pSecondaryCam->recomputeOrientation();
 
   // rotate light direction by direction character is facing
   glm::mat4 r = glm::rotate(glm::mat4(1.0f), -_pCaedilas->getTheta(), CSCI441::Y_AXIS);
   glm::vec3 lightDirectionRotated = r * glm::vec4(-1,-1,-1,0);
   glProgramUniform3fv(
-      _textureShaderProgram->getShaderProgramHandle(),
-      _textureShaderUniformLocations.lightDirection,
+      _skinnedShaderProgram->getShaderProgramHandle(),
+      _skinnedShaderUniformLocations.lightDirection,
       1,
       glm::value_ptr(lightDirectionRotated)
       );
@@ -441,10 +750,17 @@ void A3Engine::_updateScene() {
 }
 
 void A3Engine::run() {
+    if( _benchmark.enabled ) {
+        _runBenchmark();
+        return;
+    }
+
     //  This is our draw loop - all rendering is done here.  We use a loop to keep the window open
     //	until the user decides to close the window and quit the program.  Without a loop, the
     //	window will display once and then the program exits.
     while( !glfwWindowShouldClose(mpWindow) ) {	        // check if the window was instructed to be closed
+        _profiler->beginFrame();                         // collect the GPU timings that finished since the last frame
+        _profiler->beginSection(PROFILE_FRAME);
         glDrawBuffer( GL_BACK );				        // work with our back frame buffer
         glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );	// clear the current color contents and depth buffer in the window
 
@@ -458,7 +774,7 @@ void A3Engine::run() {
         glViewport( 0, 0, framebufferWidth, framebufferHeight );
 
         // draw everything to the window
-        _renderScene(_pMainCam->getViewMatrix(), _pMainCam->getProjectionMatrix());
+        _renderScene(_pMainCam->getViewMatrix(), _pMainCam->getProjectionMatrix(), _profiler->isEnabled());
 
         // secondary viewport
         // clear out rectangle
@@ -467,8 +783,19 @@ void A3Engine::run() {
         glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );	// clear the current color contents and depth buffer in the rectangle 
         glDisable(GL_SCISSOR_TEST);
         glViewport( framebufferWidth/3 * 2, framebufferHeight / 3 * 2, framebufferWidth/3, framebufferHeight/3 );
-        _renderScene(_pSecondaryCam->getViewMatrix(), _pSecondaryCam->getProjectionMatrix());
+        _renderScene(_pSecondaryCam->getViewMatrix(), _pSecondaryCam->getProjectionMatrix(), false);
+        _profiler->beginSection(PROFILE_UPDATE);
         _updateScene();
+        _profiler->endSection(PROFILE_UPDATE);
+
+        // profiler readout over the whole window
+        if( _profiler->isEnabled() ) {
+            FrameProfiler::Scope scope(*_profiler, PROFILE_HUD);
+            glViewport( 0, 0, framebufferWidth, framebufferHeight );
+            _hudText->draw( _profiler->report(), glm::vec2(8.0f), 2.0f, glm::vec4(1.0f, 1.0f, 0.3f, 1.0f),
+                            glm::vec2(framebufferWidth, framebufferHeight) );
+        }
+        _profiler->endSection(PROFILE_FRAME);           // the swap is left out, under vsync it is mostly waiting
 
         glfwSwapBuffers(mpWindow);                       // flush the OpenGL commands and make sure they get rendered!
         glfwPollEvents();				                // check for any events and signal to redraw screen
@@ -477,6 +804,47 @@ void A3Engine::run() {
     }
 }
 
+void A3Engine::_runBenchmark() {
+    BenchmarkTarget target;
+    if( !target.create(_benchmark.width, _benchmark.height) ) {
+        return;
+    }
+    glfwSwapInterval(0);
+    BenchmarkRecorder recorder(_benchmark);
+
+    // scripted path: Caedilas walks in a circle while the main camera orbits once.  The clock is set every frame
+    // so the animation steps the same amount each frame no matter how fast it draws
+    _keys[GLFW_KEY_W] = GL_TRUE;
+    _keys[GLFW_KEY_D] = GL_TRUE;
+    glfwSetTime(0.0);
+    _lastTime = 0.0f;
+    const GLuint totalFrames = _benchmark.warmupFrames + _benchmark.frames;
+    for( GLuint frame = 0; frame < totalFrames; frame++ ) {
+        recorder.beginFrame();
+        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+
+        glfwSetTime( (frame + 1) / 60.0 );
+        _updateScene();
+        _pMainCam->setTheta( glm::pi<float>() / -3.0f + glm::two_pi<float>() * static_cast<float>(frame) / static_cast<float>(totalFrames) );
+        _pMainCam->recomputeOrientation();
+
+        // same two views as the windowed loop
+        glViewport( 0, 0, _benchmark.width, _benchmark.height );
+        _renderScene(_pMainCam->getViewMatrix(), _pMainCam->getProjectionMatrix(), false);
+        recorder.addFlush(_renderQueue.getStats());
+        glEnable(GL_SCISSOR_TEST);
+        glScissor( _benchmark.width/3 * 2, _benchmark.height / 3 * 2, _benchmark.width/3, _benchmark.height/3 );
+        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+        glDisable(GL_SCISSOR_TEST);
+        glViewport( _benchmark.width/3 * 2, _benchmark.height / 3 * 2, _benchmark.width/3, _benchmark.height/3 );
+        _renderScene(_pSecondaryCam->getViewMatrix(), _pSecondaryCam->getProjectionMatrix(), false);
+        recorder.addFlush(_renderQueue.getStats());
+
+        recorder.endFrame();
+    }
+    recorder.writeJson("A3Engine");
+}
+
 //*************************************************************************************
 //
 // Private Helper FUnctions
@@ -490,11 +858,6 @@ void A3Engine::_computeAndSendMatrixUniforms(const glm::mat4& modelMtx, const gl
     // compute and send the normal matrix
     const glm::mat3 normalMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
     _lightingShaderProgram->setProgramUniform(_lightingShaderUniformLocations.normalMatrix, normalMtx);
-
-    // send to texture shader
-    _textureShaderProgram->setProgramUniform(_textureShaderUniformLocations.mvpMatrix, mvpMtx);
-    //_textureShaderProgram->setProgramUniform(_textureShaderUniformLocations.normalMatrix, normalMtx);
-
 }
 
 //*************************************************************************************
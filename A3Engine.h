@@ -5,8 +5,13 @@
 #include <CSCI441/OpenGLEngine.hpp>
 #include <CSCI441/ShaderProgram.hpp>
 
-#include "Caedilas.h"
-#include "ArcBallCam.h"
+#include "players/Caedilas/Caedilas.h"
+#include "ArcballCam.h"
+#include "Benchmark.hpp"
+#include "FrameProfiler.hpp"
+#include "Frustum.hpp"
+#include "RenderQueue.hpp"
+#include "TextOverlay.hpp"
 
 #include <vector>
 
@@ -17,6 +22,10 @@ public:
 
     void run() override;
 
+    /// \desc switches run() to a headless benchmark
+    /// \note call before initialize() so the context is created offscreen
+    void setBenchmark(const BenchmarkSettings& settings) { _benchmark = settings; }
+
     /// \desc handle any key events inside the engine
     /// \param KEY key as represented by GLFW_KEY_ macros
     /// \param ACTION key event action as represented by GLFW_ macros
@@ -48,9 +57,34 @@ private:
     /// \desc draws everything to the scene from a particular point of view
     /// \param viewMtx the current view matrix for our camera
     /// \param projMtx the current projection matrix for our camera
-    void _renderScene(const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
+    /// \param profilePasses time the ground, buildings, and model as separate profiler sections
+    /// \note only one view per frame may be profiled, a second one would reuse the same queries
+    void _renderScene(const glm::mat4& viewMtx, const glm::mat4& projMtx, bool profilePasses) const;
     /// \desc handles moving our FreeCam as determined by keyboard input
     void _updateScene();
+    /// \desc every draw of a _renderScene() call is submitted here and issued sorted by program and VAO
+    /// \note mutable so the const _renderScene can fill it, it holds no scene state between calls
+    mutable RenderQueue _renderQueue;
+
+    /// \desc when enabled run() draws a scripted path into an offscreen framebuffer and writes frame statistics as JSON
+    BenchmarkSettings _benchmark;
+    /// \desc runs the benchmark in place of the windowed loop
+    void _runBenchmark();
+
+    /// \desc parts of a frame the profiler times, each value is its section id
+    enum ProfileSection : GLuint {
+        PROFILE_FRAME,
+        PROFILE_UPDATE,
+        PROFILE_GROUND,
+        PROFILE_BUILDINGS,
+        PROFILE_MODEL,
+        PROFILE_HUD,
+        NUM_PROFILE_SECTIONS
+    };
+    /// \desc times each ProfileSection, toggled with P
+    FrameProfiler* _profiler;
+    /// \desc draws the profiler readout over the scene
+    TextOverlay* _hudText;
 
     /// \desc tracks the number of different keys that can be present as determined by GLFW
     static constexpr GLuint NUM_KEYS = GLFW_KEY_LAST;
@@ -72,9 +106,21 @@ private:
 
     /// \desc Caedilas model
     Caedilas* _pCaedilas;
-    /// \desc Caedilas's move and turn speed
+    /// \desc Caedilas's move speed (x, units per second) and turn rate (y, radians per second)
     glm::vec2 _playerSpeed;
 
+    /// \desc background copies of Caedilas walking in place along the streets
+    static constexpr GLuint NUM_CROWD = 300;
+    /// \desc set once Caedilas's clip is baked and the crowd instances are placed
+    GLboolean _hasCrowd;
+    /// \desc sphere around each crowd copy, same order as the instances given to SkinnedMD5::setCrowd()
+    BoundingSphereList _crowdBounds;
+    /// \desc indices of the crowd copies that passed the view test of the current _renderScene() call
+    /// \note mutable for the same reason as _visibleBuildings
+    mutable std::vector<GLuint> _visibleCrowd;
+    /// \desc bakes Caedilas's clip and scatters the crowd along the streets between the buildings
+    void _createCrowd();
+
     /// \desc the size of the world (controls the ground size and locations of buildings)
     static constexpr GLfloat WORLD_SIZE = 55.0f;
     /// \desc VAO for our ground
@@ -94,8 +140,33 @@ private:
     };
     /// \desc information list of all the buildings to draw
     std::vector<BuildingData> _buildings;
-
-    /// \desc generates building information to make up our scene
+    /// \desc RGBA32F texels per building in the building data buffer: the 4 model matrix columns, then (color, unused).
+    /// Must match TEXELS_PER_BUILDING in A3BuildingShader
+    static constexpr GLuint TEXELS_PER_BUILDING = 5;
+    /// \desc unit cube every building is an instance of, with the visible building indices as its instance attribute
+    GLuint _buildingVAO;
+    GLuint _buildingVBO;
+    GLuint _buildingIBO;
+    GLsizei _numBuildingIndices;
+    /// \desc _buildings packed as TEXELS_PER_BUILDING texels each, written once by _generateEnvironment()
+    GLuint _buildingDataBuffer;
+    GLuint _buildingDataTexture;
+    /// \desc per-instance building indices, refilled with _visibleBuildings by every _renderScene() call
+    GLuint _visibleBuildingBuffer;
+    /// \desc indices the visible building buffer has storage for
+    /// \note mutable so the const _renderScene can grow it
+    mutable GLuint _visibleBuildingCapacity;
+    /// \desc sphere around each building in world space, same order as _buildings
+    BoundingSphereList _buildingBounds;
+    /// \desc indices of the buildings that passed the view test of the current _renderScene() call
+    /// \note mutable so the const _renderScene can fill it, it is only reused to avoid allocating every frame
+    mutable std::vector<GLuint> _visibleBuildings;
+    /// \desc radius of a sphere around Caedilas at any pose, centered on its location
+    static constexpr GLfloat MODEL_CULL_RADIUS = 10.0f;
+
+    /// \desc creates the building cube VAO and the building data texture buffer
+    void _createBuildingBuffers();
+    /// \desc generates building information to make up our scene and packs it into the building data buffer
     void _generateEnvironment();
 
     /// \desc shader program that performs lighting
@@ -130,25 +201,77 @@ private:
     /// \param projMtx camera projection matrix
     void _computeAndSendMatrixUniforms(const glm::mat4& modelMtx, const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
 
-    // texture shaders
-    /// \desc shader program that performs texturing
-    CSCI441::ShaderProgram* _textureShaderProgram;
+    /// \desc shader program that draws every visible building in one instanced call
+    CSCI441::ShaderProgram* _buildingShaderProgram;
+    /// \desc stores the locations of all of our shader uniforms
+    struct BuildingShaderUniformLocations {
+        GLint viewProjMatrix;
+        GLint lightDirection;
+        GLint lightColor;
+        GLint buildingData;
+
+    } _buildingShaderUniformLocations;
+    /// \desc stores the locations of all of our shader attributes
+    struct BuildingShaderAttributeLocations {
+        GLint vPos;
+        GLint vNormal;
+        /// \desc per-instance index into the building data
+        GLint buildingIndex;
+
+    } _buildingShaderAttributeLocations;
+
+    /// \desc shader program that draws the whole crowd in one instanced call from the baked palettes
+    CSCI441::ShaderProgram* _crowdShaderProgram;
     /// \desc stores the locations of all of our shader uniforms
-    struct TextureShaderUniformLocations {
+    struct CrowdShaderUniformLocations {
+        GLint viewProjMatrix;
+        GLint modelMatrix;
+        GLint normalMatrix;
+        GLint lightDirection;
+        GLint lightColor;
+        GLint crowdTime;
+        GLint frameRate;
+        GLint numFrames;
+        GLint numJoints;
+        GLint bakedPalettes;
+        GLint texMap;
+
+    } _crowdShaderUniformLocations;
+    /// \desc stores the locations of all of our shader attributes
+    struct CrowdShaderAttributeLocations {
+        GLint vPos;
+        GLint vNormal;
+        GLint vTexCoord;
+        GLint vJointIndices;
+        GLint vJointWeights;
+        /// \desc per-instance position and heading, and clip time offset
+        GLint instancePlacement;
+        GLint instanceTimeOffset;
+
+    } _crowdShaderAttributeLocations;
+
+    /// \desc shader program that draws Caedilas skinned from its joint palette
+    CSCI441::ShaderProgram* _skinnedShaderProgram;
+    /// \desc stores the locations of all of our shader uniforms
+    struct SkinnedShaderUniformLocations {
         /// \desc precomputed MVP matrix location
         GLint mvpMatrix;
+        GLint normalMatrix;
         GLint texMap;
         GLint lightDirection;
         GLint lightColor;
 
-    } _textureShaderUniformLocations;
+    } _skinnedShaderUniformLocations;
     /// \desc stores the locations of all of our shader attributes
-    struct TextureShaderAttributeLocations {
+    struct SkinnedShaderAttributeLocations {
         /// \desc vertex position location
         GLint vPos;
+        GLint vNormal;
         GLint vTexCoord;
+        GLint vJointIndices;
+        GLint vJointWeights;
 
-    } _textureShaderAttributeLocations;
+    } _skinnedShaderAttributeLocations;
 
     // track animation frames
     GLfloat _lastTime;
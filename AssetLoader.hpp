@@ -0,0 +1,151 @@
+/**
+ * @file AssetLoader.hpp
+ * @brief Worker thread pool for asset parsing with a queue of GL uploads for the main thread
+ */
+
+#ifndef ASSET_LOADER_HPP
+#define ASSET_LOADER_HPP
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// \desc the slow CPU side of loading (file reads, parsing, image decoding) runs on worker threads.
+/// Each job returns the GL side as a function which is queued until the thread owning the GL context
+/// runs it in processUploads() or finish(), so no GL call ever happens on a worker.
+class AssetLoader {
+  public:
+    /// \desc GL work to run on the main thread once a job's CPU work is done (may be empty)
+    using Upload = std::function<void()>;
+    /// \desc CPU work to run on a worker, returns the matching GL work
+    using Job = std::function<Upload()>;
+
+    /// \param numThreads worker count, defaults to one per hardware thread
+    explicit AssetLoader(unsigned int numThreads = std::thread::hardware_concurrency());
+    ~AssetLoader();
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    /// \desc queues a job for the workers, safe to call from inside another job
+    void submit(Job job);
+
+    /// \desc runs every upload that is ready without waiting for the rest, call from the GL thread
+    /// \return number of uploads that ran
+    GLuint processUploads();
+
+    /// \desc blocks until every submitted job (including ones they submit) has finished and its upload ran,
+    /// call from the GL thread
+    void finish();
+
+  private:
+    std::vector<std::thread> _workers;
+    std::deque<Job> _jobs;
+    std::deque<Upload> _uploads;
+    /// \desc jobs submitted whose upload has not been queued yet
+    GLuint _pendingJobs;
+    bool _stopping;
+
+    std::mutex _mutex;
+    /// \desc wakes workers when a job is queued or the loader stops
+    std::condition_variable _jobReady;
+    /// \desc wakes finish() when an upload is queued
+    std::condition_variable _uploadReady;
+
+    void _workerLoop();
+};
+
+inline AssetLoader::AssetLoader(const unsigned int numThreads) :
+  _pendingJobs(0),
+  _stopping(false) {
+  // hardware_concurrency() may report 0 when it can't tell
+  const unsigned int count = std::max(numThreads, 1u);
+  for (unsigned int i = 0; i < count; i++) {
+    _workers.emplace_back(&AssetLoader::_workerLoop, this);
+  }
+}
+
+inline AssetLoader::~AssetLoader() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _jobReady.notify_all();
+  for (std::thread& worker : _workers) {
+    worker.join();
+  }
+}
+
+inline void AssetLoader::submit(Job job) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _jobs.push_back(std::move(job));
+    _pendingJobs++;
+  }
+  _jobReady.notify_one();
+}
+
+inline GLuint AssetLoader::processUploads() {
+  std::deque<Upload> ready;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ready.swap(_uploads);
+  }
+  for (Upload& upload : ready) {
+    if (upload) upload();
+  }
+  return static_cast<GLuint>(ready.size());
+}
+
+inline void AssetLoader::finish() {
+  while (true) {
+    std::deque<Upload> ready;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _uploadReady.wait(lock, [this] { return !_uploads.empty() || _pendingJobs == 0; });
+      if (_uploads.empty()) return;
+      ready.swap(_uploads);
+    }
+    for (Upload& upload : ready) {
+      if (upload) upload();
+    }
+  }
+}
+
+inline void AssetLoader::_workerLoop() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _jobReady.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+      if (_jobs.empty()) return;
+      job = std::move(_jobs.front());
+      _jobs.pop_front();
+    }
+    // a job that throws (a malformed asset, running out of memory) loses only its own upload, an exception
+    // escaping a worker would terminate the program
+    Upload upload;
+    try {
+      upload = job();
+    } catch (const std::exception& e) {
+      fprintf(stderr, "[ERROR]: asset loading job failed: %s\n", e.what());
+    } catch (...) {
+      fprintf(stderr, "[ERROR]: asset loading job failed\n");
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _uploads.push_back(std::move(upload));
+      _pendingJobs--;
+    }
+    _uploadReady.notify_all();
+  }
+}
+
+#endif // ASSET_LOADER_HPP
@@ -0,0 +1,259 @@
+/**
+ * @file Benchmark.hpp
+ * @brief Headless benchmark runs: surfaceless context, offscreen framebuffer, and JSON frame statistics
+ */
+
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/// \desc how a benchmark run is set up, filled from the command line by parse()
+struct BenchmarkSettings {
+  /// \desc false runs the normal windowed loop
+  bool enabled = false;
+  /// \desc frames that are measured
+  GLuint frames = 600;
+  /// \desc frames drawn first and thrown away (shader compiles, driver caches, first uploads)
+  GLuint warmupFrames = 60;
+  /// \desc size of the offscreen framebuffer
+  GLint width = 1280;
+  GLint height = 720;
+  /// \desc where the JSON goes, empty writes it to stdout
+  std::string outputPath;
+  /// \desc true creates the context through EGL, false through OSMesa (both work on Mesa llvmpipe with no display)
+  bool useEGL = false;
+  /// \desc replaces the time-based random seed so every run builds the same scene
+  static constexpr unsigned int SEED = 441;
+
+  /// \desc reads --benchmark [--frames N] [--warmup N] [--size WxH] [--output FILE] [--context osmesa|egl],
+  /// skips --vertex-format and its value, anything else is reported and ignored
+  static BenchmarkSettings parse(int argc, char* argv[]);
+};
+
+/// \desc sets the GLFW hints for a headless context, call before the engine creates its window.
+/// Needs GLFW 3.4 for the null platform (no display connection at all), older versions still get an invisible
+/// window with the requested context API but need a display
+inline void setHeadlessContextHints(const BenchmarkSettings& settings) {
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+  glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+  // window hints need an initialized library, the engine's own glfwInit() afterwards is then a no-op
+  if (!glfwInit()) {
+    fprintf(stderr, "[ERROR]: Could not initialize GLFW for a headless context\n");
+    return;
+  }
+  glfwWindowHint(GLFW_CONTEXT_CREATION_API, settings.useEGL ? GLFW_EGL_CONTEXT_API : GLFW_OSMESA_CONTEXT_API);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+}
+
+/// \desc framebuffer object with a color and a depth renderbuffer, the benchmark draws into it instead of a window
+class BenchmarkTarget {
+  public:
+    BenchmarkTarget() : _fbo(0), _colorRBO(0), _depthRBO(0) {}
+    ~BenchmarkTarget() {
+      glDeleteFramebuffers(1, &_fbo);
+      glDeleteRenderbuffers(1, &_colorRBO);
+      glDeleteRenderbuffers(1, &_depthRBO);
+    }
+    BenchmarkTarget(const BenchmarkTarget&) = delete;
+    BenchmarkTarget& operator=(const BenchmarkTarget&) = delete;
+
+    /// \desc creates the framebuffer, binds it, and sets the viewport to cover it
+    /// \return false if the framebuffer is incomplete
+    bool create(GLint width, GLint height);
+
+  private:
+    GLuint _fbo;
+    GLuint _colorRBO;
+    GLuint _depthRBO;
+};
+
+inline bool BenchmarkTarget::create(const GLint width, const GLint height) {
+  glGenRenderbuffers(1, &_colorRBO);
+  glBindRenderbuffer(GL_RENDERBUFFER, _colorRBO);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glGenRenderbuffers(1, &_depthRBO);
+  glBindRenderbuffer(GL_RENDERBUFFER, _depthRBO);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &_fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colorRBO);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthRBO);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    fprintf(stderr, "[ERROR]: Benchmark framebuffer is incomplete\n");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return false;
+  }
+  glViewport(0, 0, width, height);
+  return true;
+}
+
+/// \desc times every frame (including the GPU, the frame ends with glFinish) and counts its draws, then writes
+/// min/median/p99 of both as JSON
+class BenchmarkRecorder {
+  public:
+    explicit BenchmarkRecorder(const BenchmarkSettings& settings);
+
+    void beginFrame();
+    /// \desc adds one RenderQueue::flush() to the current frame, call after every flush
+    void addFlush(const RenderQueue::Stats& stats);
+    /// \desc waits for the GPU to finish the frame and records it, warmup frames are dropped
+    void endFrame();
+    /// \desc every measured frame has been recorded
+    bool isDone() const { return _frameTimes.size() >= _settings.frames; }
+
+    /// \desc writes the statistics to the output path (or stdout)
+    /// \return false if the output file could not be opened
+    bool writeJson(const char* engineName) const;
+
+  private:
+    const BenchmarkSettings _settings;
+    GLuint _framesBegun;
+    std::chrono::steady_clock::time_point _frameStart;
+    RenderQueue::Stats _frameStats;
+    std::vector<float> _frameTimes;
+    std::vector<RenderQueue::Stats> _stats;
+
+    /// \desc nearest-rank percentile of sorted values
+    template<typename T>
+    static T _percentile(const std::vector<T>& sorted, GLuint percent) {
+      return sorted[std::min(sorted.size() - 1, sorted.size() * percent / 100)];
+    }
+    static void _writeDistribution(FILE* out, const char* name, std::vector<float> values, bool last);
+};
+
+inline BenchmarkSettings BenchmarkSettings::parse(const int argc, char* argv[]) {
+  BenchmarkSettings settings;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if (strcmp(arg, "--benchmark") == 0) {
+      settings.enabled = true;
+    } else if (strcmp(arg, "--frames") == 0 && hasValue) {
+      settings.frames = static_cast<GLuint>(std::max(1, atoi(argv[++i])));
+    } else if (strcmp(arg, "--warmup") == 0 && hasValue) {
+      settings.warmupFrames = static_cast<GLuint>(std::max(0, atoi(argv[++i])));
+    } else if (strcmp(arg, "--size") == 0 && hasValue) {
+      int width = 0, height = 0;
+      if (sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+        settings.width = width;
+        settings.height = height;
+      } else {
+        fprintf(stderr, "[WARN]: --size expects WIDTHxHEIGHT, keeping %dx%d\n", settings.width, settings.height);
+      }
+    } else if (strcmp(arg, "--output") == 0 && hasValue) {
+      settings.outputPath = argv[++i];
+    } else if (strcmp(arg, "--context") == 0 && hasValue) {
+      const char* context = argv[++i];
+      if (strcmp(context, "egl") == 0) {
+        settings.useEGL = true;
+      } else if (strcmp(context, "osmesa") == 0) {
+        settings.useEGL = false;
+      } else {
+        fprintf(stderr, "[WARN]: unknown --context %s, expected osmesa or egl, keeping %s\n", context,
+                settings.useEGL ? "egl" : "osmesa");
+      }
+    } else if ((strcmp(arg, "--vertex-format") == 0 || strcmp(arg, "--engine") == 0) && hasValue) {
+      // VertexFormat::parse and main() read these from the same command line
+      i++;
+    } else {
+      fprintf(stderr, "[WARN]: Ignoring unknown argument \"%s\"\n", arg);
+    }
+  }
+  return settings;
+}
+
+inline BenchmarkRecorder::BenchmarkRecorder(const BenchmarkSettings& settings) :
+  _settings(settings),
+  _framesBegun(0),
+  _frameStats({0, 0, 0, 0, 0, 0}) {
+  _frameTimes.reserve(settings.frames);
+  _stats.reserve(settings.frames);
+}
+
+inline void BenchmarkRecorder::beginFrame() {
+  _framesBegun++;
+  _frameStats = {0, 0, 0, 0, 0, 0};
+  _frameStart = std::chrono::steady_clock::now();
+}
+
+inline void BenchmarkRecorder::addFlush(const RenderQueue::Stats& stats) {
+  _frameStats.draws += stats.draws;
+  _frameStats.programChanges += stats.programChanges;
+  _frameStats.textureChanges += stats.textureChanges;
+  _frameStats.vaoChanges += stats.vaoChanges;
+  _frameStats.materialChanges += stats.materialChanges;
+  _frameStats.objectChanges += stats.objectChanges;
+}
+
+inline void BenchmarkRecorder::endFrame() {
+  // nothing is presented so without this the CPU would just run ahead of the GPU
+  glFinish();
+  const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - _frameStart;
+  if (_framesBegun <= _settings.warmupFrames) return;
+  _frameTimes.push_back(elapsed.count());
+  _stats.push_back(_frameStats);
+}
+
+inline void BenchmarkRecorder::_writeDistribution(FILE* out, const char* name, std::vector<float> values, const bool last) {
+  std::sort(values.begin(), values.end());
+  float sum = 0.0f;
+  for (const float value : values) sum += value;
+  fprintf(out, "  \"%s\": {\"min\": %.4f, \"median\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"average\": %.4f}%s\n",
+          name, values.front(), _percentile(values, 50), _percentile(values, 99), values.back(),
+          sum / static_cast<float>(values.size()), last ? "" : ",");
+}
+
+inline bool BenchmarkRecorder::writeJson(const char* engineName) const {
+  if (_frameTimes.empty()) {
+    fprintf(stderr, "[ERROR]: Benchmark recorded no frames\n");
+    return false;
+  }
+  FILE* out = stdout;
+  if (!_settings.outputPath.empty()) {
+    out = fopen(_settings.outputPath.c_str(), "w");
+    if (!out) {
+      fprintf(stderr, "[ERROR]: Could not open benchmark output \"%s\"\n", _settings.outputPath.c_str());
+      return false;
+    }
+  }
+
+  const GLubyte* renderer = glGetString(GL_RENDERER);
+  fprintf(out, "{\n");
+  fprintf(out, "  \"engine\": \"%s\",\n", engineName);
+  fprintf(out, "  \"renderer\": \"%s\",\n", renderer ? reinterpret_cast<const char*>(renderer) : "unknown");
+  fprintf(out, "  \"width\": %d,\n  \"height\": %d,\n", _settings.width, _settings.height);
+  fprintf(out, "  \"frames\": %zu,\n  \"warmupFrames\": %u,\n", _frameTimes.size(), _settings.warmupFrames);
+  _writeDistribution(out, "frameMs", _frameTimes, false);
+  std::vector<float> draws, programChanges, textureChanges, vaoChanges;
+  for (const RenderQueue::Stats& stats : _stats) {
+    draws.push_back(static_cast<float>(stats.draws));
+    programChanges.push_back(static_cast<float>(stats.programChanges));
+    textureChanges.push_back(static_cast<float>(stats.textureChanges));
+    vaoChanges.push_back(static_cast<float>(stats.vaoChanges));
+  }
+  _writeDistribution(out, "drawCalls", draws, false);
+  _writeDistribution(out, "programChanges", programChanges, false);
+  _writeDistribution(out, "textureChanges", textureChanges, false);
+  _writeDistribution(out, "vaoChanges", vaoChanges, true);
+  fprintf(out, "}\n");
+
+  if (out != stdout) fclose(out);
+  return true;
+}
+
+#endif // BENCHMARK_HPP
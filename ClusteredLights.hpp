@@ -0,0 +1,321 @@
+/**
+ * @file ClusteredLights.hpp
+ * @brief Point lights binned into view frustum clusters on the CPU for clustered forward shading
+ */
+
+#ifndef CLUSTERED_LIGHTS_HPP
+#define CLUSTERED_LIGHTS_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "Frustum.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/// \desc the view frustum is cut into CLUSTERS_X x CLUSTERS_Y screen tiles and CLUSTERS_Z depth slices (spaced
+/// exponentially so near clusters stay small). Every frame update() finds the clusters each visible light's sphere
+/// touches and uploads three texture buffers the fragment shader reads:
+///   lightData     RGBA32F, 2 texels per light: (world position, radius), (color, unused)
+///   clusterLights RG32UI, one texel per cluster: (first entry in lightIndices, number of lights)
+///   lightIndices  R32UI, the lights of every cluster one after the other
+/// plus a ClusterData uniform block with what the shader needs to find its cluster. A fragment then only loops over
+/// the few lights of its own cluster however many lights the scene has
+class ClusteredLights {
+  public:
+    static constexpr GLuint CLUSTERS_X = 16;
+    static constexpr GLuint CLUSTERS_Y = 9;
+    static constexpr GLuint CLUSTERS_Z = 24;
+    static constexpr GLuint NUM_CLUSTERS = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+    /// \desc texture units used starting at the one passed to setup(): lightData, clusterLights, lightIndices
+    static constexpr GLuint NUM_TEXTURE_UNITS = 3;
+
+    /// \desc light that falls off to nothing at radius
+    struct PointLight {
+      glm::vec3 position;
+      GLfloat radius;
+      glm::vec3 color;
+    };
+
+    ClusteredLights();
+    ~ClusteredLights();
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    /// \desc creates the buffers, needs a current GL context
+    /// \param blockBinding uniform buffer binding point of the ClusterData block
+    /// \param firstTextureUnit the texture buffers go on this unit and the next NUM_TEXTURE_UNITS - 1
+    void setup(GLuint blockBinding, GLuint firstTextureUnit);
+    /// \desc points a program's lightData/clusterLights/lightIndices samplers at the texture units
+    void setSamplerUniforms(GLuint programHandle) const;
+
+    /// \desc lights take effect at the next update()
+    void addLight(const PointLight& light);
+    void clear();
+    GLuint getNumLights() const { return _bounds.size(); }
+
+    /// \desc bins the lights inside the view volume into clusters, uploads the lists, and binds the buffers,
+    /// call once per frame before drawing
+    /// \param projMtx symmetric perspective projection (glm::perspective) with the given near and far planes
+    void update(const glm::mat4& viewMtx, const glm::mat4& projMtx, GLfloat zNear, GLfloat zFar, glm::vec2 framebufferSize);
+
+    /// \desc lights that passed the frustum test and cluster entries written by the last update()
+    GLuint getNumVisibleLights() const { return static_cast<GLuint>(_visible.size()); }
+    GLuint getNumLightIndices() const { return static_cast<GLuint>(_lightIndices.size()); }
+
+  private:
+    /// \desc ClusterData block, must match the block in the shaders (std140)
+    struct ClusterBlock {
+      glm::vec4 clusterCounts; // xyz = CLUSTERS_X/Y/Z
+      glm::vec4 depthParams;   // x = near, y = far, z = slice scale, w = slice bias (slice = log(depth) * z + w)
+      glm::vec4 screenSize;    // xy = framebuffer size in pixels
+    };
+    /// \desc one light in one cluster, sorted into lightIndices by counting
+    struct Assignment {
+      GLuint cluster;
+      GLuint light;
+    };
+
+    /// \desc light positions and radii, kept apart so the frustum test reads four at a time
+    BoundingSphereList _bounds;
+    std::vector<glm::vec3> _colors;
+    bool _lightsDirty;
+
+    /// \desc per-frame scratch, kept so a steady scene doesn't allocate
+    std::vector<GLuint> _visible;
+    std::vector<GLfloat> _viewX, _viewY, _viewZ;
+    std::vector<Assignment> _assignments;
+    std::vector<GLuint> _clusterLights;
+    std::vector<GLuint> _lightIndices;
+
+    GLuint _blockBinding;
+    GLuint _firstTextureUnit;
+    GLuint _clusterUBO;
+    /// \desc lightData, clusterLights, lightIndices
+    GLuint _buffers[NUM_TEXTURE_UNITS];
+    GLuint _textures[NUM_TEXTURE_UNITS];
+
+    /// \desc moves the visible lights into view space, four at a time where SSE2 is available
+    void _transformVisible(const glm::mat4& viewMtx);
+    /// \desc appends an Assignment for every cluster the light's sphere touches
+    void _assignLight(GLuint light, glm::vec3 viewCenter, GLfloat radius, const glm::mat4& projMtx,
+                      GLfloat zNear, GLfloat zFar, GLfloat sliceScale, GLfloat sliceBias);
+    void _uploadTextureBuffer(GLuint index, const void* data, GLsizeiptr size) const;
+};
+
+inline ClusteredLights::ClusteredLights() :
+  _lightsDirty(true),
+  _blockBinding(0),
+  _firstTextureUnit(0),
+  _clusterUBO(0),
+  _buffers{0, 0, 0},
+  _textures{0, 0, 0} {
+}
+
+inline ClusteredLights::~ClusteredLights() {
+  glDeleteBuffers(1, &_clusterUBO);
+  glDeleteTextures(NUM_TEXTURE_UNITS, _textures);
+  glDeleteBuffers(NUM_TEXTURE_UNITS, _buffers);
+}
+
+inline void ClusteredLights::setup(const GLuint blockBinding, const GLuint firstTextureUnit) {
+  _blockBinding = blockBinding;
+  _firstTextureUnit = firstTextureUnit;
+  glGenBuffers(1, &_clusterUBO);
+  glBindBuffer(GL_UNIFORM_BUFFER, _clusterUBO);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(ClusterBlock), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  const GLenum formats[NUM_TEXTURE_UNITS] = {GL_RGBA32F, GL_RG32UI, GL_R32UI};
+  glGenBuffers(NUM_TEXTURE_UNITS, _buffers);
+  glGenTextures(NUM_TEXTURE_UNITS, _textures);
+  for (GLuint i = 0; i < NUM_TEXTURE_UNITS; i++) {
+    // a buffer needs storage before a texture can be attached to it, update() replaces it
+    glBindBuffer(GL_TEXTURE_BUFFER, _buffers[i]);
+    glBufferData(GL_TEXTURE_BUFFER, 4 * sizeof(GLfloat), nullptr, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, _textures[i]);
+    glTexBuffer(GL_TEXTURE_BUFFER, formats[i], _buffers[i]);
+  }
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  _clusterLights.assign(NUM_CLUSTERS * 2, 0);
+}
+
+inline void ClusteredLights::setSamplerUniforms(const GLuint programHandle) const {
+  const char* samplerNames[NUM_TEXTURE_UNITS] = {"lightData", "clusterLights", "lightIndices"};
+  for (GLuint i = 0; i < NUM_TEXTURE_UNITS; i++) {
+    // programs that don't light anything just don't have the sampler
+    const GLint location = glGetUniformLocation(programHandle, samplerNames[i]);
+    if (location != -1) glProgramUniform1i(programHandle, location, static_cast<GLint>(_firstTextureUnit + i));
+  }
+}
+
+inline void ClusteredLights::addLight(const PointLight& light) {
+  _bounds.add({light.position, light.radius});
+  _colors.push_back(light.color);
+  _lightsDirty = true;
+}
+
+inline void ClusteredLights::clear() {
+  _bounds.clear();
+  _colors.clear();
+  _lightsDirty = true;
+}
+
+inline void ClusteredLights::_uploadTextureBuffer(const GLuint index, const void* data, const GLsizeiptr size) const {
+  glBindBuffer(GL_TEXTURE_BUFFER, _buffers[index]);
+  // fresh storage every time so the GPU never waits on last frame's lists, and never empty so the texture stays valid
+  glBufferData(GL_TEXTURE_BUFFER, std::max<GLsizeiptr>(size, 4 * sizeof(GLfloat)), nullptr, GL_STREAM_DRAW);
+  if (size > 0) glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+inline void ClusteredLights::_transformVisible(const glm::mat4& viewMtx) {
+  const GLuint count = static_cast<GLuint>(_visible.size());
+  // rounded up to a multiple of four so the last group can be loaded and stored whole
+  const GLuint padded = (count + 3) & ~3u;
+  _viewX.resize(padded);
+  _viewY.resize(padded);
+  _viewZ.resize(padded);
+  // gather the visible lights first, the transform then reads contiguous arrays
+  for (GLuint i = 0; i < padded; i++) {
+    const GLuint light = _visible[std::min(i, count - 1)];
+    _viewX[i] = _bounds.x[light];
+    _viewY[i] = _bounds.y[light];
+    _viewZ[i] = _bounds.z[light];
+  }
+#ifdef SIMD_USE_SSE2
+  for (GLuint i = 0; i < padded; i += 4) {
+    const __m128 x = _mm_loadu_ps(&_viewX[i]);
+    const __m128 y = _mm_loadu_ps(&_viewY[i]);
+    const __m128 z = _mm_loadu_ps(&_viewZ[i]);
+    __m128 out[3];
+    for (int row = 0; row < 3; row++) {
+      __m128 v = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(viewMtx[0][row])), _mm_set1_ps(viewMtx[3][row]));
+      v = _mm_add_ps(v, _mm_mul_ps(y, _mm_set1_ps(viewMtx[1][row])));
+      out[row] = _mm_add_ps(v, _mm_mul_ps(z, _mm_set1_ps(viewMtx[2][row])));
+    }
+    _mm_storeu_ps(&_viewX[i], out[0]);
+    _mm_storeu_ps(&_viewY[i], out[1]);
+    _mm_storeu_ps(&_viewZ[i], out[2]);
+  }
+#else
+  for (GLuint i = 0; i < padded; i++) {
+    const glm::vec4 view = viewMtx * glm::vec4(_viewX[i], _viewY[i], _viewZ[i], 1.0f);
+    _viewX[i] = view.x;
+    _viewY[i] = view.y;
+    _viewZ[i] = view.z;
+  }
+#endif
+}
+
+inline void ClusteredLights::_assignLight(const GLuint light, const glm::vec3 viewCenter, const GLfloat radius,
+                                          const glm::mat4& projMtx, const GLfloat zNear, const GLfloat zFar,
+                                          const GLfloat sliceScale, const GLfloat sliceBias) {
+  // view space looks down -z, depths are positive distances in front of the camera
+  const GLfloat depth = -viewCenter.z;
+  const GLfloat minDepth = std::max(depth - radius, zNear);
+  const GLfloat maxDepth = std::min(depth + radius, zFar);
+  if (minDepth > maxDepth) return;
+  const auto sliceOf = [sliceScale, sliceBias](const GLfloat d) {
+    return static_cast<GLuint>(std::min(std::max(std::log(d) * sliceScale + sliceBias, 0.0f), static_cast<GLfloat>(CLUSTERS_Z - 1)));
+  };
+  // screen tile of a normalized device coordinate
+  const auto tileOf = [](const GLfloat ndc, const GLuint tiles) {
+    return static_cast<GLuint>(std::min(std::max((ndc * 0.5f + 0.5f) * static_cast<GLfloat>(tiles), 0.0f), static_cast<GLfloat>(tiles - 1)));
+  };
+  const GLuint firstSlice = sliceOf(minDepth);
+  const GLuint lastSlice = sliceOf(maxDepth);
+  for (GLuint slice = firstSlice; slice <= lastSlice; slice++) {
+    // the part of the sphere's depth range inside this slice
+    const GLfloat sliceNear = std::max(minDepth, std::exp((static_cast<GLfloat>(slice) - sliceBias) / sliceScale));
+    const GLfloat sliceFar = std::min(maxDepth, std::exp((static_cast<GLfloat>(slice + 1) - sliceBias) / sliceScale));
+    // x / depth is monotonic in both, so the box around the sphere projects to its corners' extremes
+    const GLfloat xMin = projMtx[0][0] * std::min((viewCenter.x - radius) / sliceNear, (viewCenter.x - radius) / sliceFar);
+    const GLfloat xMax = projMtx[0][0] * std::max((viewCenter.x + radius) / sliceNear, (viewCenter.x + radius) / sliceFar);
+    const GLfloat yMin = projMtx[1][1] * std::min((viewCenter.y - radius) / sliceNear, (viewCenter.y - radius) / sliceFar);
+    const GLfloat yMax = projMtx[1][1] * std::max((viewCenter.y + radius) / sliceNear, (viewCenter.y + radius) / sliceFar);
+    if (xMin > 1.0f || xMax < -1.0f || yMin > 1.0f || yMax < -1.0f) continue;
+    const GLuint x0 = tileOf(xMin, CLUSTERS_X), x1 = tileOf(xMax, CLUSTERS_X);
+    const GLuint y0 = tileOf(yMin, CLUSTERS_Y), y1 = tileOf(yMax, CLUSTERS_Y);
+    for (GLuint y = y0; y <= y1; y++) {
+      for (GLuint x = x0; x <= x1; x++) {
+        _assignments.push_back({x + CLUSTERS_X * (y + CLUSTERS_Y * slice), light});
+      }
+    }
+  }
+}
+
+inline void ClusteredLights::update(const glm::mat4& viewMtx, const glm::mat4& projMtx, const GLfloat zNear, const GLfloat zFar,
+                                    const glm::vec2 framebufferSize) {
+  // the lights themselves only go up when they change
+  if (_lightsDirty) {
+    std::vector<glm::vec4> texels;
+    texels.reserve(_colors.size() * 2);
+    for (GLuint i = 0; i < getNumLights(); i++) {
+      texels.emplace_back(_bounds.x[i], _bounds.y[i], _bounds.z[i], _bounds.radius[i]);
+      texels.emplace_back(_colors[i], 0.0f);
+    }
+    _uploadTextureBuffer(0, texels.data(), static_cast<GLsizeiptr>(texels.size() * sizeof(glm::vec4)));
+    _lightsDirty = false;
+  }
+
+  // slice = Z * log(depth / near) / log(far / near), written as log(depth) * scale + bias for the shader
+  const GLfloat sliceScale = static_cast<GLfloat>(CLUSTERS_Z) / std::log(zFar / zNear);
+  const GLfloat sliceBias = -std::log(zNear) * sliceScale;
+
+  // lights entirely outside the view can't touch a cluster
+  const Frustum frustum(projMtx * viewMtx);
+  frustum.cullSpheres(_bounds, _visible);
+  _assignments.clear();
+  if (!_visible.empty()) {
+    _transformVisible(viewMtx);
+    for (GLuint i = 0; i < _visible.size(); i++) {
+      const GLuint light = _visible[i];
+      _assignLight(light, glm::vec3(_viewX[i], _viewY[i], _viewZ[i]), _bounds.radius[light], projMtx,
+                   zNear, zFar, sliceScale, sliceBias);
+    }
+  }
+
+  // counting sort: count per cluster, turn the counts into offsets, then drop every light into its cluster's range
+  std::fill(_clusterLights.begin(), _clusterLights.end(), 0);
+  for (const Assignment& assignment : _assignments) {
+    _clusterLights[assignment.cluster * 2 + 1]++;
+  }
+  GLuint offset = 0;
+  for (GLuint cluster = 0; cluster < NUM_CLUSTERS; cluster++) {
+    _clusterLights[cluster * 2] = offset;
+    offset += _clusterLights[cluster * 2 + 1];
+    // counted up again while filling
+    _clusterLights[cluster * 2 + 1] = 0;
+  }
+  _lightIndices.resize(_assignments.size());
+  for (const Assignment& assignment : _assignments) {
+    GLuint& count = _clusterLights[assignment.cluster * 2 + 1];
+    _lightIndices[_clusterLights[assignment.cluster * 2] + count] = assignment.light;
+    count++;
+  }
+  _uploadTextureBuffer(1, _clusterLights.data(), static_cast<GLsizeiptr>(_clusterLights.size() * sizeof(GLuint)));
+  _uploadTextureBuffer(2, _lightIndices.data(), static_cast<GLsizeiptr>(_lightIndices.size() * sizeof(GLuint)));
+
+  ClusterBlock block;
+  block.clusterCounts = glm::vec4(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z, 0.0f);
+  block.depthParams = glm::vec4(zNear, zFar, sliceScale, sliceBias);
+  block.screenSize = glm::vec4(framebufferSize, 0.0f, 0.0f);
+  glBindBuffer(GL_UNIFORM_BUFFER, _clusterUBO);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ClusterBlock), &block);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  // nothing else uses these units or the binding point, but binding every frame keeps that from being a rule
+  glBindBufferBase(GL_UNIFORM_BUFFER, _blockBinding, _clusterUBO);
+  for (GLuint i = 0; i < NUM_TEXTURE_UNITS; i++) {
+    glActiveTexture(GL_TEXTURE0 + _firstTextureUnit + i);
+    glBindTexture(GL_TEXTURE_BUFFER, _textures[i]);
+  }
+  glActiveTexture(GL_TEXTURE0);
+}
+
+#endif // CLUSTERED_LIGHTS_HPP
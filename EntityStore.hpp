@@ -0,0 +1,245 @@
+/**
+ * @file EntityStore.hpp
+ * @brief Positions, directions, and angles of moving entities kept as struct-of-arrays with batch update kernels
+ */
+
+#ifndef ENTITY_STORE_HPP
+#define ENTITY_STORE_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/// \desc every entity is a slot in a set of parallel arrays, so the per-frame kernels stream through one attribute at
+/// a time over all of them. Single entities are reached through ids that stay valid while slots are repacked.
+/// Changing theta only marks the direction stale, the trig is redone once, by whatever next needs the direction.
+/// Phi is kept for callers but does not tilt the direction, entities always move in the xz plane
+class EntityStore {
+  public:
+    using Id = GLuint;
+    /// \desc never handed out, what a handle holds when it refers to no entity
+    static constexpr Id INVALID_ENTITY = 0xFFFFFFFF;
+
+    EntityStore() = default;
+    EntityStore(const EntityStore&) = delete;
+    EntityStore& operator=(const EntityStore&) = delete;
+
+    /// \desc adds an entity facing along theta, standing still inside +/- 5 on every axis
+    Id create(const glm::vec3& position, GLfloat theta, GLfloat phi);
+    /// \desc removes an entity, the last slot moves into its place
+    void destroy(Id id);
+    GLuint size() const { return static_cast<GLuint>(_idOfSlot.size()); }
+
+    glm::vec3 getPosition(const Id id) const { const GLuint s = _slotOfId[id]; return glm::vec3(_x[s], _y[s], _z[s]); }
+    void setPosition(Id id, const glm::vec3& position);
+    /// \desc unit vector in the xz plane theta points along, recomputed here if theta changed since
+    glm::vec3 getDirection(Id id);
+    GLfloat getTheta(const Id id) const { return _theta[_slotOfId[id]]; }
+    GLfloat getPhi(const Id id) const { return _phi[_slotOfId[id]]; }
+    void setTheta(const Id id, const GLfloat theta) { const GLuint s = _slotOfId[id]; _theta[s] = theta; _stale[s] = 1; }
+    void setPhi(const Id id, const GLfloat phi) { _phi[_slotOfId[id]] = phi; }
+    /// \desc half extents of the box centered on the origin the entity is kept in
+    void setWorldEdges(Id id, const glm::vec3& edges);
+    /// \desc units per second update() moves the entity along its direction, and radians per second it turns theta
+    void setSpeed(const Id id, const GLfloat speed) { _speed[_slotOfId[id]] = speed; }
+    void setTurnRate(const Id id, const GLfloat turnRate) { _turnRate[_slotOfId[id]] = turnRate; }
+
+    /// \desc moves one entity along its direction right away and keeps it inside its world edges
+    void moveForward(Id id, GLfloat distance);
+    /// \desc turns one entity, phi kept just inside (0, pi)
+    void rotate(Id id, GLfloat dTheta, GLfloat dPhi);
+
+    /// \desc runs every kernel over every entity: turn by turn rate, refresh stale directions, move by speed, clamp
+    void update(GLfloat dTime);
+
+  private:
+    /// \desc one value per slot in every array
+    std::vector<GLfloat> _x, _y, _z;
+    /// \desc direction has no y, see the class note on phi
+    std::vector<GLfloat> _dirX, _dirZ;
+    std::vector<GLfloat> _theta, _phi;
+    std::vector<GLfloat> _speed, _turnRate;
+    std::vector<GLfloat> _edgeX, _edgeY, _edgeZ;
+    /// \desc 1 where theta changed since the direction was computed
+    std::vector<GLubyte> _stale;
+    /// \desc id of the entity in each slot and slot of each id (INVALID_ENTITY for ids not in use)
+    std::vector<Id> _idOfSlot;
+    std::vector<GLuint> _slotOfId;
+    /// \desc destroyed ids handed out again before new ones
+    std::vector<Id> _freeIds;
+
+    /// \desc the kernels update() is made of, each over slots [0, size())
+    void _turnAll(GLfloat dTime);
+    void _refreshDirections();
+    void _moveAll(GLfloat dTime);
+    void _clampAll();
+    void _refreshDirection(GLuint slot);
+    void _clampSlot(GLuint slot);
+    /// \desc every per-slot array, for adding, moving, and dropping slots in one place
+    template<typename Function> void _forEachArray(Function function);
+};
+
+template<typename Function>
+inline void EntityStore::_forEachArray(Function function) {
+  for (std::vector<GLfloat>* array : {&_x, &_y, &_z, &_dirX, &_dirZ, &_theta, &_phi, &_speed, &_turnRate, &_edgeX, &_edgeY, &_edgeZ}) {
+    function(*array);
+  }
+  function(_stale);
+}
+
+inline EntityStore::Id EntityStore::create(const glm::vec3& position, const GLfloat theta, const GLfloat phi) {
+  const GLuint slot = size();
+  Id id;
+  if (!_freeIds.empty()) {
+    id = _freeIds.back();
+    _freeIds.pop_back();
+  } else {
+    id = static_cast<Id>(_slotOfId.size());
+    _slotOfId.push_back(INVALID_ENTITY);
+  }
+  _slotOfId[id] = slot;
+  _idOfSlot.push_back(id);
+  _forEachArray([](auto& array) { array.emplace_back(); });
+  _x[slot] = position.x;
+  _y[slot] = position.y;
+  _z[slot] = position.z;
+  _dirX[slot] = 1.0f;
+  _theta[slot] = theta;
+  _phi[slot] = phi;
+  _edgeX[slot] = _edgeY[slot] = _edgeZ[slot] = 5.0f;
+  _stale[slot] = 1;
+  return id;
+}
+
+inline void EntityStore::destroy(const Id id) {
+  if (id >= _slotOfId.size() || _slotOfId[id] == INVALID_ENTITY) return;
+  const GLuint slot = _slotOfId[id];
+  const GLuint last = size() - 1;
+  // fill the hole with the last entity so the arrays stay packed for the kernels
+  if (slot != last) {
+    _forEachArray([slot, last](auto& array) { array[slot] = array[last]; });
+    _idOfSlot[slot] = _idOfSlot[last];
+    _slotOfId[_idOfSlot[slot]] = slot;
+  }
+  _forEachArray([](auto& array) { array.pop_back(); });
+  _idOfSlot.pop_back();
+  _slotOfId[id] = INVALID_ENTITY;
+  _freeIds.push_back(id);
+}
+
+inline void EntityStore::setPosition(const Id id, const glm::vec3& position) {
+  const GLuint s = _slotOfId[id];
+  _x[s] = position.x;
+  _y[s] = position.y;
+  _z[s] = position.z;
+}
+
+inline glm::vec3 EntityStore::getDirection(const Id id) {
+  const GLuint s = _slotOfId[id];
+  if (_stale[s]) _refreshDirection(s);
+  return glm::vec3(_dirX[s], 0.0f, _dirZ[s]);
+}
+
+inline void EntityStore::setWorldEdges(const Id id, const glm::vec3& edges) {
+  const GLuint s = _slotOfId[id];
+  _edgeX[s] = edges.x;
+  _edgeY[s] = edges.y;
+  _edgeZ[s] = edges.z;
+}
+
+inline void EntityStore::moveForward(const Id id, const GLfloat distance) {
+  const GLuint s = _slotOfId[id];
+  if (_stale[s]) _refreshDirection(s);
+  _x[s] += _dirX[s] * distance;
+  _z[s] += _dirZ[s] * distance;
+  _clampSlot(s);
+}
+
+inline void EntityStore::rotate(const Id id, const GLfloat dTheta, const GLfloat dPhi) {
+  const GLuint s = _slotOfId[id];
+  _theta[s] += dTheta;
+  _phi[s] = glm::clamp(_phi[s] + dPhi, 0.001f, glm::pi<float>() - 0.001f);
+  _stale[s] = 1;
+}
+
+inline void EntityStore::_refreshDirection(const GLuint slot) {
+  _dirX[slot] = std::cos(_theta[slot]);
+  _dirZ[slot] = std::sin(_theta[slot]);
+  _stale[slot] = 0;
+}
+
+inline void EntityStore::_clampSlot(const GLuint slot) {
+  _x[slot] = glm::clamp(_x[slot], -_edgeX[slot], _edgeX[slot]);
+  _y[slot] = glm::clamp(_y[slot], -_edgeY[slot], _edgeY[slot]);
+  _z[slot] = glm::clamp(_z[slot], -_edgeZ[slot], _edgeZ[slot]);
+}
+
+inline void EntityStore::update(const GLfloat dTime) {
+  _turnAll(dTime);
+  _refreshDirections();
+  _moveAll(dTime);
+  _clampAll();
+}
+
+inline void EntityStore::_turnAll(const GLfloat dTime) {
+  // the add is cheap for everyone, only the entities actually turning need new trig
+  const GLuint count = size();
+  for (GLuint i = 0; i < count; i++) {
+    _theta[i] += _turnRate[i] * dTime;
+    _stale[i] |= _turnRate[i] != 0.0f;
+  }
+}
+
+inline void EntityStore::_refreshDirections() {
+  const GLuint count = size();
+  for (GLuint i = 0; i < count; i++) {
+    if (_stale[i]) _refreshDirection(i);
+  }
+}
+
+inline void EntityStore::_moveAll(const GLfloat dTime) {
+  const GLuint count = size();
+  GLuint i = 0;
+#ifdef SIMD_USE_SSE2
+  const __m128 time = _mm_set1_ps(dTime);
+  for (; i + 4 <= count; i += 4) {
+    const __m128 distance = _mm_mul_ps(_mm_loadu_ps(&_speed[i]), time);
+    _mm_storeu_ps(&_x[i], _mm_add_ps(_mm_loadu_ps(&_x[i]), _mm_mul_ps(_mm_loadu_ps(&_dirX[i]), distance)));
+    _mm_storeu_ps(&_z[i], _mm_add_ps(_mm_loadu_ps(&_z[i]), _mm_mul_ps(_mm_loadu_ps(&_dirZ[i]), distance)));
+  }
+#endif
+  // the last count % 4 entities, or all of them on targets without SSE2
+  for (; i < count; i++) {
+    const GLfloat distance = _speed[i] * dTime;
+    _x[i] += _dirX[i] * distance;
+    _z[i] += _dirZ[i] * distance;
+  }
+}
+
+inline void EntityStore::_clampAll() {
+  const GLuint count = size();
+  GLuint i = 0;
+#ifdef SIMD_USE_SSE2
+  const __m128 zero = _mm_setzero_ps();
+  const auto clamp4 = [zero](GLfloat* values, const GLfloat* edges) {
+    const __m128 edge = _mm_loadu_ps(edges);
+    _mm_storeu_ps(values, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(values), _mm_sub_ps(zero, edge)), edge));
+  };
+  for (; i + 4 <= count; i += 4) {
+    clamp4(&_x[i], &_edgeX[i]);
+    clamp4(&_y[i], &_edgeY[i]);
+    clamp4(&_z[i], &_edgeZ[i]);
+  }
+#endif
+  for (; i < count; i++) {
+    _clampSlot(i);
+  }
+}
+
+#endif // ENTITY_STORE_HPP
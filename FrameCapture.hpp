@@ -0,0 +1,332 @@
+/**
+ * @file FrameCapture.hpp
+ * @brief Screenshots and frame recording read back through pixel buffer objects and encoded off the main thread
+ */
+
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#include <glad/gl.h>
+#include <stb_image_write.h>
+
+#include "AssetLoader.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// \desc copies finished frames into a ring of pixel buffer objects and only maps a buffer once its fence says
+/// the copy is done (normally NUM_PBOS - 1 frames later), so reading back never waits on the GPU. The pixels are
+/// then handed to worker threads: PNGs are encoded by a pool, Y4M frames go through a single writer so the stream
+/// stays in order
+class FrameCapture {
+  public:
+    /// \desc what every frame is recorded as
+    enum RecordMode {
+      RECORD_NONE,
+      /// \desc one numbered PNG per frame
+      RECORD_PNG,
+      /// \desc one raw YUV 4:4:4 stream (.y4m) that ffmpeg and most players read directly
+      RECORD_Y4M
+    };
+
+    /// \desc readbacks in flight, a frame is mapped this many frames after it was copied
+    static constexpr GLuint NUM_PBOS = 3;
+    /// \desc recorded frames waiting on the workers before new ones are dropped instead of queued
+    /// (screenshots are always kept)
+    static constexpr GLuint MAX_QUEUED_FRAMES = 16;
+    /// \desc frame rate written into the Y4M header
+    static constexpr GLuint Y4M_FRAME_RATE = 60;
+
+    FrameCapture();
+    /// \desc writes out everything still in flight, needs the GL context
+    ~FrameCapture();
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    /// \desc saves the next frame as Screenshot_<time>_<n>.png
+    void requestScreenshot();
+    /// \desc starts recording every frame as Recording_<time>..., stops a recording already running first
+    void startRecording(RecordMode mode);
+    /// \desc stops recording, the frames already captured are still written
+    void stopRecording();
+    RecordMode getRecordMode() const { return _recordMode; }
+
+    /// \desc call once the frame is drawn and before the buffers are swapped, reads from the bound read framebuffer
+    void endFrame(GLint width, GLint height);
+
+  private:
+    struct Slot {
+      GLuint pbo;
+      /// \desc signaled once the copy into pbo finished, nullptr when the slot is free
+      GLsync fence;
+      GLint width;
+      GLint height;
+      /// \desc bytes allocated for pbo
+      GLsizeiptr capacity;
+      /// \desc empty unless this frame is a screenshot
+      std::string screenshotPath;
+      /// \desc how this frame is recorded, RECORD_NONE if it isn't
+      RecordMode record;
+      GLuint recordIndex;
+    };
+    Slot _slots[NUM_PBOS];
+    /// \desc slot the next frame is copied into, always the oldest one in flight when the ring is full
+    GLuint _nextSlot;
+    /// \desc slots in flight, oldest first
+    std::deque<GLuint> _inFlight;
+
+    bool _screenshotRequested;
+    GLuint _screenshotCount;
+    RecordMode _recordMode;
+    /// \desc everything a recording writes starts with this
+    std::string _recordPrefix;
+    GLuint _recordedFrames;
+    GLuint _droppedFrames;
+    /// \desc open Y4M stream, only touched by _streamWriter once recording started
+    FILE* _stream;
+    GLint _streamWidth;
+    GLint _streamHeight;
+
+    /// \desc PNG encoding, one thread per core
+    AssetLoader* _encoders;
+    /// \desc Y4M conversion and writing, one thread so frames land in order
+    AssetLoader* _streamWriter;
+    /// \desc recorded frames handed to a worker and not written yet
+    std::atomic<GLuint> _queuedFrames;
+
+    /// \desc maps a slot, copies its pixels out, and hands them to the workers
+    /// \param wait block until the copy is done instead of giving up when it isn't
+    /// \return false if the copy is not done yet (only when not waiting)
+    bool _collect(GLuint slot, bool wait);
+    static std::vector<GLubyte> _flipToRGB(const std::vector<GLubyte>& rgba, GLint width, GLint height);
+    static std::string _timestamp();
+};
+
+inline FrameCapture::FrameCapture() :
+  _slots(),
+  _nextSlot(0),
+  _screenshotRequested(false),
+  _screenshotCount(0),
+  _recordMode(RECORD_NONE),
+  _recordedFrames(0),
+  _droppedFrames(0),
+  _stream(nullptr),
+  _streamWidth(0),
+  _streamHeight(0),
+  _encoders(new AssetLoader()),
+  _streamWriter(new AssetLoader(1)),
+  _queuedFrames(0) {
+  for (Slot& slot : _slots) {
+    glGenBuffers(1, &slot.pbo);
+    slot.fence = nullptr;
+    slot.width = slot.height = 0;
+    slot.capacity = 0;
+    slot.record = RECORD_NONE;
+    slot.recordIndex = 0;
+  }
+}
+
+inline FrameCapture::~FrameCapture() {
+  while (!_inFlight.empty()) {
+    _collect(_inFlight.front(), true);
+  }
+  stopRecording();
+  // the pools finish every queued job before their threads exit
+  delete _encoders;
+  delete _streamWriter;
+  for (Slot& slot : _slots) {
+    glDeleteBuffers(1, &slot.pbo);
+  }
+}
+
+inline void FrameCapture::requestScreenshot() {
+  _screenshotRequested = true;
+}
+
+inline void FrameCapture::startRecording(const RecordMode mode) {
+  stopRecording();
+  if (mode == RECORD_NONE) return;
+  _recordMode = mode;
+  _recordPrefix = "Recording_" + _timestamp();
+  _recordedFrames = 0;
+  _droppedFrames = 0;
+  if (mode == RECORD_Y4M) {
+    // the header needs the frame size, the first frame written opens the file
+    // (reset on the writer thread, the previous stream's frames may still be queued there)
+    _streamWriter->submit([this] {
+      _streamWidth = _streamHeight = 0;
+      return AssetLoader::Upload();
+    });
+  }
+  fprintf(stdout, "[INFO]: Recording %s\n", mode == RECORD_PNG ? (_recordPrefix + "_*.png").c_str() : (_recordPrefix + ".y4m").c_str());
+}
+
+inline void FrameCapture::stopRecording() {
+  if (_recordMode == RECORD_NONE) return;
+  // the last few frames are still being read back, hand them over before anything about the recording changes
+  while (!_inFlight.empty()) {
+    _collect(_inFlight.front(), true);
+  }
+  if (_recordMode == RECORD_Y4M) {
+    // queued behind the last frame on the single writer thread
+    _streamWriter->submit([this] {
+      if (_stream) fclose(_stream);
+      _stream = nullptr;
+      return AssetLoader::Upload();
+    });
+  }
+  fprintf(stdout, "[INFO]: Recorded %u frames (%u dropped while the encoders were behind)\n", _recordedFrames, _droppedFrames);
+  _recordMode = RECORD_NONE;
+}
+
+inline void FrameCapture::endFrame(const GLint width, const GLint height) {
+  // the workers hand back no GL work, this only empties their queue
+  _encoders->processUploads();
+  _streamWriter->processUploads();
+
+  // hand over every readback that finished, in order so recordings stay in order
+  while (!_inFlight.empty() && _collect(_inFlight.front(), false)) {}
+
+  const bool screenshot = _screenshotRequested;
+  bool record = _recordMode != RECORD_NONE;
+  if (record && _queuedFrames.load() >= MAX_QUEUED_FRAMES) {
+    // rather lose a frame of the recording than stall the frame rate waiting on the encoders
+    record = false;
+    _droppedFrames++;
+  }
+  if (!screenshot && !record) return;
+  _screenshotRequested = false;
+
+  // a full ring means the oldest readback has had NUM_PBOS - 1 frames, waiting on it now costs next to nothing
+  if (_slots[_nextSlot].fence) {
+    _collect(_inFlight.front(), true);
+  }
+  const GLuint index = _nextSlot;
+  _nextSlot = (_nextSlot + 1) % NUM_PBOS;
+  Slot& slot = _slots[index];
+  slot.width = width;
+  slot.height = height;
+  slot.screenshotPath = screenshot ? "Screenshot_" + _timestamp() + "_" + std::to_string(_screenshotCount++) + ".png" : "";
+  slot.record = record ? _recordMode : RECORD_NONE;
+  slot.recordIndex = record ? _recordedFrames++ : 0;
+  if (record) _queuedFrames++;
+
+  const GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+  if (size > slot.capacity) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    slot.capacity = size;
+  }
+  // with a pack buffer bound this only queues the copy, it returns right away
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  _inFlight.push_back(index);
+}
+
+inline bool FrameCapture::_collect(const GLuint index, const bool wait) {
+  Slot& slot = _slots[index];
+  const GLenum status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 : 0);
+  if (status == GL_TIMEOUT_EXPIRED && !wait) return false;
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+  _inFlight.pop_front();
+
+  const GLsizeiptr size = static_cast<GLsizeiptr>(slot.width) * slot.height * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+  const auto mapped = static_cast<const GLubyte*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+  if (!mapped) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fprintf(stderr, "[ERROR]: Could not map a captured frame\n");
+    if (slot.record != RECORD_NONE) _queuedFrames--;
+    return true;
+  }
+  std::vector<GLubyte> pixels(mapped, mapped + size);
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  const GLint width = slot.width, height = slot.height;
+  if (!slot.screenshotPath.empty()) {
+    _encoders->submit([pixels, width, height, path = slot.screenshotPath] {
+      const std::vector<GLubyte> rgb = _flipToRGB(pixels, width, height);
+      if (stbi_write_png(path.c_str(), width, height, 3, rgb.data(), width * 3)) {
+        fprintf(stdout, "[INFO]: Saved %s\n", path.c_str());
+      } else {
+        fprintf(stderr, "[ERROR]: Could not write %s\n", path.c_str());
+      }
+      return AssetLoader::Upload();
+    });
+  }
+  if (slot.record == RECORD_PNG) {
+    char name[32];
+    snprintf(name, sizeof(name), "_%05u.png", slot.recordIndex);
+    _encoders->submit([this, pixels = std::move(pixels), width, height, path = _recordPrefix + name] {
+      const std::vector<GLubyte> rgb = _flipToRGB(pixels, width, height);
+      if (!stbi_write_png(path.c_str(), width, height, 3, rgb.data(), width * 3)) {
+        fprintf(stderr, "[ERROR]: Could not write %s\n", path.c_str());
+      }
+      _queuedFrames--;
+      return AssetLoader::Upload();
+    });
+  } else if (slot.record == RECORD_Y4M) {
+    _streamWriter->submit([this, pixels = std::move(pixels), width, height, path = _recordPrefix + ".y4m"] {
+      if (!_stream && _streamWidth == 0) {
+        _stream = fopen(path.c_str(), "wb");
+        if (!_stream) fprintf(stderr, "[ERROR]: Could not open %s\n", path.c_str());
+        else fprintf(_stream, "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C444\n", width, height, Y4M_FRAME_RATE);
+        _streamWidth = width;
+        _streamHeight = height;
+      }
+      // a stream can't change size, frames after a resize are left out
+      if (_stream && width == _streamWidth && height == _streamHeight) {
+        // BT.601 limited range, rows flipped since GL reads bottom up
+        const size_t planeSize = static_cast<size_t>(width) * height;
+        std::vector<GLubyte> planes(planeSize * 3);
+        for (GLint y = 0; y < height; y++) {
+          const GLubyte* row = &pixels[static_cast<size_t>(height - 1 - y) * width * 4];
+          for (GLint x = 0; x < width; x++) {
+            const int r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+            const size_t i = static_cast<size_t>(y) * width + x;
+            planes[i] = static_cast<GLubyte>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            planes[planeSize + i] = static_cast<GLubyte>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            planes[planeSize * 2 + i] = static_cast<GLubyte>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+          }
+        }
+        fputs("FRAME\n", _stream);
+        fwrite(planes.data(), 1, planes.size(), _stream);
+      }
+      _queuedFrames--;
+      return AssetLoader::Upload();
+    });
+  }
+  return true;
+}
+
+inline std::vector<GLubyte> FrameCapture::_flipToRGB(const std::vector<GLubyte>& rgba, const GLint width, const GLint height) {
+  // alpha is dropped since blending leaves it at whatever the last draw wrote
+  std::vector<GLubyte> rgb(static_cast<size_t>(width) * height * 3);
+  for (GLint y = 0; y < height; y++) {
+    const GLubyte* src = &rgba[static_cast<size_t>(height - 1 - y) * width * 4];
+    GLubyte* dst = &rgb[static_cast<size_t>(y) * width * 3];
+    for (GLint x = 0; x < width; x++) {
+      dst[x * 3] = src[x * 4];
+      dst[x * 3 + 1] = src[x * 4 + 1];
+      dst[x * 3 + 2] = src[x * 4 + 2];
+    }
+  }
+  return rgb;
+}
+
+inline std::string FrameCapture::_timestamp() {
+  const std::time_t now = std::time(nullptr);
+  char text[32];
+  std::strftime(text, sizeof(text), "%Y%m%d_%H%M%S", std::localtime(&now));
+  return text;
+}
+
+#endif // FRAME_CAPTURE_HPP
@@ -0,0 +1,225 @@
+/**
+ * @file FrameProfiler.hpp
+ * @brief Per-section CPU timers and GL_TIME_ELAPSED queries with rolling statistics
+ */
+
+#ifndef FRAME_PROFILER_HPP
+#define FRAME_PROFILER_HPP
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// \desc each section of a frame (a render pass, the simulation update) gets a CPU timer and, if it issues GL work,
+/// a GL_TIME_ELAPSED query. Query results are read back once available, up to QUERY_LATENCY frames later, so the CPU
+/// only waits on the GPU when it is that many frames behind.
+/// The last HISTORY samples of every section are kept for averages and percentiles
+class FrameProfiler {
+  public:
+    /// \desc frames a query set can be in flight before its slot is reused
+    static constexpr GLuint QUERY_LATENCY = 4;
+    /// \desc samples kept per section
+    static constexpr GLuint HISTORY = 120;
+
+    /// \desc times a section for as long as it is in scope
+    class Scope {
+      public:
+        Scope(FrameProfiler& profiler, const GLuint section) : _profiler(profiler), _section(section) { _profiler.beginSection(_section); }
+        ~Scope() { _profiler.endSection(_section); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+      private:
+        FrameProfiler& _profiler;
+        GLuint _section;
+    };
+
+    /// \desc rolling statistics of one section in milliseconds
+    struct Summary {
+      std::string name;
+      bool hasGpu;
+      float cpuAverage, cpuMedian, cpuP99;
+      float gpuAverage, gpuMedian, gpuP99;
+    };
+
+    FrameProfiler();
+    ~FrameProfiler();
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    /// \desc registers a section, call before the first frame
+    /// \param timeGpu wrap the section in a GL_TIME_ELAPSED query. Only one query can be active at a time so
+    /// GPU sections must not nest, CPU-only sections may wrap anything
+    /// \return id to pass to Scope/beginSection/endSection
+    GLuint addSection(const std::string& name, bool timeGpu);
+
+    /// \desc turns collecting on or off, disabled sections cost nothing
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return _enabled; }
+
+    /// \desc call once at the start of every frame, collects the query results that are ready and waits for
+    /// the one in the slot this frame reuses if it is not
+    void beginFrame();
+
+    void beginSection(GLuint section);
+    void endSection(GLuint section);
+
+    /// \desc statistics of every section in the order they were added
+    std::vector<Summary> summarize() const;
+    /// \desc summarize() as one line per section, for the HUD or stdout
+    std::string report() const;
+
+  private:
+    struct Section {
+      std::string name;
+      bool timeGpu;
+      /// \desc one query per frame in flight
+      GLuint queries[QUERY_LATENCY];
+      /// \desc the query was issued and its result not collected yet
+      bool pending[QUERY_LATENCY];
+      std::chrono::steady_clock::time_point cpuStart;
+      std::vector<float> cpuSamples;
+      std::vector<float> gpuSamples;
+      GLuint nextCpuSample;
+      GLuint nextGpuSample;
+    };
+    std::vector<Section> _sections;
+    bool _enabled;
+    /// \desc which query slot this frame writes
+    GLuint _frame;
+
+    static void _record(std::vector<float>& samples, GLuint& next, float sample);
+    static void _collect(Section& section, GLuint slot);
+    static void _statistics(std::vector<float> samples, float& average, float& median, float& p99);
+};
+
+inline FrameProfiler::FrameProfiler() :
+  _enabled(false),
+  _frame(0) {
+}
+
+inline FrameProfiler::~FrameProfiler() {
+  for (Section& section : _sections) {
+    if (section.timeGpu) glDeleteQueries(QUERY_LATENCY, section.queries);
+  }
+}
+
+inline GLuint FrameProfiler::addSection(const std::string& name, const bool timeGpu) {
+  Section section;
+  section.name = name;
+  section.timeGpu = timeGpu;
+  std::fill(section.queries, section.queries + QUERY_LATENCY, 0);
+  std::fill(section.pending, section.pending + QUERY_LATENCY, false);
+  if (timeGpu) glGenQueries(QUERY_LATENCY, section.queries);
+  section.nextCpuSample = 0;
+  section.nextGpuSample = 0;
+  _sections.push_back(section);
+  return static_cast<GLuint>(_sections.size() - 1);
+}
+
+inline void FrameProfiler::setEnabled(const bool enabled) {
+  if (enabled == _enabled) return;
+  _enabled = enabled;
+  // start over so the numbers only cover frames the profiler was watching
+  for (Section& section : _sections) {
+    section.cpuSamples.clear();
+    section.gpuSamples.clear();
+    section.nextCpuSample = 0;
+    section.nextGpuSample = 0;
+    std::fill(section.pending, section.pending + QUERY_LATENCY, false);
+  }
+}
+
+inline void FrameProfiler::beginFrame() {
+  if (!_enabled) return;
+  _frame = (_frame + 1) % QUERY_LATENCY;
+  for (Section& section : _sections) {
+    for (GLuint slot = 0; slot < QUERY_LATENCY; slot++) {
+      if (!section.pending[slot]) continue;
+      GLint available = GL_FALSE;
+      glGetQueryObjectiv(section.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+      if (available) _collect(section, slot);
+    }
+    // the slot about to be reused is still busy, wait for it instead of dropping the slow frames from the statistics
+    if (section.pending[_frame]) _collect(section, _frame);
+  }
+}
+
+inline void FrameProfiler::_collect(Section& section, const GLuint slot) {
+  GLuint64 elapsed = 0;
+  glGetQueryObjectui64v(section.queries[slot], GL_QUERY_RESULT, &elapsed);
+  section.pending[slot] = false;
+  _record(section.gpuSamples, section.nextGpuSample, static_cast<float>(elapsed) / 1.0e6f);
+}
+
+inline void FrameProfiler::beginSection(const GLuint section) {
+  if (!_enabled) return;
+  Section& current = _sections[section];
+  current.cpuStart = std::chrono::steady_clock::now();
+  if (current.timeGpu) glBeginQuery(GL_TIME_ELAPSED, current.queries[_frame]);
+}
+
+inline void FrameProfiler::endSection(const GLuint section) {
+  if (!_enabled) return;
+  Section& current = _sections[section];
+  if (current.timeGpu) {
+    glEndQuery(GL_TIME_ELAPSED);
+    current.pending[_frame] = true;
+  }
+  const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - current.cpuStart;
+  _record(current.cpuSamples, current.nextCpuSample, elapsed.count());
+}
+
+inline void FrameProfiler::_record(std::vector<float>& samples, GLuint& next, const float sample) {
+  if (samples.size() < HISTORY) {
+    samples.push_back(sample);
+  } else {
+    samples[next] = sample;
+  }
+  next = (next + 1) % HISTORY;
+}
+
+inline void FrameProfiler::_statistics(std::vector<float> samples, float& average, float& median, float& p99) {
+  average = median = p99 = 0.0f;
+  if (samples.empty()) return;
+  float sum = 0.0f;
+  for (const float sample : samples) sum += sample;
+  average = sum / static_cast<float>(samples.size());
+  std::sort(samples.begin(), samples.end());
+  median = samples[samples.size() / 2];
+  p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+}
+
+inline std::vector<FrameProfiler::Summary> FrameProfiler::summarize() const {
+  std::vector<Summary> summaries;
+  for (const Section& section : _sections) {
+    Summary summary;
+    summary.name = section.name;
+    summary.hasGpu = section.timeGpu;
+    _statistics(section.cpuSamples, summary.cpuAverage, summary.cpuMedian, summary.cpuP99);
+    _statistics(section.gpuSamples, summary.gpuAverage, summary.gpuMedian, summary.gpuP99);
+    summaries.push_back(summary);
+  }
+  return summaries;
+}
+
+inline std::string FrameProfiler::report() const {
+  std::string text = "MS         CPU AVG  P50  P99   GPU AVG  P50  P99\n";
+  char line[128];
+  for (const Summary& summary : summarize()) {
+    if (summary.hasGpu) {
+      snprintf(line, sizeof(line), "%-10.10s %7.2f %4.2f %4.2f   %7.2f %4.2f %4.2f\n", summary.name.c_str(),
+               summary.cpuAverage, summary.cpuMedian, summary.cpuP99, summary.gpuAverage, summary.gpuMedian, summary.gpuP99);
+    } else {
+      snprintf(line, sizeof(line), "%-10.10s %7.2f %4.2f %4.2f\n", summary.name.c_str(),
+               summary.cpuAverage, summary.cpuMedian, summary.cpuP99);
+    }
+    text += line;
+  }
+  return text;
+}
+
+#endif // FRAME_PROFILER_HPP
@@ -0,0 +1,182 @@
+/**
+ * @file Frustum.hpp
+ * @brief Bounding volumes and view frustum tests for culling draws before they are submitted
+ */
+
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+/// \desc axis aligned box, starts out empty (min > max) so expanding it by the first point sets it
+struct BoundingBox {
+  glm::vec3 min = glm::vec3(FLT_MAX);
+  glm::vec3 max = glm::vec3(-FLT_MAX);
+
+  bool isEmpty() const { return min.x > max.x; }
+  void expand(const glm::vec3& point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+  glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+  glm::vec3 getExtents() const { return (max - min) * 0.5f; }
+
+  /// \desc smallest axis aligned box holding this box after the transform
+  BoundingBox transformed(const glm::mat4& mtx) const {
+    // each output axis is the transformed center plus the absolute projection of the extents onto it
+    const glm::vec3 center = glm::vec3(mtx * glm::vec4(getCenter(), 1.0f));
+    const glm::vec3 extents = getExtents();
+    const glm::vec3 newExtents = glm::abs(glm::vec3(mtx[0])) * extents.x +
+                                 glm::abs(glm::vec3(mtx[1])) * extents.y +
+                                 glm::abs(glm::vec3(mtx[2])) * extents.z;
+    BoundingBox box;
+    box.min = center - newExtents;
+    box.max = center + newExtents;
+    return box;
+  }
+};
+
+/// \desc sphere around an object, the cheapest volume to test
+struct BoundingSphere {
+  glm::vec3 center = glm::vec3(0.0f);
+  GLfloat radius = 0.0f;
+
+  /// \desc sphere through the corners of a box
+  static BoundingSphere fromBox(const BoundingBox& box) {
+    return {box.getCenter(), glm::length(box.getExtents())};
+  }
+
+  /// \desc sphere holding this sphere after the transform, grown by the largest axis scale
+  BoundingSphere transformed(const glm::mat4& mtx) const {
+    const GLfloat scale = glm::sqrt(std::max({glm::dot(glm::vec3(mtx[0]), glm::vec3(mtx[0])),
+                                              glm::dot(glm::vec3(mtx[1]), glm::vec3(mtx[1])),
+                                              glm::dot(glm::vec3(mtx[2]), glm::vec3(mtx[2]))}));
+    return {glm::vec3(mtx * glm::vec4(center, 1.0f)), radius * scale};
+  }
+
+  /// \desc share of the screen height the sphere covers under a perspective projection, 1 with the camera inside it
+  GLfloat getScreenFraction(const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
+    const GLfloat depth = -(viewMtx * glm::vec4(center, 1.0f)).z;
+    if (depth <= radius) return 1.0f;
+    // projMtx[1][1] is cot(fovy / 2), the diameter over the 2 units of NDC height
+    return std::min(radius * projMtx[1][1] / depth, 1.0f);
+  }
+};
+
+/// \desc many spheres stored as separate coordinate arrays so Frustum::cullSpheres can test four at a time
+struct BoundingSphereList {
+  std::vector<GLfloat> x, y, z, radius;
+
+  void add(const BoundingSphere& sphere) {
+    x.push_back(sphere.center.x);
+    y.push_back(sphere.center.y);
+    z.push_back(sphere.center.z);
+    radius.push_back(sphere.radius);
+  }
+  GLuint size() const { return static_cast<GLuint>(x.size()); }
+  void clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+  }
+};
+
+/// \desc the six planes of a view volume pulled out of a view-projection matrix, normals pointing inward.
+/// Tests are conservative: anything reported outside is fully outside, a few things just outside a corner
+/// are reported inside
+class Frustum {
+  public:
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& viewProjMtx);
+
+    bool isVisible(const BoundingSphere& sphere) const;
+    bool isVisible(const BoundingBox& box) const;
+
+    /// \desc tests every sphere of the list, four at a time where SSE2 is available
+    /// \param visible filled with the indices of the spheres that are at least partly inside, in order
+    /// \return number of visible spheres
+    GLuint cullSpheres(const BoundingSphereList& spheres, std::vector<GLuint>& visible) const;
+
+  private:
+    /// \desc left, right, bottom, top, near, far as (normal, distance) with unit normals
+    glm::vec4 _planes[6];
+};
+
+inline Frustum::Frustum(const glm::mat4& viewProjMtx) {
+  // Gribb/Hartmann: each plane is the last row of the matrix plus or minus one of the others (glm is column major)
+  const glm::vec4 row0(viewProjMtx[0][0], viewProjMtx[1][0], viewProjMtx[2][0], viewProjMtx[3][0]);
+  const glm::vec4 row1(viewProjMtx[0][1], viewProjMtx[1][1], viewProjMtx[2][1], viewProjMtx[3][1]);
+  const glm::vec4 row2(viewProjMtx[0][2], viewProjMtx[1][2], viewProjMtx[2][2], viewProjMtx[3][2]);
+  const glm::vec4 row3(viewProjMtx[0][3], viewProjMtx[1][3], viewProjMtx[2][3], viewProjMtx[3][3]);
+  _planes[0] = row3 + row0;
+  _planes[1] = row3 - row0;
+  _planes[2] = row3 + row1;
+  _planes[3] = row3 - row1;
+  _planes[4] = row3 + row2;
+  _planes[5] = row3 - row2;
+  // unit normals so plane distances are world distances that can be compared to radii
+  for (glm::vec4& plane : _planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+}
+
+inline bool Frustum::isVisible(const BoundingSphere& sphere) const {
+  for (const glm::vec4& plane : _planes) {
+    if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) return false;
+  }
+  return true;
+}
+
+inline bool Frustum::isVisible(const BoundingBox& box) const {
+  if (box.isEmpty()) return false;
+  for (const glm::vec4& plane : _planes) {
+    // the corner furthest along the normal, if even that one is behind the plane the whole box is
+    const glm::vec3 corner(plane.x >= 0.0f ? box.max.x : box.min.x,
+                           plane.y >= 0.0f ? box.max.y : box.min.y,
+                           plane.z >= 0.0f ? box.max.z : box.min.z);
+    if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) return false;
+  }
+  return true;
+}
+
+inline GLuint Frustum::cullSpheres(const BoundingSphereList& spheres, std::vector<GLuint>& visible) const {
+  visible.clear();
+  const GLuint count = spheres.size();
+  GLuint i = 0;
+#ifdef SIMD_USE_SSE2
+  for (; i + 4 <= count; i += 4) {
+    const __m128 x = _mm_loadu_ps(&spheres.x[i]);
+    const __m128 y = _mm_loadu_ps(&spheres.y[i]);
+    const __m128 z = _mm_loadu_ps(&spheres.z[i]);
+    const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+    // one lane per sphere, cleared once a plane has it fully behind
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (const glm::vec4& plane : _planes) {
+      __m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+      distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+      distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+    }
+    const int mask = _mm_movemask_ps(inside);
+    for (GLuint lane = 0; lane < 4; lane++) {
+      if (mask & (1 << lane)) visible.push_back(i + lane);
+    }
+  }
+#endif
+  // whatever doesn't fill a group of four (or everything without SSE2)
+  for (; i < count; i++) {
+    const BoundingSphere sphere = {glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i]};
+    if (isVisible(sphere)) visible.push_back(i);
+  }
+  return static_cast<GLuint>(visible.size());
+}
+
+#endif // FRUSTUM_HPP
@@ -0,0 +1,65 @@
+/**
+ * @file InstancingUtils.hpp
+ * @brief Shared pieces of the instanced draws: the unit cube mesh and the texture buffer size limit
+ */
+
+#ifndef INSTANCING_UTILS_HPP
+#define INSTANCING_UTILS_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/// \desc fills the bound VAO with a unit cube centered at the origin, 4 vertices per face so each face gets a flat
+/// normal, as GL_UNSIGNED_SHORT triangles
+/// \param vbo ibo receive the buffers created, the caller deletes them
+/// \return number of indices to draw
+inline GLsizei createUnitCubeBuffers(const GLint vPosLocation, const GLint vNormalLocation, GLuint& vbo, GLuint& ibo) {
+  struct Vertex {
+    glm::vec3 pos;
+    glm::vec3 normal;
+  };
+  const glm::vec3 faceNormals[6] = {
+    { 1, 0, 0}, {-1, 0, 0},
+    { 0, 1, 0}, { 0,-1, 0},
+    { 0, 0, 1}, { 0, 0,-1}
+  };
+  std::vector<Vertex> vertices;
+  std::vector<GLushort> indices;
+  for (const glm::vec3& n : faceNormals) {
+    // two tangent axes of the face to place its corners
+    const glm::vec3 u = (n.x != 0.f) ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0);
+    const glm::vec3 v = glm::cross(n, u);
+    const GLushort base = static_cast<GLushort>(vertices.size());
+    vertices.push_back({0.5f * (n - u - v), n});
+    vertices.push_back({0.5f * (n + u - v), n});
+    vertices.push_back({0.5f * (n + u + v), n});
+    vertices.push_back({0.5f * (n - u + v), n});
+    indices.insert(indices.end(), {base, GLushort(base + 1), GLushort(base + 2),
+                                   base, GLushort(base + 2), GLushort(base + 3)});
+  }
+
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(vPosLocation);
+  glVertexAttribPointer(vPosLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
+  glEnableVertexAttribArray(vNormalLocation);
+  glVertexAttribPointer(vNormalLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+  glGenBuffers(1, &ibo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+  return static_cast<GLsizei>(indices.size());
+}
+
+/// \desc texels a texture buffer can hold on this context. GL 4.1 only promises 65536, desktop drivers give far more
+inline GLuint getMaxTextureBufferTexels() {
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  return static_cast<GLuint>(std::max(maxTexels, 0));
+}
+
+#endif // INSTANCING_UTILS_HPP
@@ -7,21 +7,30 @@
 MPEngine::MPEngine() : CSCI441::OpenGLEngine(4, 1, 1800, 1200, "MP: Begin The Transformation"),
     _mousePosition({MOUSE_UNINITIALIZED, MOUSE_UNINITIALIZED}),
     _leftMouseButtonState(GLFW_RELEASE),
+    _frameCapture(nullptr),
+    _groundVisible(true),
+    _chaoVisible(true),
+    _chaoLod(0),
+    _profiler(nullptr),
+    _hudText(nullptr),
     _pArcballCam(nullptr),
-    _chaoHead(nullptr),
-    _chaoHeadBall(nullptr),
-    _chaoRArm(nullptr),
-    _chaoLArm(nullptr),
-    _chaoBody(nullptr),
-    _chaoRFoot(nullptr),
-    _chaoLFoot(nullptr),
-    _chaoTail(nullptr),
-    _chaoWings(nullptr),
+    _assetLoader(nullptr),
+    _chaoMesh(nullptr),
     _chaoMatCol(glm::vec3{1.f, 1.f, 1.f}), //make base color pure white for pure texture color when intially rendered
     _groundVAO(0),
     _numGroundPoints(0),
-    _MPShaderProgram(nullptr),
-    _MPShaderUniformLocations({-1}),
+    _proceduralGround(true),
+    _groundGridVAO(0),
+    _MPShaderVariants(nullptr),
+    _frameUBO(0),
+    _materialUBO(0),
+    _objectUBO(0),
+    _materialStride(0),
+    _objectStride(0),
+    _materialVariants(),
+    _lightDir(glm::normalize(glm::vec3(-1, -1, -1))), //normalize this before sending for double checks
+    _lightColor(glm::vec3(1, 1, 1)),
+    _MPShaderUniformLocations(),
     _MPShaderAttributeLocations({-1, -1}),
     _ballPos(glm::vec3{0.008086f, 14.54f, -0.3646f}),
     _theta(0.f),
@@ -38,9 +47,21 @@ MPEngine::MPEngine() : CSCI441::OpenGLEngine(4, 1, 1800, 1200, "MP: Begin The Tr
     _armAngle2(0.f),
     _footAngle(0.f),
     _headAngle(0.f),
-    _starPositions(),
-    _starColors(),
-    _starAngle(0.f)
+    _chaoRoot(nullptr),
+    _chaoPartNodes(),
+    _gpuAnimation(false),
+    _animTime(0.f),
+    _walkTime(0.f),
+    _lastFrameTime(0.f),
+    _simAccumulator(0.f),
+    _prevAnimState(),
+    _renderAnimState(),
+    _starField(nullptr),
+    _clusteredLights(nullptr),
+    _MPStarShaderProgram(nullptr),
+    _groundGridShaderProgram(nullptr),
+    _MPStarShaderUniformLocations({-1, -1}),
+    _MPStarShaderAttributeLocations({-1, -1, -1})
 {}
 
 MPEngine::~MPEngine() {
@@ -54,6 +75,10 @@ MPEngine::~MPEngine() {
  * ENGINE SETUP 
  */
 void MPEngine::mSetupGLFW() {
+    //a benchmark needs no display, ask for a surfaceless context before the window gets created
+    if (_benchmark.enabled) {
+        setHeadlessContextHints(_benchmark);
+    }
     CSCI441::OpenGLEngine::mSetupGLFW();
 
     //connect the engine instance to the window
@@ -75,30 +100,74 @@ void MPEngine::mSetupOpenGL() {
 }
 
 void MPEngine::mSetupShaders() {
-    //create and compile shader program
-    _MPShaderProgram = new CSCI441::ShaderProgram(
+    //create and compile the variants of the shader program the materials use, the feature order matches the MPShaderFeature bits
+    _MPShaderVariants = new ShaderVariants(
         "shaders/MPShader.v.glsl", //vertex shader path
-        "shaders/MPShader.f.glsl"
+        "shaders/MPShader.f.glsl",
+        {"USE_TEXTURE", "USE_VERTEX_COLOR", "USE_EMISSIVE"},
+        std::vector<GLuint>(std::begin(MP_SHADER_USED_VARIANTS), std::end(MP_SHADER_USED_VARIANTS))
+    );
+
+    for (const GLuint variant : MP_SHADER_USED_VARIANTS) {
+        //hook the FrameData, MaterialData, and ObjectData blocks up to their binding points
+        _bindUniformBlocks(_MPShaderVariants->getShaderProgramHandle(variant));
+        //get locations of uniforms, these are the only lookups, draws use the cached locations
+        //(a feature's uniforms are compiled out of the variants without it and come back as -1)
+        MPShaderUniformLocations& locations = _MPShaderUniformLocations[variant];
+        locations.texMap = _MPShaderVariants->getUniformLocation(variant, "texMap");
+        locations.animMode = _MPShaderVariants->getUniformLocation(variant, "animMode");
+        locations.animParams = _MPShaderVariants->getUniformLocation(variant, "animParams");
+        locations.useParts = _MPShaderVariants->getUniformLocation(variant, "useParts");
+        locations.partMtx = _MPShaderVariants->getUniformLocation(variant, "partMtx");
+        locations.partNormMtx = _MPShaderVariants->getUniformLocation(variant, "partNormMtx");
+        locations.partAnimMode = _MPShaderVariants->getUniformLocation(variant, "partAnimMode");
+        locations.partAnimParams = _MPShaderVariants->getUniformLocation(variant, "partAnimParams");
+    }
+
+    //now attributes, every variant shares the same explicit locations but only has the ones its features read,
+    //so take each from whichever built variant has it
+    auto attributeLocation = [this](const char* name) {
+        GLint location = -1;
+        for (const GLuint variant : MP_SHADER_USED_VARIANTS) {
+            location = glm::max(location, _MPShaderVariants->getAttributeLocation(variant, name));
+        }
+        return location;
+    };
+    _MPShaderAttributeLocations.vPos = attributeLocation("vPosition");
+    _MPShaderAttributeLocations.vNormal = attributeLocation("vNormal");
+    _MPShaderAttributeLocations.texCoord = attributeLocation("texCoord");
+    _MPShaderAttributeLocations.vColor = attributeLocation("vColor");
+    _MPShaderAttributeLocations.partIndex = attributeLocation("vPartIndex");
+
+    //create and compile the instanced star shader program
+    _MPStarShaderProgram = new CSCI441::ShaderProgram(
+        "shaders/MPStarShader.v.glsl",
+        "shaders/MPStarShader.f.glsl"
     );
+    //the star shader shares the FrameData block
+    _bindUniformBlocks(_MPStarShaderProgram->getShaderProgramHandle());
+    //star uniforms
+    _MPStarShaderUniformLocations.starTime = _MPStarShaderProgram->getUniformLocation("starTime");
+    _MPStarShaderUniformLocations.starData = _MPStarShaderProgram->getUniformLocation("starData");
+    //star attributes
+    _MPStarShaderAttributeLocations.vPos = _MPStarShaderProgram->getAttributeLocation("vPosition");
+    _MPStarShaderAttributeLocations.vNormal = _MPStarShaderProgram->getAttributeLocation("vNormal");
+    _MPStarShaderAttributeLocations.starIndex = _MPStarShaderProgram->getAttributeLocation("starIndex");
+    //the star data texture buffer always sits on texture unit 1
+    glProgramUniform1i(_MPStarShaderProgram->getShaderProgramHandle(), _MPStarShaderUniformLocations.starData, 1);
 
-    //get locations of uniforms and attributes
-    //start with uniforms
-    _MPShaderUniformLocations.mvpMtx = _MPShaderProgram->getUniformLocation("mvpMtx");
-    _MPShaderUniformLocations.materialColor = _MPShaderProgram->getUniformLocation("matColor");
-    _MPShaderUniformLocations.lightDir = _MPShaderProgram->getUniformLocation("lightDir");
-    _MPShaderUniformLocations.lightColor = _MPShaderProgram->getUniformLocation("lightColor");
-    _MPShaderUniformLocations.normMtx = _MPShaderProgram->getUniformLocation("normMtx");
-    _MPShaderUniformLocations.texMap = _MPShaderProgram->getUniformLocation("texMap");
-    _MPShaderUniformLocations.useTexture = _MPShaderProgram->getUniformLocation("useTexture");
-    _MPShaderUniformLocations.useVertexColor = _MPShaderProgram->getUniformLocation("useVertexColor");
-    _MPShaderUniformLocations.emissiveColor = _MPShaderProgram->getUniformLocation("emissiveColor");
-    _MPShaderUniformLocations.useEmissive = _MPShaderProgram->getUniformLocation("useEmissive");
-
-    //now attributes
-    _MPShaderAttributeLocations.vPos = _MPShaderProgram->getAttributeLocation("vPosition");
-    _MPShaderAttributeLocations.vNormal = _MPShaderProgram->getAttributeLocation("vNormal");
-    _MPShaderAttributeLocations.texCoord = _MPShaderProgram->getAttributeLocation("texCoord");
-    _MPShaderAttributeLocations.vColor = _MPShaderProgram->getAttributeLocation("vColor");
+    //create and compile the procedural ground grid shader program
+    _groundGridShaderProgram = new CSCI441::ShaderProgram(
+        "shaders/GroundGrid.v.glsl",
+        "shaders/GroundGrid.f.glsl"
+    );
+    //it reads the matrices and light from FrameData
+    _bindUniformBlocks(_groundGridShaderProgram->getShaderProgramHandle());
+    //spacing matches the line list grid and neither changes, so send them once
+    glProgramUniform1f(_groundGridShaderProgram->getShaderProgramHandle(),
+                       _groundGridShaderProgram->getUniformLocation("gridSpacing"), WORLD_SIZE / NUM_GROUND_LINES);
+    glProgramUniform1f(_groundGridShaderProgram->getShaderProgramHandle(),
+                       _groundGridShaderProgram->getUniformLocation("fadeDistance"), GROUND_FADE_DISTANCE);
 
     //setup CSCI441 objects
     CSCI441::setVertexAttributeLocations(
@@ -109,41 +178,46 @@ void MPEngine::mSetupShaders() {
 }
 
 void MPEngine::mSetupBuffers() {
-    //first create the gridlined quad
-    _createGroundBuffers();
+    //start the workers first so the chao parses while the rest of the scene is set up
+    _assetLoader = new AssetLoader();
     //now throw in my chao by loading in all the pieces
     _buildChao();
+    //create the gridlined quad
+    _createGroundBuffers();
+    //create the uniform blocks every draw reads from
+    _createUniformBuffers();
+    //pixel buffers for screenshots and recordings
+    _frameCapture = new FrameCapture();
+    //light lists for the clustered point lights, every program that shades with them reads the same texture units
+    _clusteredLights = new ClusteredLights();
+    _clusteredLights->setup(CLUSTER_BLOCK_BINDING, LIGHT_TEXTURE_UNIT);
+    for (const GLuint variant : MP_SHADER_USED_VARIANTS) {
+        _clusteredLights->setSamplerUniforms(_MPShaderVariants->getShaderProgramHandle(variant));
+    }
+    _clusteredLights->setSamplerUniforms(_groundGridShaderProgram->getShaderProgramHandle());
 }
 
 void MPEngine::mSetupScene() {
     //seed the rng for _changeChaoCol function
-    srand(time(nullptr) * 12122004);
+    srand(_benchmark.enabled ? BenchmarkSettings::SEED : time(nullptr) * 12122004); //fixed for benchmarks so every run draws the same stars
     //create an arcball camera looking at loaded in chao with radius 50
     _pArcballCam = new ArcballCam(glm::vec3(_chaoPos), 50.f);
     _pArcballCam->setTheta(glm::radians(90.0f));
     _pArcballCam->setPhi(glm::radians(70.0f));
     _pArcballCam->recomputeOrientation();    
-    //setup the shaders
-    mSetupShaders();
-    //setup the buffers
-    mSetupBuffers();
-    //setup the lights
-    //first create the variables to store teh light's direction and color
-    glm::vec3 lightDir = glm::normalize(glm::vec3(-1, -1, -1)); //normalize this before sending for double checks
-    glm::vec3 lightColor = glm::vec3(1, 1, 1);
-    //now we send over the uniform information using glProgramUniform3fv()
-    //first the lightDir uniform
-    glProgramUniform3fv(_MPShaderProgram->getShaderProgramHandle(), _MPShaderUniformLocations.lightDir, 1, glm::value_ptr(lightDir));
-    //now the lightColor uniform
-    glProgramUniform3fv(_MPShaderProgram->getShaderProgramHandle(), _MPShaderUniformLocations.lightColor, 1, glm::value_ptr(lightColor));
-    //generate 50 random stars within the world bounds
-    for (int i=0; i < 50; i++) {
-        float x = ((rand() / (float)RAND_MAX) - 0.5f) * WORLD_SIZE;
-        float y = 5.0f + ((rand() / (float)RAND_MAX) * 25.f); //random height between 5-25
-        float z = ((rand() / (float)RAND_MAX) - 0.5f) * WORLD_SIZE;
-        _starPositions.emplace_back(x, y , z);
-        _starColors.emplace_back(rand() / (float)RAND_MAX, rand() / (float)RAND_MAX, rand() / (float)RAND_MAX);
-    }
+    //link the chao parts together so their transforms are only rebuilt when they change
+    _createChaoHierarchy();
+    //the light (_lightDir/_lightColor) goes out with the FrameData block every frame
+    //scatter NUM_STARS random stars across the sky and NUM_STAR_LIGHTS lit ones low over the ground
+    _createStarField();
+    //profiler sections and the text overlay for its readout
+    _createProfiler();
+    //wait for the workers and create whatever they loaded, then they are no longer needed
+    _assetLoader->finish();
+    delete _assetLoader;
+    _assetLoader = nullptr;
+    //the chao's packed vertices are on the GPU now, tell the shader how to unpack them
+    _updateObject(OBJECT_CHAO, glm::mat4(1.0f), _chaoMesh->getVertexDecode());
 }
 
 /*
@@ -153,45 +227,62 @@ void MPEngine::mSetupScene() {
 void MPEngine::mCleanupShaders() {
     //unbind any shader program as good practice
     glUseProgram(0);
-    //now delete shader program
-    delete _MPShaderProgram;
-    _MPShaderProgram = nullptr;
+    //now delete shader programs
+    delete _MPShaderVariants;
+    _MPShaderVariants = nullptr;
+    delete _MPStarShaderProgram;
+    _MPStarShaderProgram = nullptr;
+    delete _groundGridShaderProgram;
+    _groundGridShaderProgram = nullptr;
+    //the text overlay owns its shader, atlas, and buffers
+    delete _hudText;
+    _hudText = nullptr;
 }
 
 void MPEngine::mCleanupBuffers() {
     //clean up ground VAO and VBO
     CSCI441::deleteObjectVAOs();
     CSCI441::deleteObjectVBOs();
+    //clean up the procedural grid's empty VAO
+    glDeleteVertexArrays(1, &_groundGridVAO);
+    _groundGridVAO = 0;
+    //the star field owns its cube, data, and visible index buffers
+    delete _starField;
+    _starField = nullptr;
+    //the light lists own their texture buffers and uniform block
+    delete _clusteredLights;
+    _clusteredLights = nullptr;
+    //clean up the uniform buffers
+    glDeleteBuffers(1, &_frameUBO);
+    _frameUBO = 0;
+    glDeleteBuffers(1, &_materialUBO);
+    _materialUBO = 0;
+    glDeleteBuffers(1, &_objectUBO);
+    _objectUBO = 0;
+    //finish writing any screenshot or recording still in flight, then free its pixel buffers
+    delete _frameCapture;
+    _frameCapture = nullptr;
+    //the profiler owns its timer queries
+    delete _profiler;
+    _profiler = nullptr;
+    //stop any workers still around (only if setup was cut short)
+    delete _assetLoader;
+    _assetLoader = nullptr;
     //delete models
-    delete _chaoHead;
-    _chaoHead = nullptr;
-    delete _chaoHeadBall;
-    _chaoHeadBall = nullptr;
-    delete _chaoRArm;
-    _chaoRArm = nullptr;
-    delete _chaoLArm;
-    _chaoLArm = nullptr;
-    delete _chaoBody;
-    _chaoBody = nullptr;
-    delete _chaoRFoot;
-    _chaoRFoot = nullptr;
-    delete _chaoLFoot;
-    _chaoLFoot = nullptr;
-    delete _chaoTail;
-    _chaoTail = nullptr;
-    delete _chaoWings;
-    _chaoWings = nullptr;
+    delete _chaoMesh;
+    _chaoMesh = nullptr;
 }
 
 void MPEngine::mCleanupScene() {
     //delete camera
     delete _pArcballCam;
     _pArcballCam = nullptr;
-    //clear the vectors
-    _starPositions.clear();
-    _starPositions.shrink_to_fit();
-    _starColors.clear();
-    _starColors.shrink_to_fit();
+    //delete the chao hierarchy (the root owns the part nodes)
+    delete _chaoRoot;
+    _chaoRoot = nullptr;
+    for (TransformNode*& node : _chaoPartNodes) {
+        node = nullptr;
+    }
 }
 
 /**
@@ -199,41 +290,222 @@ void MPEngine::mCleanupScene() {
  */
 
 void MPEngine::_renderScene(const glm::mat4& viewMtx, const glm::mat4& projMtx) const{
-    //draw the ground grid using the _drawGroundGrid() function
-    _drawGroundGrid(viewMtx, projMtx);
-    //draw the chao using the _drawChao() function
-    _drawChao(viewMtx, projMtx);
-    //now create the surrounding environment utilizing the class object.hpp file via  _drawEnvironment()
-    _drawEnvironment(viewMtx, projMtx);
+    if (_profiler->isEnabled()) {
+        //while profiling each pass is flushed inside its own section so its GL work lands in its own query
+        //(this gives up sorting across passes, which only costs the few binds they share)
+        {
+            FrameProfiler::Scope scope(*_profiler, PROFILE_GRID);
+            _drawGroundGrid(_renderQueue);
+            _renderQueue.flush();
+        }
+        {
+            FrameProfiler::Scope scope(*_profiler, PROFILE_CHAO);
+            _drawChao(_renderQueue);
+            _renderQueue.flush();
+        }
+        {
+            FrameProfiler::Scope scope(*_profiler, PROFILE_STARS);
+            _drawEnvironment(_renderQueue);
+            _renderQueue.flush();
+        }
+        return;
+    }
+    //submit the ground grid using the _drawGroundGrid() function
+    _drawGroundGrid(_renderQueue);
+    //submit the chao using the _drawChao() function
+    _drawChao(_renderQueue);
+    //now submit the surrounding environment via _drawEnvironment()
+    _drawEnvironment(_renderQueue);
+    //issue everything sorted so items sharing a program/texture/VAO bind it once
+    _renderQueue.flush();
+}
+
+void MPEngine::_cullScene(const glm::mat4& viewMtx, const glm::mat4& projMtx) {
+    const Frustum frustum(projMtx * viewMtx);
+    _groundVisible = frustum.isVisible(_groundBounds);
+
+    //the chao is one merged draw, so it is drawn if any of its parts is in view
+    _chaoVisible = false;
+    if (_chaoMesh && _chaoMesh->isLoaded()) {
+        BoundingBox chaoBox;
+        for (GLuint part = 0; part < NUM_CHAO_PARTS; part++) {
+            BoundingSphere bounds = _chaoMesh->getPartBounds(part).transformed(_chaoPartNodes[part]->getWorldMatrix());
+            if (_gpuAnimation) {
+                bounds.radius += GPU_ANIMATION_CULL_PADDING;
+            }
+            _chaoVisible = _chaoVisible || frustum.isVisible(bounds);
+            chaoBox.expand(bounds.center - glm::vec3(bounds.radius));
+            chaoBox.expand(bounds.center + glm::vec3(bounds.radius));
+        }
+        //coarser meshes as the whole chao shrinks on screen
+        _chaoLod = _chaoMesh->selectLod(_chaoLod, BoundingSphere::fromBox(chaoBox).getScreenFraction(viewMtx, projMtx));
+    }
+
+    //test all the stars at once, the field only sends the visible list if it changed
+    _starField->update(frustum);
 }
 
 void MPEngine::_updateScene() {
-    //animate the Chao's headball passively
-    _animateBall();
-    //update the camera position as the chao moves
-    _pArcballCam->setTarget(_chaoPos);
-    //check if _isMoving is true and if so animate the chao's body otherwise reset the body back to normal position when not moving
-    if (_isMoving) {
-        _animateBody();
+    //one fixed SIMULATION_STEP, remember where it started so frames can be drawn in between
+    _prevAnimState = _captureAnimationState();
+    //advance the animation clocks
+    _animTime += SIMULATION_STEP;
+    if (_gpuAnimation) {
+        //the vertex shader evaluates everything from the clocks, only the walk clock needs to know if we moved
+        if (_isMoving) {
+            _walkTime += SIMULATION_STEP;
+        }
+    } else {
+        //animate the Chao's headball passively
+        _animateBall();
+        //check if _isMoving is true and if so animate the chao's body otherwise reset the body back to normal position when not moving
+        if (_isMoving) {
+            _animateBody();
+        }
     }
-    //update the angle of the stars
-    _starAngle += 0.06;
 }
 
 void MPEngine::run(){
+    if (_benchmark.enabled) {
+        _runBenchmark();
+        return;
+    }
+    //start the clock here so the time spent in setup isn't simulated
+    _lastFrameTime = static_cast<float>(glfwGetTime());
     while (!glfwWindowShouldClose(mpWindow)) {
+        //collect the GPU timings that finished since the last frame, then time this one
+        //(the buffer swap is left out since under vsync it is mostly waiting)
+        _profiler->beginFrame();
+        _profiler->beginSection(PROFILE_FRAME);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        //run as many fixed steps as the real time since the last frame covers, the rest carries over
+        float currTime = static_cast<float>(glfwGetTime());
+        _simAccumulator += glm::min(currTime - _lastFrameTime, MAX_FRAME_TIME);
+        _lastFrameTime = currTime;
+        _profiler->beginSection(PROFILE_UPDATE);
+        while (_simAccumulator >= SIMULATION_STEP) {
+            //the held keys are sampled every step, so the chao walks and animates for exactly as long as they are down
+            _moveChaoFromKeys();
+            //updates for animation!
+            _updateScene();
+            _simAccumulator -= SIMULATION_STEP;
+        }
+        _profiler->endSection(PROFILE_UPDATE);
+        //draw the leftover fraction of a step between the last two states so motion is smooth at any frame rate
+        _applyAnimationState(_interpolateAnimationState(_simAccumulator / SIMULATION_STEP), false);
+        //update the camera position as the chao moves
+        _pArcballCam->setTarget(_chaoPos);
+        //bring the cached chao matrices up to date with whatever changed since the last frame
+        _chaoRoot->updateWorldMatrices();
+
         glm::mat4 viewMtx = _pArcballCam->getViewMatrix();
-        glm::mat4 projMtx = glm::perspective(glm::radians(45.0f), (float)mWindowWidth / mWindowHeight, 0.1f, 300.0f);
+        glm::mat4 projMtx = glm::perspective(glm::radians(45.0f), (float)mWindowWidth / mWindowHeight, NEAR_PLANE, FAR_PLANE);
 
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
+
+        //everything per-frame goes to the GPU once here, the draws only bind slots
+        _updateFrameData(viewMtx, projMtx);
+        //drop whatever is outside the view before anything is submitted
+        _cullScene(viewMtx, projMtx);
+        //sort the star lights into the clusters of this view
+        _assignLights(viewMtx, projMtx, glm::vec2(framebufferWidth, framebufferHeight));
         _renderScene(viewMtx, projMtx);
+        //queue up the readback of this frame if it's being captured (before the readout so that stays out of it)
+        _frameCapture->endFrame(framebufferWidth, framebufferHeight);
+        //profiler readout goes on top of everything
+        if (_profiler->isEnabled()) {
+            _drawProfilerHud();
+        }
+        _profiler->endSection(PROFILE_FRAME);
 
         glfwSwapBuffers(mpWindow);
         glfwPollEvents();
-        //updates for animation!
+    }
+}
+
+void MPEngine::_runBenchmark() {
+    BenchmarkTarget target;
+    if (!target.create(_benchmark.width, _benchmark.height)) {
+        return;
+    }
+    //nothing is presented, don't let a swap interval cap the frame rate
+    glfwSwapInterval(0);
+    BenchmarkRecorder recorder(_benchmark);
+    const glm::mat4 projMtx = glm::perspective(glm::radians(45.0f), (float)_benchmark.width / _benchmark.height, NEAR_PLANE, FAR_PLANE);
+    const GLuint totalFrames = _benchmark.warmupFrames + _benchmark.frames;
+    for (GLuint frame = 0; frame < totalFrames; frame++) {
+        recorder.beginFrame();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        //scripted path: the chao walks in a circle, stepped once per frame instead of by the clock so every run
+        //simulates the same thing no matter how fast it draws
+        _updateChaoHeading(0.5f);
+        _updateChaoPos(0.3f);
+        _isMoving = true;
         _updateScene();
+        _applyAnimationState(_captureAnimationState(), false);
+        //while the camera circles it once, bobbing up and down and zooming out and back in
+        const float t = static_cast<float>(frame) / static_cast<float>(totalFrames);
+        _pArcballCam->setTheta(glm::radians(90.0f) + glm::two_pi<float>() * t);
+        _pArcballCam->setPhi(glm::radians(70.0f) + glm::radians(15.0f) * glm::sin(glm::two_pi<float>() * 2.0f * t));
+        _pArcballCam->setRadius(50.0f + 40.0f * glm::sin(glm::pi<float>() * t));
+        _pArcballCam->setTarget(_chaoPos);
+        _chaoRoot->updateWorldMatrices();
+
+        _updateFrameData(_pArcballCam->getViewMatrix(), projMtx);
+        _cullScene(_pArcballCam->getViewMatrix(), projMtx);
+        _assignLights(_pArcballCam->getViewMatrix(), projMtx, glm::vec2(_benchmark.width, _benchmark.height));
+        _renderScene(_pArcballCam->getViewMatrix(), projMtx);
+        recorder.addFlush(_renderQueue.getStats());
+        recorder.endFrame();
     }
+    recorder.writeJson("MPEngine");
+}
+
+MPEngine::AnimationState MPEngine::_captureAnimationState() const {
+    AnimationState state;
+    state.ballPos = _ballPos;
+    state.armAngle = _armAngle;
+    state.armAngle2 = _armAngle2;
+    state.footAngle = _footAngle;
+    state.headAngle = _headAngle;
+    state.animTime = _animTime;
+    state.walkTime = _walkTime;
+    return state;
+}
+
+MPEngine::AnimationState MPEngine::_interpolateAnimationState(float alpha) const {
+    const AnimationState curr = _captureAnimationState();
+    //written as a + (b - a) * t so anything that didn't change comes out bit for bit the same
+    auto lerp = [alpha](auto a, auto b) { return a + (b - a) * alpha; };
+    AnimationState state;
+    state.ballPos = lerp(_prevAnimState.ballPos, curr.ballPos);
+    state.armAngle = lerp(_prevAnimState.armAngle, curr.armAngle);
+    state.armAngle2 = lerp(_prevAnimState.armAngle2, curr.armAngle2);
+    state.footAngle = lerp(_prevAnimState.footAngle, curr.footAngle);
+    state.headAngle = lerp(_prevAnimState.headAngle, curr.headAngle);
+    state.animTime = lerp(_prevAnimState.animTime, curr.animTime);
+    state.walkTime = lerp(_prevAnimState.walkTime, curr.walkTime);
+    return state;
+}
+
+void MPEngine::_applyAnimationState(const AnimationState& state, bool force) {
+    //leave the nodes alone when their values didn't move so an idle chao keeps its cached matrices
+    if (force || state.ballPos != _renderAnimState.ballPos) {
+        _updateChaoBallTransform(state);
+    }
+    if (force || state.armAngle != _renderAnimState.armAngle || state.armAngle2 != _renderAnimState.armAngle2 ||
+        state.footAngle != _renderAnimState.footAngle || state.headAngle != _renderAnimState.headAngle) {
+        _updateChaoLimbTransforms(state);
+    }
+    _renderAnimState = state;
+}
+
+void MPEngine::_snapAnimationState() {
+    _prevAnimState = _captureAnimationState();
+    _applyAnimationState(_prevAnimState, true);
 }
 
 /**
@@ -241,322 +513,148 @@ void MPEngine::run(){
  */
 
  void MPEngine::_buildChao() {
-    //create all the modelLoaders we will need and place them in a container
-    _chaoHead = new CSCI441::ModelLoader();
-    _chaoHeadBall = new CSCI441::ModelLoader();
-    _chaoRArm = new CSCI441::ModelLoader();
-    _chaoLArm = new CSCI441::ModelLoader();
-    _chaoBody = new CSCI441::ModelLoader();
-    _chaoRFoot = new CSCI441::ModelLoader();
-    _chaoLFoot = new CSCI441::ModelLoader();
-    _chaoTail = new CSCI441::ModelLoader();
-    _chaoWings = new CSCI441::ModelLoader();
-
-    // load chao piece by piece by loading in each respective file
-    //first the head
-    if( _chaoHead->loadModelFile("models/ChaoParts/chaoHead.obj" ) ) {
-        //set attributes
-        _chaoHead->setAttributeLocations(_MPShaderAttributeLocations.vPos,
-                                        _MPShaderAttributeLocations.vNormal,
-                                        _MPShaderAttributeLocations.texCoord);
-    } else {
-        fprintf(stderr, "[ERROR]: Could not open OBJ Model for Head\n");
-        delete _chaoHead;
-        _chaoHead = nullptr;
-    }
-    //now the headBall
-    if( _chaoHeadBall->loadModelFile("models/ChaoParts/chaoHeadBall.obj" ) ) {
-        //set attributes
-        _chaoHeadBall->setAttributeLocations(_MPShaderAttributeLocations.vPos,
-                                        _MPShaderAttributeLocations.vNormal,
-                                        _MPShaderAttributeLocations.texCoord);
-    } else {
-        fprintf(stderr, "[ERROR]: Could not open OBJ Model for HeadBall\n");
-        delete _chaoHeadBall;
-        _chaoHeadBall = nullptr;
-    }
-    //now RArm
-    if( _chaoRArm->loadModelFile("models/ChaoParts/chaoRArm.obj" ) ) {
-        //set attributes
-        _chaoRArm->setAttributeLocations(_MPShaderAttributeLocations.vPos,
-                                        _MPShaderAttributeLocations.vNormal,
-                                        _MPShaderAttributeLocations.texCoord);
-    } else {
-        fprintf(stderr, "[ERROR]: Could not open OBJ Model for RArm\n");
-        delete _chaoRArm;
-        _chaoRArm = nullptr;
-    }
-    //now LArm
-    if( _chaoLArm->loadModelFile("models/ChaoParts/chaoLArm.obj" ) ) {
-        //set attributes
-        _chaoLArm->setAttributeLocations(_MPShaderAttributeLocations.vPos,
-                                        _MPShaderAttributeLocations.vNormal,
-                                        _MPShaderAttributeLocations.texCoord);
-    } else {
-        fprintf(stderr, "[ERROR]: Could not open OBJ Model for LArm\n");
-        delete _chaoLArm;
-        _chaoLArm = nullptr;
-    }
-    //now Body
-    if( _chaoBody->loadModelFile("models/ChaoParts/chaoBody.obj" ) ) {
-        //set attributes
-        _chaoBody->setAttributeLocations(_MPShaderAttributeLocations.vPos,
-                                        _MPShaderAttributeLocations.vNormal,
-                                        _MPShaderAttributeLocations.texCoord);
-    } else {
-        fprintf(stderr, "[ERROR]: Could not open OBJ Model for Body\n");
-        delete _chaoBody;
-        _chaoBody = nullptr;
-    }
-    //now RFoot
-    if( _chaoRFoot->loadModelFile("models/ChaoParts/chaoRFoot.obj" ) ) {
-        //set attributes
-        _chaoRFoot->setAttributeLocations(_MPShaderAttributeLocations.vPos,
-                                        _MPShaderAttributeLocations.vNormal,
-                                        _MPShaderAttributeLocations.texCoord);
-    } else {
-        fprintf(stderr, "[ERROR]: Could not open OBJ Model for RFoot\n");
-        delete _chaoRFoot;
-        _chaoRFoot = nullptr;
-    }
-    //now LFoot
-    if( _chaoLFoot->loadModelFile("models/ChaoParts/chaoLFoot.obj" ) ) {
-        //set attributes
-        _chaoLFoot->setAttributeLocations(_MPShaderAttributeLocations.vPos,
-                                        _MPShaderAttributeLocations.vNormal,
-                                        _MPShaderAttributeLocations.texCoord);
-    } else {
-        fprintf(stderr, "[ERROR]: Could not open OBJ Model for LFoot\n");
-        delete _chaoLFoot;
-        _chaoLFoot = nullptr;
-    }
-    //now Tail
-    if( _chaoTail->loadModelFile("models/ChaoParts/chaoTail.obj" ) ) {
-        //set attributes
-        _chaoTail->setAttributeLocations(_MPShaderAttributeLocations.vPos,
-                                        _MPShaderAttributeLocations.vNormal,
-                                        _MPShaderAttributeLocations.texCoord);
-    } else {
-        fprintf(stderr, "[ERROR]: Could not open OBJ Model for Tail\n");
-        delete _chaoTail;
-        _chaoTail = nullptr;
-    }
-    //now Wings
-    if( _chaoWings->loadModelFile("models/ChaoParts/chaoWings.obj" ) ) {
-        //set attributes
-        _chaoWings->setAttributeLocations(_MPShaderAttributeLocations.vPos,
-                                        _MPShaderAttributeLocations.vNormal,
-                                        _MPShaderAttributeLocations.texCoord);
-    } else {
-        fprintf(stderr, "[ERROR]: Could not open OBJ Model for Wings\n");
-        delete _chaoWings;
-        _chaoWings = nullptr;
-    }
+    //every part file in ChaoPart order, the position in this list becomes the part index of its vertices
+    const std::vector<std::string> partFiles = {
+        "models/ChaoParts/chaoHead.obj",
+        "models/ChaoParts/chaoHeadBall.obj",
+        "models/ChaoParts/chaoRArm.obj",
+        "models/ChaoParts/chaoLArm.obj",
+        "models/ChaoParts/chaoBody.obj",
+        "models/ChaoParts/chaoRFoot.obj",
+        "models/ChaoParts/chaoLFoot.obj",
+        "models/ChaoParts/chaoTail.obj",
+        "models/ChaoParts/chaoWings.obj"
+    };
+    _chaoMesh = new PartMesh();
+    //packed on upload, the cache keeps full floats so switching formats doesn't rebuild it
+    _chaoMesh->setVertexFormat(_vertexFormat);
+    //set attributes now, they are hooked up as soon as the buffers exist
+    _chaoMesh->setAttributeLocations(_MPShaderAttributeLocations.vPos,
+                                    _MPShaderAttributeLocations.vNormal,
+                                    _MPShaderAttributeLocations.texCoord,
+                                    _MPShaderAttributeLocations.partIndex);
+    //load and merge the chao into one mesh on the worker threads (one part per worker), after the first run
+    //this comes from the binary cache without parsing. The buffers are created in mSetupScene by _assetLoader->finish()
+    _chaoMesh->loadPartFilesAsync(*_assetLoader, partFiles, "models/ChaoParts/chao.meshcache");
  }
 
- void MPEngine::_drawChao(const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
-    //let shader know this requires a texture but not vertex color or emissiveColor
-    glUniform1i(_MPShaderProgram->getUniformLocation("useTexture"), GL_TRUE);
-    glUniform1i(_MPShaderProgram->getUniformLocation("useVertexColor"), GL_FALSE);
-    glUniform1i(_MPShaderProgram->getUniformLocation("useEmissive"), GL_FALSE);
-
-    //_chaoMatColor acts as base color (multiplies with texture)
-    glUniform3fv(_MPShaderUniformLocations.materialColor, 1, glm::value_ptr(_chaoMatCol));
-    //begin drawing the chao from all the loaded in parts
-    //draw chao head
-    if (_chaoHead) {
-        glm::mat4 modelMtx = glm::mat4(1.0f);
-        //translate upwards a bit (will replace this with where we really want to put it for transfromations later)
-        modelMtx = glm::translate(modelMtx, _chaoPosOffset);
-        //compute y-axis rotation from heading
-        float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
-        modelMtx = glm::rotate(modelMtx, headingAngle, glm::vec3(0, 1, 0));
-        //apply local offsets
-        modelMtx = glm::translate(modelMtx, glm::vec3(0.008086f, 4.772f, -0.6555f));
-        //rotate the head about the y-axis via _headAngle
-        modelMtx = glm::rotate(modelMtx, glm::radians(_headAngle), glm::vec3(0, 1, 0));
-        //recompute mvp and the normal matrix
-        glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-        glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-        //activate shader program!
-        _MPShaderProgram->useProgram();
-        //send over the mvp and normMtx to gpu
-        glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-        glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-        _chaoHead->draw(_MPShaderProgram->getShaderProgramHandle());
-    }
-    //draw chao headball
-    if (_chaoHeadBall) {
-        glm::mat4 modelMtx = glm::mat4(1.0f);
-        //translate upwards a bit (will replace this with where we really want to put it for transfromations later)
-        modelMtx = glm::translate(modelMtx, _chaoPosOffset);
-        //compute y-axis rotation from heading
-        float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
-        modelMtx = glm::rotate(modelMtx, headingAngle, glm::vec3(0, 1, 0));
-        //apply local offsets
-        modelMtx = glm::translate(modelMtx, glm::vec3(_ballPos));
-        //recompute mvp and the normal matrix
-        glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-        glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-        //activate shader program!
-        _MPShaderProgram->useProgram();
-        //send over the mvp and normMtx to gpu
-        glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-        glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-        _chaoHeadBall->draw(_MPShaderProgram->getShaderProgramHandle());
-    }
-    //draw chao RArm
-    if (_chaoRArm) {
-        glm::mat4 modelMtx = glm::mat4(1.0f);
-        //translate upwards a bit (will replace this with where we really want to put it for transfromations later)
-        modelMtx = glm::translate(modelMtx, _chaoPosOffset);
-        //compute y-axis rotation from heading
-        float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
-        modelMtx = glm::rotate(modelMtx, headingAngle, glm::vec3(0, 1, 0));
-        //apply local offsets
-        modelMtx = glm::translate(modelMtx, glm::vec3(1.312f, 4.657f, 0.07665f));
-        //rotate the arms about the x-axis via _armAngle
-        modelMtx = glm::rotate(modelMtx, glm::radians(_armAngle), glm::vec3(1, 0, 0));
-        //rotate the arms about the z-axis via _armAngle2
-        modelMtx = glm::rotate(modelMtx, glm::radians(_armAngle2), glm::vec3(0, 0, 1));
-        //recompute mvp and the normal matrix
-        glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-        glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-        //activate shader program!
-        _MPShaderProgram->useProgram();
-        //send over the mvp and normMtx to gpu
-        glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-        glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-        _chaoRArm->draw(_MPShaderProgram->getShaderProgramHandle());
-    }
-    //draw chao LArm
-    if (_chaoLArm) {
-        glm::mat4 modelMtx = glm::mat4(1.0f);
-        //translate upwards a bit (will replace this with where we really want to put it for transfromations later)
-        modelMtx = glm::translate(modelMtx, _chaoPosOffset);
-        //compute y-axis rotation from heading
-        float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
-        modelMtx = glm::rotate(modelMtx, headingAngle, glm::vec3(0, 1, 0));
-        //apply local offsets
-        modelMtx = glm::translate(modelMtx, glm::vec3(-1.296f, 4.657f, 0.07665f));
-        //rotate the arms about the x-axis via _armAngle (make this one opposite of the Rarm)
-        modelMtx = glm::rotate(modelMtx, glm::radians(-_armAngle), glm::vec3(1, 0, 0));
-        //rotate the arms about the z-axis via _armAngle2 (make this one opposite of the Rarm)
-        modelMtx = glm::rotate(modelMtx, glm::radians(-_armAngle2), glm::vec3(0, 0, 1));
-        //recompute mvp and the normal matrix
-        glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-        glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-        //activate shader program!
-        _MPShaderProgram->useProgram();
-        //send over the mvp and normMtx to gpu
-        glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-        glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-        _chaoLArm->draw(_MPShaderProgram->getShaderProgramHandle());
-    }
-    //draw chao body
-    if (_chaoBody) {
-        glm::mat4 modelMtx = glm::mat4(1.0f);
-        //translate upwards a bit (will replace this with where we really want to put it for transfromations later)
-        modelMtx = glm::translate(modelMtx, _chaoPosOffset);
-        //compute y-axis rotation from heading
-        float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
-        modelMtx = glm::rotate(modelMtx, headingAngle, glm::vec3(0, 1, 0));
-        //apply local offsets
-        modelMtx = glm::translate(modelMtx, glm::vec3(0.008084f, 3.196f, 0.1679f));
-        //recompute mvp and the normal matrix
-        glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-        glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-        //activate shader program!
-        _MPShaderProgram->useProgram();
-        //send over the mvp and normMtx to gpu
-        glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-        glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-        _chaoBody->draw(_MPShaderProgram->getShaderProgramHandle());
-    }
-    //draw chao RFoot
-    if (_chaoRFoot) {
-        glm::mat4 modelMtx = glm::mat4(1.0f);
-        //translate upwards a bit (will replace this with where we really want to put it for transfromations later)
-        modelMtx = glm::translate(modelMtx, _chaoPosOffset);
-        //compute y-axis rotation from heading
-        float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
-        modelMtx = glm::rotate(modelMtx, headingAngle, glm::vec3(0, 1, 0));
-        //apply local offsets
-        modelMtx = glm::translate(modelMtx, glm::vec3(1.427f, 1.811f, 0.001732f));
-        //rotate the feet about the x-axis via _footAngle
-        modelMtx = glm::rotate(modelMtx, glm::radians(_footAngle), glm::vec3(1, 0, 0));
-        //recompute mvp and the normal matrix
-        glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-        glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-        //activate shader program!
-        _MPShaderProgram->useProgram();
-        //send over the mvp and normMtx to gpu
-        glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-        glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-        _chaoRFoot->draw(_MPShaderProgram->getShaderProgramHandle());
-    }
-    //draw chao LFoot
-    if (_chaoLFoot) {
-        glm::mat4 modelMtx = glm::mat4(1.0f);
-        //translate upwards a bit (will replace this with where we really want to put it for transfromations later)
-        modelMtx = glm::translate(modelMtx, _chaoPosOffset);
-        //compute y-axis rotation from heading
-        float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
-        modelMtx = glm::rotate(modelMtx, headingAngle, glm::vec3(0, 1, 0));
-        //apply local offsets
-        modelMtx = glm::translate(modelMtx, glm::vec3(-1.411f, 1.811f, 0.001732f));
-        //rotate the feet about the x-axis via _footAngle (make this one opposite of the RFoot)
-        modelMtx = glm::rotate(modelMtx, glm::radians(-_footAngle), glm::vec3(1, 0, 0));
-        //recompute mvp and the normal matrix
-        glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-        glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-        //activate shader program!
-        _MPShaderProgram->useProgram();
-        //send over the mvp and normMtx to gpu
-        glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-        glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-        _chaoLFoot->draw(_MPShaderProgram->getShaderProgramHandle());
-    }
-    //draw chao Tail
-    if (_chaoTail) {
-        glm::mat4 modelMtx = glm::mat4(1.0f);
-        //translate upwards a bit (will replace this with where we really want to put it for transfromations later)
-        modelMtx = glm::translate(modelMtx, _chaoPosOffset);
-        //compute y-axis rotation from heading
-        float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
-        modelMtx = glm::rotate(modelMtx, headingAngle, glm::vec3(0, 1, 0));
-        //apply local offsets
-        modelMtx = glm::translate(modelMtx, glm::vec3(0.008086f, 2.991f, -2.484f));
-        //recompute mvp and the normal matrix
-        glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-        glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-        //activate shader program!
-        _MPShaderProgram->useProgram();
-        //send over the mvp and normMtx to gpu
-        glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-        glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-        _chaoTail->draw(_MPShaderProgram->getShaderProgramHandle());
+ void MPEngine::_drawChao(RenderQueue& queue) const {
+    //nothing to draw if the parts failed to load or none of them are in view
+    if (!_chaoMesh || !_chaoMesh->isLoaded() || !_chaoVisible) return;
+    //the textured shader variant, the material is tinted by _chaoMatCol and
+    //the parts carry their own model matrix so the object slot is identity
+    RenderQueue::Item item;
+    item.program = _getMaterialProgram(MATERIAL_CHAO);
+    item.texture = _chaoMesh->getTexture();
+    item.vao = _chaoMesh->getVAO();
+    item.count = _chaoMesh->getNumIndices(_chaoLod);
+    item.first = _chaoMesh->getFirstIndex(_chaoLod);
+    item.indexType = GL_UNSIGNED_INT;
+    item.material = MATERIAL_CHAO;
+    item.object = OBJECT_CHAO;
+    //the part uniforms go out once the queue has the program bound
+    item.setup = [this] { _sendChaoPartUniforms(_MPShaderUniformLocations[_materialVariants[MATERIAL_CHAO]]); };
+    //draw the whole chao in one call
+    queue.submit(std::move(item));
+ }
+
+ void MPEngine::_sendChaoPartUniforms(const MPShaderUniformLocations& locations) const {
+    //limb swing amplitudes (degrees about x, y, z) and frequency matching _animateBody: +-48 degree arm swing
+    //stepped 4 degrees a frame is a 48 frame cycle, everything else keeps the same ratio to the arms
+    const float swingFrequency = ANIMATION_REFERENCE_FPS / 48.f;
+    //head ball spiral parameters matching _animateBall: (thetaMax, seconds to spiral out, radius per radian, bob height)
+    const glm::vec4 spiralParams(_thetaMax, _thetaMax / (_thetaSpeed * ANIMATION_REFERENCE_FPS), 0.018f, 0.3f);
+
+    //procedural animation of every part in ChaoPart order
+    const AnimMode partModes[NUM_CHAO_PARTS] = {
+        ANIM_SWING, ANIM_SPIRAL, ANIM_SWING, ANIM_SWING, ANIM_NONE, ANIM_SWING, ANIM_SWING, ANIM_NONE, ANIM_NONE
+    };
+    const glm::vec4 partParams[NUM_CHAO_PARTS] = {
+        glm::vec4(0.f, 24.f, 0.f, swingFrequency),      //head
+        spiralParams,                                   //head ball
+        glm::vec4(48.f, 0.f, 16.8f, swingFrequency),    //RArm
+        glm::vec4(-48.f, 0.f, -16.8f, swingFrequency),  //LArm
+        glm::vec4(0.f),                                 //body
+        glm::vec4(36.f, 0.f, 0.f, swingFrequency),      //RFoot
+        glm::vec4(-36.f, 0.f, 0.f, swingFrequency),     //LFoot
+        glm::vec4(0.f),                                 //tail
+        glm::vec4(0.f)                                  //wings
+    };
+    //gather the cached part matrices, CPU animation mode has already baked everything into them
+    glm::mat4 partMtx[NUM_CHAO_PARTS];
+    glm::mat3 partNormMtx[NUM_CHAO_PARTS];
+    GLint partAnimMode[NUM_CHAO_PARTS];
+    for (GLuint i = 0; i < NUM_CHAO_PARTS; i++) {
+        partMtx[i] = _chaoPartNodes[i]->getWorldMatrix();
+        partNormMtx[i] = _chaoPartNodes[i]->getNormalMatrix();
+        partAnimMode[i] = _gpuAnimation ? partModes[i] : ANIM_NONE;
     }
-    //draw chao Wings
-    if (_chaoWings) {
-        glm::mat4 modelMtx = glm::mat4(1.0f);
-        //translate upwards a bit (will replace this with where we really want to put it for transfromations later)
-        modelMtx = glm::translate(modelMtx, _chaoPosOffset);
-        //compute y-axis rotation from heading
-        float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
-        modelMtx = glm::rotate(modelMtx, headingAngle, glm::vec3(0, 1, 0));
-        //apply local offsets
-        modelMtx = glm::translate(modelMtx, glm::vec3(0.008086f, 4.426f, -1.563f));
-        //recompute mvp and the normal matrix
-        glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-        glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-        //activate shader program!
-        _MPShaderProgram->useProgram();
-        //send over the mvp and normMtx to gpu
-        glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-        glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-        _chaoWings->draw(_MPShaderProgram->getShaderProgramHandle());
+
+    //send over every part at once
+    glUniform1i(locations.useParts, GL_TRUE);
+    glUniformMatrix4fv(locations.partMtx, NUM_CHAO_PARTS, GL_FALSE, &partMtx[0][0][0]);
+    glUniformMatrix3fv(locations.partNormMtx, NUM_CHAO_PARTS, GL_FALSE, &partNormMtx[0][0][0]);
+    glUniform1iv(locations.partAnimMode, NUM_CHAO_PARTS, partAnimMode);
+    glUniform4fv(locations.partAnimParams, NUM_CHAO_PARTS, &partParams[0][0]);
+ }
+
+ void MPEngine::_createChaoHierarchy() {
+    _chaoRoot = new TransformNode();
+    for (TransformNode*& node : _chaoPartNodes) {
+        node = _chaoRoot->addChild(new TransformNode());
     }
+    //body, tail, and wings never move relative to the root so they are only set here
+    _chaoPartNodes[CHAO_BODY]->setLocalMatrix(glm::translate(glm::mat4(1.0f), glm::vec3(0.008084f, 3.196f, 0.1679f)));
+    _chaoPartNodes[CHAO_TAIL]->setLocalMatrix(glm::translate(glm::mat4(1.0f), glm::vec3(0.008086f, 2.991f, -2.484f)));
+    _chaoPartNodes[CHAO_WINGS]->setLocalMatrix(glm::translate(glm::mat4(1.0f), glm::vec3(0.008086f, 4.426f, -1.563f)));
+    //give the moving nodes their starting transform
+    _updateChaoRootTransform();
+    //the ball and limbs start at the current animation state
+    _snapAnimationState();
+    _chaoRoot->updateWorldMatrices();
+ }
+
+ void MPEngine::_updateChaoRootTransform() {
+    //not built yet during setup
+    if (!_chaoRoot) return;
+    //translate by the movement offset then turn to face the heading
+    glm::mat4 rootMtx = glm::translate(glm::mat4(1.0f), _chaoPosOffset);
+    //compute y-axis rotation from heading once for the whole chao
+    float headingAngle = atan2(_chaoHeading.x, _chaoHeading.z); //y rotation in radians
+    rootMtx = glm::rotate(rootMtx, headingAngle, glm::vec3(0, 1, 0));
+    _chaoRoot->setLocalMatrix(rootMtx);
+ }
+
+ void MPEngine::_updateChaoBallTransform(const AnimationState& state) {
+    if (!_chaoRoot) return;
+    //the shader adds the spiral on top of the center in GPU animation mode
+    _chaoPartNodes[CHAO_HEAD_BALL]->setLocalMatrix(glm::translate(glm::mat4(1.0f), _gpuAnimation ? _ballCenter : state.ballPos));
+ }
+
+ void MPEngine::_updateChaoLimbTransforms(const AnimationState& state) {
+    if (!_chaoRoot) return;
+    //head: local offset then rotate about the y-axis via headAngle
+    glm::mat4 modelMtx = glm::translate(glm::mat4(1.0f), glm::vec3(0.008086f, 4.772f, -0.6555f));
+    modelMtx = glm::rotate(modelMtx, glm::radians(state.headAngle), glm::vec3(0, 1, 0));
+    _chaoPartNodes[CHAO_HEAD]->setLocalMatrix(modelMtx);
+    //RArm: rotate about the x-axis via armAngle and about the z-axis via armAngle2
+    modelMtx = glm::translate(glm::mat4(1.0f), glm::vec3(1.312f, 4.657f, 0.07665f));
+    modelMtx = glm::rotate(modelMtx, glm::radians(state.armAngle), glm::vec3(1, 0, 0));
+    modelMtx = glm::rotate(modelMtx, glm::radians(state.armAngle2), glm::vec3(0, 0, 1));
+    _chaoPartNodes[CHAO_R_ARM]->setLocalMatrix(modelMtx);
+    //LArm: same as the RArm but opposite angles
+    modelMtx = glm::translate(glm::mat4(1.0f), glm::vec3(-1.296f, 4.657f, 0.07665f));
+    modelMtx = glm::rotate(modelMtx, glm::radians(-state.armAngle), glm::vec3(1, 0, 0));
+    modelMtx = glm::rotate(modelMtx, glm::radians(-state.armAngle2), glm::vec3(0, 0, 1));
+    _chaoPartNodes[CHAO_L_ARM]->setLocalMatrix(modelMtx);
+    //RFoot: rotate about the x-axis via footAngle
+    modelMtx = glm::translate(glm::mat4(1.0f), glm::vec3(1.427f, 1.811f, 0.001732f));
+    modelMtx = glm::rotate(modelMtx, glm::radians(state.footAngle), glm::vec3(1, 0, 0));
+    _chaoPartNodes[CHAO_R_FOOT]->setLocalMatrix(modelMtx);
+    //LFoot: opposite of the RFoot
+    modelMtx = glm::translate(glm::mat4(1.0f), glm::vec3(-1.411f, 1.811f, 0.001732f));
+    modelMtx = glm::rotate(modelMtx, glm::radians(-state.footAngle), glm::vec3(1, 0, 0));
+    _chaoPartNodes[CHAO_L_FOOT]->setLocalMatrix(modelMtx);
  }
 
  void MPEngine::_createGroundBuffers() {
@@ -571,7 +669,7 @@ void MPEngine::run(){
     std::vector<Vertex> groundVertices;
     //specify grid lines and spacing between them
     const GLfloat halfSize = WORLD_SIZE / 2.0f;
-    const GLint numLines = 40;
+    const GLint numLines = NUM_GROUND_LINES;
     const GLfloat spacing = WORLD_SIZE / numLines;
     ///upward normal for all grid lines
     glm::vec3 upNormal = glm::vec3(0.0f, 1.0f, 0.0f);
@@ -599,96 +697,313 @@ void MPEngine::run(){
         groundVertices.push_back({{x, 0.0f, -halfSize}, upNormal, color});
         groundVertices.push_back({{x, 0.0f, halfSize}, upNormal, color});
     }
+    //the grid is flat, its box is just the line endpoints
+    _groundBounds = BoundingBox();
+    for (const Vertex& vertex : groundVertices) {
+        _groundBounds.expand(vertex.pos);
+    }
     //get the size of our ground vertices vector in GL friendly format
     _numGroundPoints = static_cast<GLsizei>(groundVertices.size());
-    //setup vbo, attach it to _groundVAO, and populate with the data in our vector
+    //pack the vertices into the selected format (36 bytes of floats down to 16 when compact)
+    VertexPacker packer;
+    packer.pack(_vertexFormat,
+                (1u << VertexPacker::POSITION) | (1u << VertexPacker::NORMAL) | (1u << VertexPacker::COLOR),
+                static_cast<GLuint>(groundVertices.size()), [&groundVertices](GLuint i) {
+                    VertexPacker::Source source;
+                    source.position = groundVertices[i].pos;
+                    source.normal = groundVertices[i].normal;
+                    source.color = groundVertices[i].color;
+                    return source;
+                });
+    packer.printSavings("Ground grid");
+    _groundVertexDecode = packer.getDecode();
+    //setup vbo, attach it to _groundVAO, and populate with the packed data
     GLuint vbo;
     glGenVertexArrays(1, &_groundVAO);
     glGenBuffers(1, &vbo);
     glBindVertexArray(_groundVAO);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, groundVertices.size() * sizeof(Vertex), groundVertices.data(), GL_STATIC_DRAW);
-    //send data over to GPU/Shaders  
-    //position attribute
-    GLint posAttrib = _MPShaderAttributeLocations.vPos;
-    glEnableVertexAttribArray(posAttrib);
-    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
-    //normal attribute
-    GLint normAttrib = _MPShaderAttributeLocations.vNormal;
-    glEnableVertexAttribArray(normAttrib);
-    glVertexAttribPointer(normAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    //color attribute
-    GLint colAttrib = _MPShaderAttributeLocations.vColor;
-    glEnableVertexAttribArray(colAttrib);
-    glVertexAttribPointer(colAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(packer.getBytes().size()), packer.getBytes().data(), GL_STATIC_DRAW);
+    //send data over to GPU/Shaders, the packer knows each attribute's type and offset
+    packer.setAttributePointer(VertexPacker::POSITION, _MPShaderAttributeLocations.vPos);
+    packer.setAttributePointer(VertexPacker::NORMAL, _MPShaderAttributeLocations.vNormal);
+    packer.setAttributePointer(VertexPacker::COLOR, _MPShaderAttributeLocations.vColor);
     //unbind the _groundVAO
     glBindVertexArray(0);
+
+    //the procedural grid has no vertex data, it builds its triangle from gl_VertexID
+    glGenVertexArrays(1, &_groundGridVAO);
  }
 
- void MPEngine::_drawGroundGrid(const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
-    //compute mvp matrix
-    glm::mat4 modelMtx = glm::mat4(1.0f);
-    glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-    glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-    //activate the shader program!
-    _MPShaderProgram->useProgram();
+ void MPEngine::_drawGroundGrid(RenderQueue& queue) const {
+    if (_proceduralGround) {
+        //one triangle covering the screen, the fragment shader finds the ground and its lines per pixel
+        //(it is never culled, the plane has no edge to leave the view)
+        RenderQueue::Item item;
+        item.program = _groundGridShaderProgram->getShaderProgramHandle();
+        item.vao = _groundGridVAO;
+        item.count = 3;
+        queue.submit(std::move(item));
+        return;
+    }
+    if (!_groundVisible) return;
+    //the vertex colored shader variant, the grid's material and model matrix live in their uniform buffer slots
+    RenderQueue::Item item;
+    item.program = _getMaterialProgram(MATERIAL_GROUND);
+    item.vao = _groundVAO;
+    item.mode = GL_LINES;
+    item.count = _numGroundPoints;
+    item.material = MATERIAL_GROUND;
+    item.object = OBJECT_GROUND;
+    //grid never animates and is a single part
+    const MPShaderUniformLocations* locations = &_MPShaderUniformLocations[_materialVariants[MATERIAL_GROUND]];
+    item.setup = [locations] {
+        glUniform1i(locations->animMode, ANIM_NONE);
+        glUniform1i(locations->useParts, GL_FALSE);
+    };
+    //draw grid lines
+    queue.submit(std::move(item));
+ }
 
-    //send MVP and Norm matrix to GPU
-    glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0]);
-    glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
+ void MPEngine::_createStarField() {
+    _starField = new StarField();
+    _starField->setup(_MPStarShaderAttributeLocations.vPos, _MPStarShaderAttributeLocations.vNormal,
+                      _MPStarShaderAttributeLocations.starIndex, NUM_STARS + NUM_STAR_LIGHTS);
+    //the star data is one texture buffer, drivers only have to allow 65536 texels so keep room for the light stars
+    const GLuint maxStars = _starField->getMaxStars() > NUM_STAR_LIGHTS ? _starField->getMaxStars() - NUM_STAR_LIGHTS : 0;
+    const GLuint numStars = glm::min(NUM_STARS, maxStars);
+    if (numStars < NUM_STARS) {
+        fprintf(stderr, "[WARN]: the star data texture buffer holds %u stars, scattering %u of %u\n",
+                _starField->getMaxStars(), numStars, NUM_STARS);
+    }
+    auto random = [] { return rand() / (float)RAND_MAX; };
+    for (GLuint i = 0; i < numStars; i++) {
+        StarField::Star star;
+        star.position = glm::vec3((random() - 0.5f) * WORLD_SIZE * 2.0f,
+                                  STAR_MIN_HEIGHT + random() * (STAR_MAX_HEIGHT - STAR_MIN_HEIGHT),
+                                  (random() - 0.5f) * WORLD_SIZE * 2.0f);
+        star.color = glm::vec3(random(), random(), random());
+        //mostly small stars with the odd big one
+        star.size = 0.3f + 1.7f * random() * random() * random();
+        star.phase = random() * 360.0f;
+        //up to 7.2 degrees per second either way about each axis, averaging the 3.6 the old field spun at
+        star.spinRate = glm::vec3(random() - 0.5f, random() - 0.5f, random() - 0.5f) * 14.4f;
+        _starField->spawn(star);
+    }
+    //the light stars hang low over the world where the original 50 stars were, bright enough to light the ground
+    for (GLuint i = 0; i < NUM_STAR_LIGHTS; i++) {
+        StarField::Star star;
+        star.position = glm::vec3((random() - 0.5f) * WORLD_SIZE, 5.0f + random() * 25.0f, (random() - 0.5f) * WORLD_SIZE);
+        star.color = glm::vec3(random(), random(), random());
+        star.size = 2.0f + 1.5f * random();
+        star.phase = random() * 360.0f;
+        star.spinRate = glm::vec3(random() - 0.5f, random() - 0.5f, random() - 0.5f) * 14.4f;
+        _starField->spawn(star);
+        _clusteredLights->addLight({star.position, STAR_LIGHT_RADIUS, star.color});
+    }
+ }
 
-    //grid color
-    glm::vec3 gridTint = glm::vec3(1.f, 1.f, 1.f); //no tint (pure vColor)
-    glUniform3fv(_MPShaderUniformLocations.materialColor, 1, glm::value_ptr(gridTint));
+void MPEngine::_assignLights(const glm::mat4& viewMtx, const glm::mat4& projMtx, const glm::vec2& framebufferSize) {
+    FrameProfiler::Scope scope(*_profiler, PROFILE_LIGHTS);
+    _clusteredLights->update(viewMtx, projMtx, NEAR_PLANE, FAR_PLANE, framebufferSize);
+}
 
-    //grid does not use textures or emissive color but does use vertex color
-    glUniform1i(_MPShaderProgram->getUniformLocation("useTexture"), GL_FALSE);
-    glUniform1i(_MPShaderProgram->getUniformLocation("useVertexColor"), GL_TRUE);
-    glUniform1i(_MPShaderProgram->getUniformLocation("useEmissive"), GL_FALSE);
+ void MPEngine::_drawEnvironment(RenderQueue& queue) const {
+    //every star is out of view
+    if (_starField->getNumVisible() == 0) return;
+    //the star shader program only reads FrameData and the star data, the material and object slots are left alone
+    RenderQueue::Item item;
+    item.program = _MPStarShaderProgram->getShaderProgramHandle();
+    item.vao = _starField->getVAO();
+    item.count = _starField->getNumIndices();
+    item.indexType = GL_UNSIGNED_SHORT;
+    //only the stars _cullScene found in view
+    item.instanceCount = static_cast<GLsizei>(_starField->getNumVisible() * StarField::CUBES_PER_STAR);
+    //the cube transforms are built in the vertex shader from each star's spin rates, so all it needs is the clock
+    //(interpolated like everything else so the spin is smooth between steps)
+    const float starTime = _renderAnimState.animTime;
+    const GLint starTimeLocation = _MPStarShaderUniformLocations.starTime;
+    const GLuint starData = _starField->getDataTexture();
+    item.setup = [starTimeLocation, starTime, starData] {
+        glUniform1f(starTimeLocation, starTime);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, starData);
+        glActiveTexture(GL_TEXTURE0);
+    };
+    //draw every cube of every visible star in one call
+    queue.submit(std::move(item));
+}
 
-    //draw grid lines
-    glBindVertexArray(_groundVAO);
-    glDrawArrays(GL_LINES, 0, _numGroundPoints);
-    glBindVertexArray(0);
- }
+void MPEngine::_createUniformBuffers() {
+    //slots have to start on a multiple of the offset alignment to be bound with glBindBufferRange
+    GLint alignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    auto alignUp = [alignment](GLsizeiptr size) { return (size + alignment - 1) / alignment * alignment; };
+    _materialStride = alignUp(sizeof(MaterialBlock));
+    _objectStride = alignUp(sizeof(ObjectBlock));
 
- void MPEngine::_drawEnvironment(const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
-    //activate the shader program
-    _MPShaderProgram->useProgram();
-    //these drawings will not use texture or vertex color but will use emissive color
-    glUniform1i(_MPShaderProgram->getUniformLocation("useEmissive"), GL_TRUE);
-    glUniform1i(_MPShaderUniformLocations.useTexture, GL_FALSE);
-    glUniform1i(_MPShaderUniformLocations.useVertexColor, GL_FALSE);
-    for (int i=0; i<_starPositions.size(); i++) {
-        //base transform
-        glm::mat4 base = glm::translate(glm::mat4(1.0f), _starPositions[i]);
-        glm::vec3 starColor = _starColors[i];
-        //send over uniform data
-        glUniform3fv(_MPShaderUniformLocations.materialColor, 1, glm::value_ptr(starColor));
-        glUniform3fv(_MPShaderUniformLocations.emissiveColor, 1, glm::value_ptr(starColor));
-        //draw the 4 cubes that will make the start but make them slightly offset
-        for (int j=0; j<4; j++) {
-            glm::mat4 model = base;
-            if (j == 1) model = glm::rotate(model, glm::radians(45.f + _starAngle), glm::vec3(1, 0, 0));
-            if (j == 2) model = glm::rotate(model, glm::radians(45.f + _starAngle), glm::vec3(0, 1, 0));
-            if (j == 3) model = glm::rotate(model, glm::radians(45.f + _starAngle), glm::vec3(0, 0, 1));
-            model = glm::scale(model, glm::vec3(1.01f + 0.01f * j)); //tiny scale difference to avoid artifact
-            //calculate mvp and norm matrices
-            glm::mat4 mvp = projMtx * viewMtx * model;
-            glm::mat3 normMtx = glm::mat3(glm::transpose(glm::inverse(model)));
-            glUniformMatrix4fv(_MPShaderUniformLocations.mvpMtx, 1, GL_FALSE, &mvp[0][0]);
-            glUniformMatrix3fv(_MPShaderUniformLocations.normMtx, 1, GL_FALSE, &normMtx[0][0]);
-            //draw the cube
-            CSCI441::drawSolidCube(5.0f);
+    //FrameData is rewritten every frame
+    glGenBuffers(1, &_frameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, _frameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, _frameUBO);
+    //materials and objects only change on input
+    glGenBuffers(1, &_materialUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, _materialUBO);
+    glBufferData(GL_UNIFORM_BUFFER, _materialStride * NUM_MATERIALS, nullptr, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &_objectUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, _objectUBO);
+    glBufferData(GL_UNIFORM_BUFFER, _objectStride * NUM_OBJECTS, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    //grid uses pure vertex color (white tint), chao is textured and tinted by _chaoMatCol
+    _updateMaterial(MATERIAL_GROUND, MP_SHADER_VERTEX_COLOR, glm::vec3(1.f), glm::vec3(0.f));
+    _updateMaterial(MATERIAL_CHAO, MP_SHADER_TEXTURE, _chaoMatCol, glm::vec3(0.f));
+    //the grid sits at the origin and the chao parts carry their own matrices
+    //(the chao's vertex decode is only known once it is loaded, see mSetupScene)
+    _updateObject(OBJECT_GROUND, glm::mat4(1.0f), _groundVertexDecode);
+    _updateObject(OBJECT_CHAO, glm::mat4(1.0f));
+    //the render queue binds slots only when consecutive draws use different ones
+    _renderQueue.setSlotBinders([this](GLuint material) { _bindMaterial(material); },
+                                [this](GLuint object) { _bindObject(object); });
+}
+
+void MPEngine::_updateMaterial(Material material, GLuint variant, const glm::vec3& matColor, const glm::vec3& emissiveColor) {
+    if (_MPShaderVariants->getShaderProgramHandle(variant) == 0) {
+        fprintf(stderr, "[WARN]: MPShader variant %u was not built, add it to MP_SHADER_USED_VARIANTS\n", variant);
+    }
+    _materialVariants[material] = variant;
+    MaterialBlock block;
+    block.matColor = glm::vec4(matColor, 1.f);
+    block.emissiveColor = glm::vec4(emissiveColor, 1.f);
+    glBindBuffer(GL_UNIFORM_BUFFER, _materialUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, material * _materialStride, sizeof(MaterialBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void MPEngine::_updateObject(Object object, const glm::mat4& modelMtx, const VertexDecode& decode) const {
+    ObjectBlock block;
+    block.modelMtx = modelMtx;
+    //the normal matrix is computed here once instead of every draw
+    block.normMtx = glm::mat4(glm::mat3(glm::transpose(glm::inverse(modelMtx))));
+    //the shader unpacks quantized positions and octahedral normals before anything else touches them
+    block.positionScale = glm::vec4(decode.positionScale, 0.f);
+    block.positionOffset = glm::vec4(decode.positionOffset, 0.f);
+    block.vertexFlags = glm::ivec4(decode.octahedralNormals ? 1 : 0, 0, 0, 0);
+    glBindBuffer(GL_UNIFORM_BUFFER, _objectUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, object * _objectStride, sizeof(ObjectBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void MPEngine::_updateFrameData(const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
+    FrameBlock block;
+    block.viewMtx = viewMtx;
+    block.projMtx = projMtx;
+    block.viewProjMtx = projMtx * viewMtx;
+    block.lightDir = glm::vec4(_lightDir, 0.f);
+    block.lightColor = glm::vec4(_lightColor, 0.f);
+    //the clocks as of the interpolated frame, not the last simulation step
+    block.animClock = glm::vec4(_renderAnimState.animTime, _renderAnimState.walkTime, 0.f, 0.f);
+    glBindBuffer(GL_UNIFORM_BUFFER, _frameUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GLuint MPEngine::_getMaterialProgram(Material material) const {
+    //the material decides which features get compiled in
+    return _MPShaderVariants->getShaderProgramHandle(_materialVariants[material]);
+}
+
+void MPEngine::_bindMaterial(GLuint material) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, _materialUBO, material * _materialStride, sizeof(MaterialBlock));
+}
+
+void MPEngine::_bindObject(GLuint object) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, _objectUBO, object * _objectStride, sizeof(ObjectBlock));
+}
+
+void MPEngine::_bindUniformBlocks(GLuint programHandle) {
+    //a program that does not use a block just doesn't have it (GL_INVALID_INDEX)
+    const char* blockNames[4] = {"FrameData", "MaterialData", "ObjectData", "ClusterData"};
+    const GLuint bindings[4] = {FRAME_BLOCK_BINDING, MATERIAL_BLOCK_BINDING, OBJECT_BLOCK_BINDING, CLUSTER_BLOCK_BINDING};
+    for (int i = 0; i < 4; i++) {
+        GLuint blockIndex = glGetUniformBlockIndex(programHandle, blockNames[i]);
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(programHandle, blockIndex, bindings[i]);
         }
     }
 }
 
+void MPEngine::_toggleGpuAnimation() {
+    _gpuAnimation = !_gpuAnimation;
+    //the shader animates from the rest pose so clear out anything the CPU path left behind
+    _armAngle = 0.f;
+    _armAngle2 = 0.f;
+    _footAngle = 0.f;
+    _headAngle = 0.f;
+    _origAngle = true;
+    _walkTime = 0.f;
+    //the limbs went back to rest and the head ball switches between its spiral position and center,
+    //show that right away instead of blending into it
+    _snapAnimationState();
+    fprintf(stdout, "[INFO]: %s animation\n", _gpuAnimation ? "GPU" : "CPU");
+}
+
+void MPEngine::_toggleGroundMode() {
+    _proceduralGround = !_proceduralGround;
+    fprintf(stdout, "[INFO]: ground drawn as %s\n", _proceduralGround ? "procedural grid" : "line list");
+}
+
+void MPEngine::_toggleProfiler() {
+    //turning it on starts the averages over, turning it off stops every timer and query
+    _profiler->setEnabled(!_profiler->isEnabled());
+    fprintf(stdout, "[INFO]: frame profiler %s\n", _profiler->isEnabled() ? "on" : "off");
+}
+
+void MPEngine::_takeScreenshot() {
+    //captured at the end of this frame, written a few frames later by a worker
+    _frameCapture->requestScreenshot();
+}
+
+void MPEngine::_toggleRecording(const FrameCapture::RecordMode mode) {
+    if (_frameCapture->getRecordMode() == mode) {
+        _frameCapture->stopRecording();
+    } else {
+        _frameCapture->startRecording(mode);
+    }
+}
+
+void MPEngine::_createProfiler() {
+    _profiler = new FrameProfiler();
+    //same order as ProfileSection so the enum values are the section ids
+    _profiler->addSection("frame", false);
+    _profiler->addSection("update", false);
+    _profiler->addSection("lights", false);
+    _profiler->addSection("grid", true);
+    _profiler->addSection("chao", true);
+    _profiler->addSection("stars", true);
+    _profiler->addSection("hud", true);
+    _hudText = new TextOverlay();
+    _hudText->setup();
+}
+
+void MPEngine::_drawProfilerHud() {
+    FrameProfiler::Scope scope(*_profiler, PROFILE_HUD);
+    //the overlay works in framebuffer pixels, which are not window pixels on high DPI screens
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
+    //grow the 3x5 font with the framebuffer so it stays readable
+    const GLfloat scale = glm::max(2.0f, glm::floor(framebufferHeight / 300.0f));
+    _hudText->draw(_profiler->report(), glm::vec2(4.0f * scale), scale, glm::vec4(1.0f, 1.0f, 0.3f, 1.0f),
+                   glm::vec2(framebufferWidth, framebufferHeight));
+}
+
 void MPEngine::_changeChaoCol() {
     //generate a random vec3 color
     _chaoMatCol = glm::vec3(rand() / (float)RAND_MAX,
                             rand() / (float)RAND_MAX,
                             rand() / (float)RAND_MAX);
+    _updateMaterial(MATERIAL_CHAO, MP_SHADER_TEXTURE, _chaoMatCol, glm::vec3(0.f));
 }
 
  void MPEngine::_updateChaoHeading(float angle) {
@@ -696,11 +1011,11 @@ void MPEngine::_changeChaoCol() {
     glm::mat4 rotMtx = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0, 1, 0));
     glm::vec4 newHeading = rotMtx * glm::vec4(_chaoHeading, 0.0f);
     _chaoHeading = glm::normalize(glm::vec3(newHeading));
+    //the whole chao turns so only the root node changes
+    _updateChaoRootTransform();
  }
 
  void MPEngine::_updateChaoPos(float moveAmount) {
-    //turn on _isMoving bool so our feet and arms animate as we walk
-    _isMoving = true;
     //update the position offset
     _chaoPosOffset += moveAmount * _chaoHeading;
     //bounds check via the same way the grid was made: WORLD_SIZE/2
@@ -712,6 +1027,25 @@ void MPEngine::_changeChaoCol() {
     //bounds check the camera via _chaoPos
     _chaoPos.x = glm::clamp(_chaoPos.x, -WORLD_SIZE/2, WORLD_SIZE/2);
     _chaoPos.z = glm::clamp(_chaoPos.z, -WORLD_SIZE/2, WORLD_SIZE/2);
+    //the whole chao moves so only the root node changes
+    _updateChaoRootTransform();
+ }
+
+ void MPEngine::_moveChaoFromKeys() {
+    auto held = [this](const int key, const int arrowKey) {
+        return glfwGetKey(mpWindow, key) == GLFW_PRESS || glfwGetKey(mpWindow, arrowKey) == GLFW_PRESS;
+    };
+    //'A'/'D' (or left/right arrow) turn the chao, 'W'/'S' (or up/down arrow) walk it along its heading
+    float turnAngle = 0.f;
+    float moveAmount = 0.f;
+    if (held(GLFW_KEY_A, GLFW_KEY_LEFT)) turnAngle += CHAO_STEP_ANGLE;
+    if (held(GLFW_KEY_D, GLFW_KEY_RIGHT)) turnAngle -= CHAO_STEP_ANGLE;
+    if (held(GLFW_KEY_W, GLFW_KEY_UP)) moveAmount += CHAO_STEP_DISTANCE;
+    if (held(GLFW_KEY_S, GLFW_KEY_DOWN)) moveAmount -= CHAO_STEP_DISTANCE;
+    if (turnAngle != 0.f) _updateChaoHeading(turnAngle);
+    if (moveAmount != 0.f) _updateChaoPos(moveAmount);
+    //the feet and arms only animate while the chao walks
+    _isMoving = moveAmount != 0.f;
  }
 
  /**
@@ -774,9 +1108,6 @@ void MPEngine::_animateBody() {
             _origAngle = true;
         }
     }
-
-    //turning off the bool for _isMoving otherwise the feet will continue to "animate" when were not moving
-    _isMoving = false;
 }
 
 void MPEngine::_resetBodyState() {
@@ -785,8 +1116,10 @@ void MPEngine::_resetBodyState() {
     _armAngle2 = 0.f;
     _footAngle = 0.f;
     _headAngle = 0.f;
+    _snapAnimationState();
     //reset chao color back to normal
     _chaoMatCol = glm::vec3(1.f, 1.f, 1.f);
+    _updateMaterial(MATERIAL_CHAO, MP_SHADER_TEXTURE, _chaoMatCol, glm::vec3(0.f));
 }
 
  /**
@@ -797,24 +1130,7 @@ void MP_keyboard_callback(GLFWwindow *window, int key, int scancode, int action,
     auto engine = static_cast<MPEngine*>(glfwGetWindowUserPointer(window));
     //now we check if certain keys are pressed
     switch (key) {
-        //if 'A' or 'D' (or left arrow/right arrow) are pressed we update the direction of our Chao
-        case GLFW_KEY_LEFT:
-        case GLFW_KEY_A:
-            engine->_updateChaoHeading(5.f); //have 5 degrees for now
-            break;
-        case GLFW_KEY_RIGHT:
-        case GLFW_KEY_D:
-            engine->_updateChaoHeading(-5.f);
-            break;
-        //if 'W' or 'S' (or up/down arrow) are pressed we update just the position of our chao
-        case GLFW_KEY_UP:
-        case GLFW_KEY_W:
-            engine->_updateChaoPos(2.f); //make the speed of movement 2 for now
-            break;
-        case GLFW_KEY_DOWN:
-        case GLFW_KEY_S:
-            engine->_updateChaoPos(-2.f);
-            break;
+        //the movement keys are not handled here, every simulation step samples whether they are held
         case GLFW_KEY_R:
             //rest the body part angles
             engine->_resetBodyState();
@@ -823,9 +1139,29 @@ void MP_keyboard_callback(GLFWwindow *window, int key, int scancode, int action,
             //change the color of our chao
             engine->_changeChaoCol();
             break;
+        case GLFW_KEY_G:
+            //switch decorative animation between CPU and GPU (only on press, not repeat)
+            if (action == GLFW_PRESS) engine->_toggleGpuAnimation();
+            break;
+        case GLFW_KEY_L:
+            //switch the ground between the procedural grid and the line list (only on press, not repeat)
+            if (action == GLFW_PRESS) engine->_toggleGroundMode();
+            break;
+        case GLFW_KEY_P:
+            //show/hide the frame profiler readout (only on press, not repeat)
+            if (action == GLFW_PRESS) engine->_toggleProfiler();
+            break;
         case GLFW_KEY_SPACE:
-            //take a screenshot
-            engine->saveScreenshot(nullptr);
+            //take a screenshot (only on press, holding space shouldn't fill the disk)
+            if (action == GLFW_PRESS) engine->_takeScreenshot();
+            break;
+        case GLFW_KEY_V:
+            //start/stop recording a Y4M video stream
+            if (action == GLFW_PRESS) engine->_toggleRecording(FrameCapture::RECORD_Y4M);
+            break;
+        case GLFW_KEY_F:
+            //start/stop recording numbered PNG frames
+            if (action == GLFW_PRESS) engine->_toggleRecording(FrameCapture::RECORD_PNG);
             break;
         case GLFW_KEY_Q:
         case GLFW_KEY_ESCAPE:
@@ -5,6 +5,19 @@
 #include <CSCI441/OpenGLEngine.hpp>
 #include <CSCI441/ShaderProgram.hpp>
 #include "ArcballCam.h"
+#include "AssetLoader.hpp"
+#include "Benchmark.hpp"
+#include "ClusteredLights.hpp"
+#include "FrameCapture.hpp"
+#include "FrameProfiler.hpp"
+#include "Frustum.hpp"
+#include "PartMesh.hpp"
+#include "RenderQueue.hpp"
+#include "ShaderVariants.hpp"
+#include "StarField.hpp"
+#include "TextOverlay.hpp"
+#include "TransformNode.hpp"
+#include "VertexFormat.hpp"
 
 //begin defining the MP Engine class
 class MPEngine final : public CSCI441::OpenGLEngine {
@@ -14,6 +27,10 @@ class MPEngine final : public CSCI441::OpenGLEngine {
         ~MPEngine();
 
         void run() override;
+        //function that switches run() to a headless benchmark, call before initialize() so the context is created offscreen
+        void setBenchmark(const BenchmarkSettings& settings) {_benchmark = settings;}
+        //function that picks the vertex format the chao and the grid are packed in, call before initialize()
+        void setVertexFormat(const VertexFormat& format) {_vertexFormat = format;}
 
         //function that returns a pointer to our arcball camera
         ArcballCam* getArcballcam() const {return _pArcballCam;}
@@ -39,6 +56,16 @@ class MPEngine final : public CSCI441::OpenGLEngine {
         void _resetBodyState();
         //function to randomly change the chao's mat color
         void _changeChaoCol();
+        //function to switch the decorative animation between the CPU and the vertex shader
+        void _toggleGpuAnimation();
+        //function to switch the ground between the procedural grid shader and the line list grid
+        void _toggleGroundMode();
+        //function to start/stop the frame profiler and its on-screen readout
+        void _toggleProfiler();
+        //function to save the next frame as a PNG without stalling on the readback or the encoding
+        void _takeScreenshot();
+        //function to start recording every frame in the given mode, or stop if that mode is already recording
+        void _toggleRecording(FrameCapture::RecordMode mode);
 
 
     private:
@@ -62,6 +89,58 @@ class MPEngine final : public CSCI441::OpenGLEngine {
         void _generateEnvironment();
         void _renderScene(const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
         void _updateScene();
+        //everything drawn in a frame is submitted here and issued sorted by program, texture, and VAO
+        //(mutable so the const draw functions can fill it, it holds no scene state between frames)
+        mutable RenderQueue _renderQueue;
+
+        //CAPTURE STUFF
+        //reads finished frames back through a ring of PBOs and writes screenshots/recordings on worker threads
+        FrameCapture* _frameCapture;
+
+        //BENCHMARK STUFF
+        //when enabled run() draws a scripted path into an offscreen framebuffer and writes frame statistics as JSON
+        BenchmarkSettings _benchmark;
+        //function that runs the benchmark in place of the windowed loop
+        void _runBenchmark();
+
+        //VERTEX FORMAT STUFF
+        //format the chao and grid vertices are packed in on upload (compact unless main picks another)
+        VertexFormat _vertexFormat;
+
+        //CULLING STUFF
+        //function that tests every drawable against the view volume, call once per frame before _renderScene
+        //(also sends the visible stars to _starField and picks the chao's level of detail)
+        void _cullScene(const glm::mat4& viewMtx, const glm::mat4& projMtx);
+        //whether the grid and the chao were inside the view volume this frame
+        bool _groundVisible;
+        bool _chaoVisible;
+        //level of detail the chao is drawn at, picked from its size on screen while culling
+        GLuint _chaoLod;
+        //GPU animation swings the limbs and spirals the head ball after the part matrices, so in that mode the
+        //part spheres are grown by this much to still cover them
+        static constexpr GLfloat GPU_ANIMATION_CULL_PADDING = 2.0f;
+
+        //PROFILER STUFF
+        //parts of a frame the profiler times, added in this order so each value is also its section id
+        //(frame and update are CPU only, the passes and the HUD also get a GPU query each)
+        enum ProfileSection : GLuint {
+            PROFILE_FRAME,
+            PROFILE_UPDATE,
+            PROFILE_LIGHTS,
+            PROFILE_GRID,
+            PROFILE_CHAO,
+            PROFILE_STARS,
+            PROFILE_HUD,
+            NUM_PROFILE_SECTIONS
+        };
+        //CPU timers and GPU queries per section, does nothing until toggled on with P
+        FrameProfiler* _profiler;
+        //draws the profiler readout over the scene
+        TextOverlay* _hudText;
+        //function that creates the profiler sections and the text overlay
+        void _createProfiler();
+        //function that draws the profiler readout in the top left corner
+        void _drawProfilerHud();
 
         /*
         ******************************************************
@@ -75,22 +154,19 @@ class MPEngine final : public CSCI441::OpenGLEngine {
         glm::vec2 _cameraAngle;
         glm::vec2 _mousePosition;
         GLint _leftMouseButtonState;
+        //near and far planes of the projection (the light clusters are sliced between them)
+        static constexpr GLfloat NEAR_PLANE = 0.1f;
+        static constexpr GLfloat FAR_PLANE = 300.0f;
 
         //OBJECT/MODEL STUFF
-        //.obj models where we will load in each part of our Chao
-        CSCI441::ModelLoader* _chaoHead;
-        CSCI441::ModelLoader* _chaoHeadBall;
-        CSCI441::ModelLoader* _chaoRArm;
-        CSCI441::ModelLoader* _chaoLArm;
-        CSCI441::ModelLoader* _chaoBody;
-        CSCI441::ModelLoader* _chaoRFoot;
-        CSCI441::ModelLoader* _chaoLFoot;
-        CSCI441::ModelLoader* _chaoTail;
-        CSCI441::ModelLoader* _chaoWings;//might need to split this into two seperate...we'll see
+        //worker threads that parse the models and textures during setup, deleted once everything is uploaded
+        AssetLoader* _assetLoader;
+        //every .obj part of our Chao merged into one mesh, each vertex tagged with its ChaoPart
+        PartMesh* _chaoMesh;
         //function to build the chao from all the parts
         void _buildChao();
-        //function to draw the chao from all loaded in parts
-        void _drawChao(const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
+        //function to submit the chao from all loaded in parts as a single draw
+        void _drawChao(RenderQueue& queue) const;
         //variable for changing chao color randomly
         glm::vec3 _chaoMatCol;
         //variables and function for passive animation of head ball
@@ -104,7 +180,10 @@ class MPEngine final : public CSCI441::OpenGLEngine {
         //variables for moving the Chao and animating the feet, arms, and head
         glm::vec3 _chaoHeading;
         glm::vec3 _chaoPosOffset;
+        //set by every step from whether the chao walked in it, the limbs only animate while it is true
         bool _isMoving;
+        //function that turns and walks the chao one step's worth for each held movement key
+        void _moveChaoFromKeys();
         glm::vec3 _chaoPos; //need this variable for the camera
         void _animateBody();
         bool _origAngle;
@@ -113,6 +192,86 @@ class MPEngine final : public CSCI441::OpenGLEngine {
         float _footAngle;
         float _headAngle;
 
+        //TRANSFORM HIERARCHY STUFF
+        //every part of the chao, used to index _chaoPartNodes and the part index of _chaoMesh
+        enum ChaoPart {
+            CHAO_HEAD,
+            CHAO_HEAD_BALL,
+            CHAO_R_ARM,
+            CHAO_L_ARM,
+            CHAO_BODY,
+            CHAO_R_FOOT,
+            CHAO_L_FOOT,
+            CHAO_TAIL,
+            CHAO_WINGS,
+            NUM_CHAO_PARTS
+        };
+        //root of the chao hierarchy, holds the position offset and heading (owns the part nodes)
+        TransformNode* _chaoRoot;
+        //one child of _chaoRoot per part holding the local offset and limb rotation
+        TransformNode* _chaoPartNodes[NUM_CHAO_PARTS];
+        //function that builds the chao hierarchy
+        void _createChaoHierarchy();
+        //function that sends the new offset and heading to the root node (call when either changes)
+        void _updateChaoRootTransform();
+        //AnimationState is declared with the simulation clock below
+        struct AnimationState;
+        //function that sends the head ball position to its node (call when it changes)
+        void _updateChaoBallTransform(const AnimationState& state);
+        //function that sends the head, arm, and foot angles to their nodes (call when any changes)
+        void _updateChaoLimbTransforms(const AnimationState& state);
+
+        //GPU ANIMATION STUFF
+        //when true the head ball spiral and limb swings are evaluated in the vertex shader (the stars always spin there)
+        bool _gpuAnimation;
+        //seconds since the scene started, drives the star spin and head ball spiral
+        float _animTime;
+        //seconds spent walking, drives the limb swings so they only move while the chao does
+        float _walkTime;
+        //the CPU animations step once per simulation tick at this rate, the GPU versions are matched to it
+        static constexpr GLfloat ANIMATION_REFERENCE_FPS = 60.0f;
+        //animation modes understood by MPShader.v.glsl
+        enum AnimMode : GLint {
+            ANIM_NONE = 0,
+            ANIM_SPIRAL = 1,
+            ANIM_SWING = 2
+        };
+
+
+        //SIMULATION CLOCK STUFF
+        //_updateScene always advances exactly this many seconds, however fast frames are drawn
+        static constexpr GLfloat SIMULATION_STEP = 1.0f / ANIMATION_REFERENCE_FPS;
+        //most real time one frame may feed the simulation, longer stalls are dropped instead of caught up
+        static constexpr GLfloat MAX_FRAME_TIME = 0.25f;
+        //how far the chao walks and how many degrees it turns each step a movement key is held
+        static constexpr GLfloat CHAO_STEP_DISTANCE = 1.0f;
+        static constexpr GLfloat CHAO_STEP_ANGLE = 2.5f;
+        //time at the start of the previous frame
+        float _lastFrameTime;
+        //real time not yet simulated, always less than SIMULATION_STEP after the steps of a frame ran
+        float _simAccumulator;
+        //everything _updateScene steps that shows up on screen
+        struct AnimationState {
+            glm::vec3 ballPos;
+            float armAngle;
+            float armAngle2;
+            float footAngle;
+            float headAngle;
+            float animTime;
+            float walkTime;
+        };
+        //state at the start of the last step, frames are drawn between it and the current state
+        AnimationState _prevAnimState;
+        //state the current frame is drawn with
+        AnimationState _renderAnimState;
+        //function that copies the current simulation state out of the animation variables
+        AnimationState _captureAnimationState() const;
+        //function that blends from _prevAnimState (alpha = 0) to the current state (alpha = 1)
+        AnimationState _interpolateAnimationState(float alpha) const;
+        //function that makes state the one drawn, only touching the chao nodes whose part of it changed unless forced
+        void _applyAnimationState(const AnimationState& state, bool force);
+        //function that drops the in-between after a jump (reset, mode switch) so the current state is drawn as is
+        void _snapAnimationState();
 
         //GRID STUFF
         //size of the world/ground plane
@@ -123,48 +282,158 @@ class MPEngine final : public CSCI441::OpenGLEngine {
         GLsizei _numGroundPoints;
         //function that creates the ground VAO
         void _createGroundBuffers();
-        //function that draws the ground grid
-        void _drawGroundGrid(const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
+        //function that submits the ground grid
+        void _drawGroundGrid(RenderQueue& queue) const;
+        //box around the whole grid, set when the grid is built
+        BoundingBox _groundBounds;
+        //what MPShader needs to unpack the grid's vertices, goes out with OBJECT_GROUND
+        VertexDecode _groundVertexDecode;
+        //when true the ground is drawn by the procedural grid shader instead of the line list (toggled with L).
+        //Its lines are computed per pixel on the y = 0 plane, so it has no edge and costs the same at any WORLD_SIZE
+        bool _proceduralGround;
+        //empty VAO the procedural grid draws its screen covering triangle with (core profile needs one bound)
+        GLuint _groundGridVAO;
+        //the procedural grid has faded out by this distance from the camera (inside the 300 unit far plane)
+        static constexpr GLfloat GROUND_FADE_DISTANCE = 250.0f;
+        //number of line list grid lines along each axis, the procedural grid uses the same spacing
+        static constexpr GLint NUM_GROUND_LINES = 40;
         
-        //function to utilize class objects.hpp file to create the environment
-        void _drawEnvironment(const glm::mat4& viewMtx, const glm::mat4& projMtx) const; //this will actually be a drawing function so must be const type
-        //add two vectors to store the positional and color data (randomly generated) for the environment
-        std::vector<glm::vec3> _starPositions;
-        std::vector<glm::vec3> _starColors;
-        float _starAngle;
+        //function to submit the star field as a single instanced draw
+        void _drawEnvironment(RenderQueue& queue) const; //this will actually be a drawing function so must be const type
+        //number of stars to scatter across the sky, fewer if the star data texture buffer can't hold them all
+        static constexpr GLuint NUM_STARS = 100000;
+        //height band the stars are scattered in
+        static constexpr GLfloat STAR_MIN_HEIGHT = 40.0f;
+        static constexpr GLfloat STAR_MAX_HEIGHT = 160.0f;
+
+        //STAR FIELD STUFF
+        //every star's position, color, size, and spin kept in GPU buffers, drawn as one instanced call of the visible ones
+        StarField* _starField;
+        //function that creates the star field, spawns NUM_STARS random stars in it, and scatters the light stars
+        void _createStarField();
+
+        //STAR LIGHT STUFF
+        //low, larger stars scattered over the world like the original field, each one also a point light
+        static constexpr GLuint NUM_STAR_LIGHTS = 256;
+        //distance a star light reaches
+        static constexpr GLfloat STAR_LIGHT_RADIUS = 30.0f;
+        //the star lights binned into view clusters every frame, read by MPShader and the ground grid per fragment
+        ClusteredLights* _clusteredLights;
+        //texture units of the light lists
+        static constexpr GLuint LIGHT_TEXTURE_UNIT = 2;
+        //function that bins the lights for this view, call once per frame before _renderScene
+        void _assignLights(const glm::mat4& viewMtx, const glm::mat4& projMtx, const glm::vec2& framebufferSize);
         
 
         /**********************************************
          * SHADER STUFF SUCH AS UNIFORMS, ATTRIBUTES, *
          **********************************************
          */
-        //shader program that performs full phong illumination model and texturing (for Chao)
-        CSCI441::ShaderProgram* _MPShaderProgram;
+        //optional MPShader features, a variant index is these bits OR'd together
+        enum MPShaderFeature : GLuint {
+            MP_SHADER_TEXTURE = 1,      //USE_TEXTURE
+            MP_SHADER_VERTEX_COLOR = 2, //USE_VERTEX_COLOR
+            MP_SHADER_EMISSIVE = 4,     //USE_EMISSIVE
+            NUM_MP_SHADER_VARIANTS = 8
+        };
+        //the variants the materials use (chao, ground), no other variant is compiled
+        static constexpr GLuint MP_SHADER_USED_VARIANTS[] = {MP_SHADER_TEXTURE, MP_SHADER_VERTEX_COLOR};
+        //every variant of the shader that performs full phong illumination model and texturing (for Chao),
+        //each one compiled with only the features its index names
+        ShaderVariants* _MPShaderVariants;
 
-        //struct that will store the locations of all our shader uniforms
+        //UNIFORM BUFFER STUFF
+        //binding points of the std140 uniform blocks shared by MPShader and MPStarShader
+        enum UniformBlockBinding : GLuint {
+            FRAME_BLOCK_BINDING = 0,
+            MATERIAL_BLOCK_BINDING = 1,
+            OBJECT_BLOCK_BINDING = 2,
+            CLUSTER_BLOCK_BINDING = 3 //owned by _clusteredLights
+        };
+        //FrameData block: everything that is the same for every draw in a frame, uploaded once per frame
+        struct FrameBlock {
+            glm::mat4 viewMtx;
+            glm::mat4 projMtx;
+            glm::mat4 viewProjMtx;
+            glm::vec4 lightDir;   //xyz used
+            glm::vec4 lightColor; //xyz used
+            glm::vec4 animClock;  //x = animTime, y = walkTime
+        };
+        //MaterialData block: one slot per material, only re-uploaded when a material changes
+        //(which features a material uses is picked by its shader variant, not stored here)
+        struct MaterialBlock {
+            glm::vec4 matColor;      //rgb used
+            glm::vec4 emissiveColor; //rgb used
+        };
+        //ObjectData block: one slot per object, only re-uploaded when an object moves
+        struct ObjectBlock {
+            glm::mat4 modelMtx;
+            glm::mat4 normMtx; //upper 3x3 used, std140 pads mat3 columns to vec4 anyway
+            glm::vec4 positionScale;  //xyz used, the object's VertexDecode
+            glm::vec4 positionOffset; //xyz used
+            glm::ivec4 vertexFlags;   //x = 1 for octahedral normals
+        };
+        //materials that have a slot in _materialUBO
+        enum Material : GLuint {
+            MATERIAL_GROUND,
+            MATERIAL_CHAO,
+            NUM_MATERIALS
+        };
+        //objects that have a slot in _objectUBO
+        enum Object : GLuint {
+            OBJECT_GROUND,
+            OBJECT_CHAO,
+            NUM_OBJECTS
+        };
+        //uniform buffers behind the three blocks
+        GLuint _frameUBO;
+        GLuint _materialUBO;
+        GLuint _objectUBO;
+        //distance between slots in _materialUBO/_objectUBO (block size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+        GLsizeiptr _materialStride;
+        GLsizeiptr _objectStride;
+        //MPShader variant (MPShaderFeature bits) each material draws with
+        GLuint _materialVariants[NUM_MATERIALS];
+        //light used by every shader
+        glm::vec3 _lightDir;
+        glm::vec3 _lightColor;
+        //function that creates the uniform buffers and fills the material and object slots
+        void _createUniformBuffers();
+        //function that uploads a material into its slot and picks the shader variant it draws with
+        void _updateMaterial(Material material, GLuint variant, const glm::vec3& matColor, const glm::vec3& emissiveColor);
+        //function that uploads an object's model matrix (and its normal matrix) into its slot, along with how its vertices are packed
+        void _updateObject(Object object, const glm::mat4& modelMtx, const VertexDecode& decode = VertexDecode()) const;
+        //function that uploads the FrameData block, call once per frame before drawing
+        void _updateFrameData(const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
+        //function that hooks a program's blocks up to the binding points
+        static void _bindUniformBlocks(GLuint programHandle);
+
+        //struct that will store the locations of all our shader uniforms (looked up once per variant in mSetupShaders)
         struct MPShaderUniformLocations {
-            //precomputed MVP matrix location
-            GLint mvpMtx;
-            //material diffuse color location
-            GLint materialColor;
-            //light direction Uniform
-            GLint lightDir;
-            //light color Uniform
-            GLint lightColor;
-            //WILL LIKELY NEED TO ADD MORE THINGS HERE FOR THE REST OF THE PHONG ILLUMINATION MODEL: SPECULAR AND AMBIENT  
-            //normMtx uniform
-            GLint normMtx;
             //texture map Uniform
             GLint texMap;
-            //useTexture bool
-            GLint useTexture;
-            //useVertexColor bool
-            GLint useVertexColor;
-            //emissive color
-            GLint emissiveColor;
-            //use emissive bool
-            GLint useEmissive;
-        } _MPShaderUniformLocations;
+            //procedural animation mode
+            GLint animMode;
+            //procedural animation parameters
+            GLint animParams;
+            //use per-part matrices bool
+            GLint useParts;
+            //per-part world matrices
+            GLint partMtx;
+            //per-part normal matrices
+            GLint partNormMtx;
+            //per-part procedural animation modes
+            GLint partAnimMode;
+            //per-part procedural animation parameters
+            GLint partAnimParams;
+        } _MPShaderUniformLocations[NUM_MP_SHADER_VARIANTS];
+        //function that returns the program of the shader variant a material draws with
+        GLuint _getMaterialProgram(Material material) const;
+        //functions the render queue calls to bind a material's/object's slot for the next draws
+        void _bindMaterial(GLuint material) const;
+        void _bindObject(GLuint object) const;
+        //function that sends the chao's per-part matrices and animation to a variant of MPShader
+        void _sendChaoPartUniforms(const MPShaderUniformLocations& locations) const;
 
         //struc that will store the locations of all our shader attributes
         struct MPShaderAttributeLocations {
@@ -176,8 +445,33 @@ class MPEngine final : public CSCI441::OpenGLEngine {
             GLint texCoord;
             //vertex color
             GLint vColor;
+            //index of the part the vertex belongs to
+            GLint partIndex;
         } _MPShaderAttributeLocations;
 
+        //shader program that draws the instanced star field
+        CSCI441::ShaderProgram* _MPStarShaderProgram;
+        //shader program that draws the procedural ground grid (its spacing and fade are set once at setup)
+        CSCI441::ShaderProgram* _groundGridShaderProgram;
+
+        //struct that will store the locations of the star shader uniforms (view * projection and the light come from FrameData)
+        struct MPStarShaderUniformLocations {
+            //seconds the stars have been spinning
+            GLint starTime;
+            //texture buffer holding the per-star data
+            GLint starData;
+        } _MPStarShaderUniformLocations;
+
+        //struct that will store the locations of the star shader attributes
+        struct MPStarShaderAttributeLocations {
+            //cube vertex position
+            GLint vPos;
+            //cube vertex normal
+            GLint vNormal;
+            //per-instance index of the star in the star data
+            GLint starIndex;
+        } _MPStarShaderAttributeLocations;
+
 
 };
 
@@ -0,0 +1,280 @@
+/**
+ * @file MeshCache.hpp
+ * @brief Binary cache of ready-to-upload mesh buffers, memory mapped on load
+ */
+
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include <glad/gl.h>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/// \desc a cache file holds the interleaved vertices and indices of a mesh exactly as they are uploaded,
+/// plus the modification time and size of every source file it was built from. Loading maps the file
+/// and hands the buffers straight to glBufferData, a source that changed makes the cache stale.
+///
+/// layout (native endian, every section 4 byte aligned):
+///   Header | numSources x (SourceStamp, path) | texture path | numLods x index count | vertices | indices
+/// where the indices are every level of detail back to back, finest first
+class MeshCache {
+  public:
+    /// \desc buffers read out of a mapped cache file, only valid while the MeshCache stays open
+    struct Contents {
+      const void* vertices;
+      GLuint numVertices;
+      const GLuint* indices;
+      /// \desc indices of every level of detail together
+      GLuint numIndices;
+      /// \desc number of indices in each level of detail, they add up to numIndices
+      std::vector<GLuint> lodIndexCounts;
+      GLuint numParts;
+      std::string texturePath;
+    };
+
+    MeshCache();
+    ~MeshCache();
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    /// \desc maps cacheFilename and checks it was built from the current sources with this vertex layout
+    /// \return true and fills contents if the cache is present and up to date
+    bool open(const std::string& cacheFilename, const std::vector<std::string>& sources, GLuint vertexStride, Contents& contents);
+    /// \desc unmaps the file, contents from open() are invalid afterwards
+    void close();
+
+    /// \desc writes a new cache file stamped with the current state of every source
+    /// \note the file is written next to the cache and renamed over it, so a reader never maps a partial file
+    static bool write(const std::string& cacheFilename, const std::vector<std::string>& sources, GLuint vertexStride,
+                      const void* vertices, GLuint numVertices, const GLuint* indices, GLuint numIndices,
+                      const std::vector<GLuint>& lodIndexCounts, GLuint numParts, const std::string& texturePath);
+
+  private:
+    /// \desc "MCSH" read as a little endian integer
+    static constexpr std::uint32_t MAGIC = 0x4853434D;
+    /// \desc bump whenever the layout or what the mesh goes through before it is cached changes so old caches are rebuilt
+    static constexpr std::uint32_t VERSION = 3;
+
+    struct Header {
+      std::uint32_t magic;
+      std::uint32_t version;
+      std::uint32_t vertexStride;
+      std::uint32_t numSources;
+      std::uint32_t numParts;
+      std::uint32_t numVertices;
+      std::uint32_t numIndices;
+      std::uint32_t numLods;
+      std::uint32_t texturePathLength;
+    };
+    struct SourceStamp {
+      std::int64_t modifiedTime;
+      std::uint64_t size;
+      std::uint32_t pathLength;
+      std::uint32_t padding;
+    };
+
+    const unsigned char* _data;
+    size_t _size;
+#ifdef _WIN32
+    HANDLE _file;
+    HANDLE _mapping;
+#else
+    int _file;
+#endif
+
+    static bool _stampSource(const std::string& filename, SourceStamp& stamp);
+    static size_t _align(const size_t offset) { return (offset + 3) & ~static_cast<size_t>(3); }
+};
+
+inline MeshCache::MeshCache() :
+  _data(nullptr),
+  _size(0),
+#ifdef _WIN32
+  _file(INVALID_HANDLE_VALUE),
+  _mapping(nullptr) {
+#else
+  _file(-1) {
+#endif
+}
+
+inline MeshCache::~MeshCache() {
+  close();
+}
+
+inline bool MeshCache::_stampSource(const std::string& filename, SourceStamp& stamp) {
+  struct stat info;
+  if (stat(filename.c_str(), &info) != 0) return false;
+  stamp.modifiedTime = static_cast<std::int64_t>(info.st_mtime);
+  stamp.size = static_cast<std::uint64_t>(info.st_size);
+  stamp.pathLength = static_cast<std::uint32_t>(filename.size());
+  stamp.padding = 0;
+  return true;
+}
+
+inline bool MeshCache::open(const std::string& cacheFilename, const std::vector<std::string>& sources, const GLuint vertexStride, Contents& contents) {
+  close();
+
+#ifdef _WIN32
+  _file = CreateFileA(cacheFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (_file == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(_file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(Header))) { close(); return false; }
+  _size = static_cast<size_t>(fileSize.QuadPart);
+  _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!_mapping) { close(); return false; }
+  _data = static_cast<const unsigned char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!_data) { close(); return false; }
+#else
+  _file = ::open(cacheFilename.c_str(), O_RDONLY);
+  if (_file < 0) return false;
+  struct stat info;
+  if (fstat(_file, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) { close(); return false; }
+  _size = static_cast<size_t>(info.st_size);
+  void* mapped = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+  if (mapped == MAP_FAILED) { close(); return false; }
+  _data = static_cast<const unsigned char*>(mapped);
+#endif
+
+  // everything below only reads inside the mapping, a truncated or foreign file is just stale
+  Header header;
+  memcpy(&header, _data, sizeof(Header));
+  if (header.magic != MAGIC || header.version != VERSION ||
+      header.vertexStride != vertexStride || header.numSources != sources.size()) {
+    close();
+    return false;
+  }
+
+  size_t offset = sizeof(Header);
+  for (const std::string& source : sources) {
+    SourceStamp cached, current;
+    if (offset + sizeof(SourceStamp) > _size || !_stampSource(source, current)) { close(); return false; }
+    memcpy(&cached, _data + offset, sizeof(SourceStamp));
+    offset += sizeof(SourceStamp);
+    if (cached.modifiedTime != current.modifiedTime || cached.size != current.size ||
+        cached.pathLength != current.pathLength || offset + cached.pathLength > _size ||
+        memcmp(_data + offset, source.data(), cached.pathLength) != 0) {
+      close();
+      return false;
+    }
+    offset = _align(offset + cached.pathLength);
+  }
+
+  if (offset + header.texturePathLength > _size) { close(); return false; }
+  contents.texturePath.assign(reinterpret_cast<const char*>(_data + offset), header.texturePathLength);
+  offset = _align(offset + header.texturePathLength);
+
+  const size_t lodBytes = static_cast<size_t>(header.numLods) * sizeof(GLuint);
+  if (header.numLods == 0 || offset + lodBytes > _size) { close(); return false; }
+  contents.lodIndexCounts.resize(header.numLods);
+  memcpy(contents.lodIndexCounts.data(), _data + offset, lodBytes);
+  offset += lodBytes;
+  size_t lodTotal = 0;
+  for (const GLuint count : contents.lodIndexCounts) lodTotal += count;
+  if (lodTotal != header.numIndices) { close(); return false; }
+
+  const size_t vertexBytes = static_cast<size_t>(header.numVertices) * vertexStride;
+  const size_t indexBytes = static_cast<size_t>(header.numIndices) * sizeof(GLuint);
+  if (offset + vertexBytes + indexBytes != _size) { close(); return false; }
+  contents.vertices = _data + offset;
+  contents.numVertices = header.numVertices;
+  contents.indices = reinterpret_cast<const GLuint*>(_data + offset + vertexBytes);
+  contents.numIndices = header.numIndices;
+  contents.numParts = header.numParts;
+  return true;
+}
+
+inline void MeshCache::close() {
+#ifdef _WIN32
+  if (_data) UnmapViewOfFile(_data);
+  if (_mapping) CloseHandle(_mapping);
+  if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+  _mapping = nullptr;
+  _file = INVALID_HANDLE_VALUE;
+#else
+  if (_data) munmap(const_cast<unsigned char*>(_data), _size);
+  if (_file >= 0) ::close(_file);
+  _file = -1;
+#endif
+  _data = nullptr;
+  _size = 0;
+}
+
+inline bool MeshCache::write(const std::string& cacheFilename, const std::vector<std::string>& sources, const GLuint vertexStride,
+                             const void* vertices, const GLuint numVertices, const GLuint* indices, const GLuint numIndices,
+                             const std::vector<GLuint>& lodIndexCounts, const GLuint numParts, const std::string& texturePath) {
+  const std::string tempFilename = cacheFilename + ".tmp";
+  FILE* out = fopen(tempFilename.c_str(), "wb");
+  if (!out) {
+    fprintf(stderr, "[WARN]: Could not write mesh cache %s\n", tempFilename.c_str());
+    return false;
+  }
+  const char zeros[4] = {0, 0, 0, 0};
+  auto writePadded = [&](const void* bytes, const size_t count) {
+    fwrite(bytes, 1, count, out);
+    fwrite(zeros, 1, _align(count) - count, out);
+  };
+
+  Header header;
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.vertexStride = vertexStride;
+  header.numSources = static_cast<std::uint32_t>(sources.size());
+  header.numParts = numParts;
+  header.numVertices = numVertices;
+  header.numIndices = numIndices;
+  header.numLods = static_cast<std::uint32_t>(lodIndexCounts.size());
+  header.texturePathLength = static_cast<std::uint32_t>(texturePath.size());
+  fwrite(&header, sizeof(Header), 1, out);
+
+  for (const std::string& source : sources) {
+    SourceStamp stamp;
+    if (!_stampSource(source, stamp)) {
+      fclose(out);
+      remove(tempFilename.c_str());
+      return false;
+    }
+    fwrite(&stamp, sizeof(SourceStamp), 1, out);
+    writePadded(source.data(), source.size());
+  }
+  writePadded(texturePath.data(), texturePath.size());
+  fwrite(lodIndexCounts.data(), sizeof(GLuint), lodIndexCounts.size(), out);
+  fwrite(vertices, vertexStride, numVertices, out);
+  fwrite(indices, sizeof(GLuint), numIndices, out);
+
+  const bool ok = ferror(out) == 0;
+  if (fclose(out) != 0 || !ok) {
+    remove(tempFilename.c_str());
+    return false;
+  }
+#ifdef _WIN32
+  const bool renamed = MoveFileExA(tempFilename.c_str(), cacheFilename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  const bool renamed = rename(tempFilename.c_str(), cacheFilename.c_str()) == 0;
+#endif
+  if (!renamed) {
+    fprintf(stderr, "[WARN]: Could not replace mesh cache %s\n", cacheFilename.c_str());
+    remove(tempFilename.c_str());
+  }
+  return renamed;
+}
+
+#endif // MESH_CACHE_HPP
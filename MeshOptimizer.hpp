@@ -0,0 +1,298 @@
+/**
+ * @file MeshOptimizer.hpp
+ * @brief Load-time reordering of indexed triangle lists for the post-transform cache, overdraw, and vertex fetch
+ */
+
+#ifndef MESH_OPTIMIZER_HPP
+#define MESH_OPTIMIZER_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+/// \desc the passes run in this order, each one only moves indices or vertices around so the mesh draws the same:
+///   deduplicateVertices  merges vertices with identical bytes
+///   optimizeVertexCache  reorders triangles so recently transformed vertices get reused (Forsyth's linear-speed method)
+///   optimizeOverdraw     reorders the cache friendly runs so outward facing ones draw first and hide what is behind them
+///   optimizeVertexFetch  renumbers vertices in the order the indices first use them
+class MeshOptimizer {
+  public:
+    /// \desc merges vertices whose bytes are identical and points the indices at the survivors
+    /// \note Vertex must not have padding bytes
+    template <typename Vertex>
+    static void deduplicateVertices(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+    /// \desc reorders the triangles of one GL_TRIANGLES list in place for a small post-transform vertex cache
+    static void optimizeVertexCache(GLuint* indices, size_t numIndices, GLuint numVertices);
+
+    /// \desc reorders the runs optimizeVertexCache left (split where the cache starts over) so the runs facing out
+    /// of the mesh come first, keeping the order inside each run so the cache hits stay
+    static void optimizeOverdraw(GLuint* indices, size_t numIndices, const std::vector<glm::vec3>& positions);
+
+    /// \desc renumbers the vertices in the order the indices first use them and drops any that are never used
+    template <typename Vertex>
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+    /// \desc vertex shader runs per triangle through a FIFO cache of cacheSize vertices, 0.5 is ideal and 3 is no reuse
+    static GLfloat getAverageCacheMissRatio(const GLuint* indices, size_t numIndices, GLuint numVertices, GLuint cacheSize = 16);
+
+  private:
+    /// \desc vertices the Forsyth scoring models as cached
+    static constexpr GLuint CACHE_SIZE = 32;
+
+    /// \desc Forsyth's score of a vertex at cachePosition (-1 when not cached) with remainingValence triangles left
+    static GLfloat _vertexScore(int cachePosition, GLuint remainingValence);
+};
+
+template <typename Vertex>
+inline void MeshOptimizer::deduplicateVertices(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+  // FNV-1a over the vertex bytes, equality compares the bytes too so collisions can't merge different vertices
+  const auto hash = [&vertices](const GLuint v) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertices[v]);
+    std::uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(Vertex); i++) h = (h ^ bytes[i]) * 1099511628211ull;
+    return static_cast<size_t>(h);
+  };
+  const auto equal = [&vertices](const GLuint a, const GLuint b) {
+    return memcmp(&vertices[a], &vertices[b], sizeof(Vertex)) == 0;
+  };
+  std::unordered_map<GLuint, GLuint, decltype(hash), decltype(equal)> firstCopy(vertices.size(), hash, equal);
+
+  std::vector<GLuint> remap(vertices.size());
+  GLuint numUnique = 0;
+  for (GLuint v = 0; v < vertices.size(); v++) {
+    const auto found = firstCopy.find(v);
+    if (found != firstCopy.end()) {
+      remap[v] = remap[found->second];
+      continue;
+    }
+    firstCopy.emplace(v, v);
+    remap[v] = numUnique++;
+  }
+  if (numUnique == vertices.size()) return;
+
+  // survivors move down in order, each one's first copy is never behind where it lands
+  for (GLuint v = 0; v < vertices.size(); v++) {
+    vertices[remap[v]] = vertices[v];
+  }
+  vertices.resize(numUnique);
+  for (GLuint& index : indices) index = remap[index];
+}
+
+inline GLfloat MeshOptimizer::_vertexScore(const int cachePosition, const GLuint remainingValence) {
+  if (remainingValence == 0) return -1.0f;
+  GLfloat score = 0.0f;
+  if (cachePosition >= 0) {
+    // the last triangle's vertices get a fixed score so the strip doesn't just turn back on itself
+    if (cachePosition < 3) {
+      score = 0.75f;
+    } else {
+      const GLfloat scale = 1.0f / static_cast<GLfloat>(CACHE_SIZE - 3);
+      score = std::pow(1.0f - static_cast<GLfloat>(cachePosition - 3) * scale, 1.5f);
+    }
+  }
+  // vertices with few triangles left are finished off before they are left stranded
+  return score + 2.0f / std::sqrt(static_cast<GLfloat>(remainingValence));
+}
+
+inline void MeshOptimizer::optimizeVertexCache(GLuint* indices, const size_t numIndices, const GLuint numVertices) {
+  const GLuint numTriangles = static_cast<GLuint>(numIndices / 3);
+  if (numTriangles == 0) return;
+
+  // triangles around every vertex, counted then filled
+  std::vector<GLuint> triangleOffsets(numVertices + 1, 0);
+  for (size_t i = 0; i < numIndices; i++) triangleOffsets[indices[i] + 1]++;
+  for (GLuint v = 0; v < numVertices; v++) triangleOffsets[v + 1] += triangleOffsets[v];
+  std::vector<GLuint> triangleList(numIndices);
+  std::vector<GLuint> remainingValence(numVertices, 0);
+  for (size_t i = 0; i < numIndices; i++) {
+    const GLuint v = indices[i];
+    triangleList[triangleOffsets[v] + remainingValence[v]++] = static_cast<GLuint>(i / 3);
+  }
+
+  std::vector<int> cachePosition(numVertices, -1);
+  std::vector<GLfloat> vertexScores(numVertices);
+  for (GLuint v = 0; v < numVertices; v++) vertexScores[v] = _vertexScore(-1, remainingValence[v]);
+  std::vector<GLfloat> triangleScores(numTriangles);
+  for (GLuint t = 0; t < numTriangles; t++) {
+    triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+  }
+  std::vector<bool> emitted(numTriangles, false);
+  std::vector<GLuint> output;
+  output.reserve(numIndices);
+
+  // the cache plus room for the 3 vertices pushed in front of it
+  std::vector<GLuint> cache, nextCache;
+  cache.reserve(CACHE_SIZE + 3);
+  nextCache.reserve(CACHE_SIZE + 3);
+  GLuint scanCursor = 0;
+  GLuint bestTriangle = 0;
+  // start from the best triangle anywhere
+  for (GLuint t = 1; t < numTriangles; t++) {
+    if (triangleScores[t] > triangleScores[bestTriangle]) bestTriangle = t;
+  }
+
+  for (GLuint emittedCount = 0; emittedCount < numTriangles; emittedCount++) {
+    if (bestTriangle == numTriangles) {
+      // nothing left around the cache, carry on from the first triangle not drawn yet
+      while (emitted[scanCursor]) scanCursor++;
+      bestTriangle = scanCursor;
+    }
+    const GLuint* corners = indices + bestTriangle * 3;
+    emitted[bestTriangle] = true;
+    output.insert(output.end(), corners, corners + 3);
+
+    // the triangle's vertices go to the front of the cache and lose it from their remaining triangles
+    nextCache.assign(corners, corners + 3);
+    for (int c = 0; c < 3; c++) {
+      const GLuint v = corners[c];
+      GLuint* first = &triangleList[triangleOffsets[v]];
+      GLuint* last = first + remainingValence[v];
+      std::iter_swap(std::find(first, last, bestTriangle), last - 1);
+      remainingValence[v]--;
+    }
+    for (const GLuint v : cache) {
+      if (v != corners[0] && v != corners[1] && v != corners[2]) nextCache.push_back(v);
+    }
+    for (GLuint i = 0; i < nextCache.size(); i++) {
+      const GLuint v = nextCache[i];
+      cachePosition[v] = i < CACHE_SIZE ? static_cast<int>(i) : -1;
+    }
+    if (nextCache.size() > CACHE_SIZE) {
+      // the ones pushed out are rescored as uncached and leave the cache
+      for (GLuint i = CACHE_SIZE; i < nextCache.size(); i++) {
+        const GLuint v = nextCache[i];
+        vertexScores[v] = _vertexScore(-1, remainingValence[v]);
+        for (GLuint j = 0; j < remainingValence[v]; j++) {
+          const GLuint t = triangleList[triangleOffsets[v] + j];
+          triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        }
+      }
+      nextCache.resize(CACHE_SIZE);
+    }
+    cache.swap(nextCache);
+
+    // rescore what is cached and pick the best triangle that touches it
+    for (const GLuint v : cache) vertexScores[v] = _vertexScore(cachePosition[v], remainingValence[v]);
+    bestTriangle = numTriangles;
+    GLfloat bestScore = -1.0f;
+    for (const GLuint v : cache) {
+      for (GLuint j = 0; j < remainingValence[v]; j++) {
+        const GLuint t = triangleList[triangleOffsets[v] + j];
+        const GLfloat score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        triangleScores[t] = score;
+        if (score > bestScore) {
+          bestScore = score;
+          bestTriangle = t;
+        }
+      }
+    }
+  }
+  std::copy(output.begin(), output.end(), indices);
+}
+
+inline void MeshOptimizer::optimizeOverdraw(GLuint* indices, const size_t numIndices, const std::vector<glm::vec3>& positions) {
+  const GLuint numTriangles = static_cast<GLuint>(numIndices / 3);
+  if (numTriangles < 2) return;
+
+  // a run ends where a triangle misses the cache on all three vertices, the cache order jumped somewhere new there
+  std::vector<GLuint> runStarts;
+  std::vector<GLuint> fifo(16, 0xFFFFFFFF);
+  GLuint fifoHead = 0;
+  for (GLuint t = 0; t < numTriangles; t++) {
+    GLuint misses = 0;
+    for (int c = 0; c < 3; c++) {
+      const GLuint v = indices[t * 3 + c];
+      if (std::find(fifo.begin(), fifo.end(), v) != fifo.end()) continue;
+      fifo[fifoHead] = v;
+      fifoHead = (fifoHead + 1) % fifo.size();
+      misses++;
+    }
+    if (t == 0 || misses == 3) runStarts.push_back(t);
+  }
+  runStarts.push_back(numTriangles);
+  const GLuint numRuns = static_cast<GLuint>(runStarts.size() - 1);
+  if (numRuns < 2) return;
+
+  // area weighted centers and normals of the mesh and of every run
+  glm::vec3 meshCenter(0.0f);
+  GLfloat meshArea = 0.0f;
+  std::vector<glm::vec3> runCenters(numRuns, glm::vec3(0.0f)), runNormals(numRuns, glm::vec3(0.0f));
+  std::vector<GLfloat> runAreas(numRuns, 0.0f);
+  for (GLuint run = 0; run < numRuns; run++) {
+    for (GLuint t = runStarts[run]; t < runStarts[run + 1]; t++) {
+      const glm::vec3& p0 = positions[indices[t * 3]];
+      const glm::vec3& p1 = positions[indices[t * 3 + 1]];
+      const glm::vec3& p2 = positions[indices[t * 3 + 2]];
+      const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+      const GLfloat area = glm::length(normal);
+      runCenters[run] += (p0 + p1 + p2) * (area / 3.0f);
+      runNormals[run] += normal;
+      runAreas[run] += area;
+    }
+    meshCenter += runCenters[run];
+    meshArea += runAreas[run];
+  }
+  if (meshArea <= 0.0f) return;
+  meshCenter /= meshArea;
+
+  // runs that face away from the center are on the outside, drawing them first lets the depth test skip what they hide
+  std::vector<std::pair<GLfloat, GLuint>> order(numRuns);
+  for (GLuint run = 0; run < numRuns; run++) {
+    const glm::vec3 center = runAreas[run] > 0.0f ? runCenters[run] / runAreas[run] : meshCenter;
+    const GLfloat normalLength = glm::length(runNormals[run]);
+    const glm::vec3 normal = normalLength > 0.0f ? runNormals[run] / normalLength : glm::vec3(0.0f);
+    order[run] = {-glm::dot(center - meshCenter, normal), run};
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const std::pair<GLfloat, GLuint>& a, const std::pair<GLfloat, GLuint>& b) { return a.first < b.first; });
+
+  std::vector<GLuint> output;
+  output.reserve(numIndices);
+  for (const std::pair<GLfloat, GLuint>& entry : order) {
+    output.insert(output.end(), indices + runStarts[entry.second] * 3, indices + runStarts[entry.second + 1] * 3);
+  }
+  std::copy(output.begin(), output.end(), indices);
+}
+
+template <typename Vertex>
+inline void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+  const GLuint unassigned = 0xFFFFFFFF;
+  std::vector<GLuint> remap(vertices.size(), unassigned);
+  std::vector<Vertex> reordered;
+  reordered.reserve(vertices.size());
+  for (GLuint& index : indices) {
+    if (remap[index] == unassigned) {
+      remap[index] = static_cast<GLuint>(reordered.size());
+      reordered.push_back(vertices[index]);
+    }
+    index = remap[index];
+  }
+  vertices.swap(reordered);
+}
+
+inline GLfloat MeshOptimizer::getAverageCacheMissRatio(const GLuint* indices, const size_t numIndices, const GLuint numVertices,
+                                                       const GLuint cacheSize) {
+  if (numIndices < 3) return 0.0f;
+  // the frame a vertex last went into the FIFO, a vertex is cached while fewer than cacheSize misses came after it
+  std::vector<size_t> insertedAt(numVertices, 0);
+  std::vector<bool> seen(numVertices, false);
+  size_t misses = 0;
+  for (size_t i = 0; i < numIndices; i++) {
+    const GLuint v = indices[i];
+    if (seen[v] && misses - insertedAt[v] < cacheSize) continue;
+    seen[v] = true;
+    insertedAt[v] = misses;
+    misses++;
+  }
+  return static_cast<GLfloat>(misses) / static_cast<GLfloat>(numIndices / 3);
+}
+
+#endif // MESH_OPTIMIZER_HPP
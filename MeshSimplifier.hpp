@@ -0,0 +1,220 @@
+/**
+ * @file MeshSimplifier.hpp
+ * @brief Quadric error metric simplification of indexed triangle lists for levels of detail
+ */
+
+#ifndef MESH_SIMPLIFIER_HPP
+#define MESH_SIMPLIFIER_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/// \desc collapses edges cheapest first by the quadric error (sum of squared distances to the original triangles'
+/// planes) they add. Every edge collapses onto one of its own two vertices, so a simplified list indexes the same
+/// vertex buffer as the full mesh and levels of detail only differ in their indices. Vertices on open borders or
+/// on attribute seams (several vertices at one position) never move, which keeps parts and UV islands together
+class MeshSimplifier {
+  public:
+    /// \desc simplifies a GL_TRIANGLES index list
+    /// \param positions position of every vertex the indices refer to
+    /// \param indices triangles to simplify, 3 indices each
+    /// \param targetIndexCount stop once the list is at most this long
+    /// \param maxError stop before a collapse would move the surface further than this from where it was
+    /// \return the simplified list, longer than the target if the error limit or locked vertices stopped it first
+    static std::vector<GLuint> simplify(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices,
+                                        size_t targetIndexCount, GLfloat maxError);
+
+  private:
+    /// \desc symmetric 4x4 matrix summing squared plane distances, upper triangle only
+    struct Quadric {
+      double a[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+      void addPlane(const glm::vec3& normal, GLfloat distance);
+      void add(const Quadric& other);
+      double error(const glm::vec3& p) const;
+    };
+
+    /// \desc moving vertex from onto vertex to
+    struct Collapse {
+      GLuint from;
+      GLuint to;
+      double error;
+    };
+
+    /// \desc marks vertices on open edges or sharing their position with another vertex
+    static std::vector<bool> _findLockedVertices(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices);
+    /// \desc true if moving from onto to turns any of from's other triangles over (or nearly flat)
+    static bool _flips(const Collapse& collapse, const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices,
+                       const std::vector<GLuint>& triangleOffsets, const std::vector<GLuint>& triangleList);
+};
+
+inline void MeshSimplifier::Quadric::addPlane(const glm::vec3& normal, const GLfloat distance) {
+  const double x = normal.x, y = normal.y, z = normal.z, w = distance;
+  a[0] += x * x; a[1] += x * y; a[2] += x * z; a[3] += x * w;
+  a[4] += y * y; a[5] += y * z; a[6] += y * w;
+  a[7] += z * z; a[8] += z * w;
+  a[9] += w * w;
+}
+
+inline void MeshSimplifier::Quadric::add(const Quadric& other) {
+  for (int i = 0; i < 10; i++) a[i] += other.a[i];
+}
+
+inline double MeshSimplifier::Quadric::error(const glm::vec3& p) const {
+  const double x = p.x, y = p.y, z = p.z;
+  // p^T Q p with p = (x, y, z, 1), off diagonal terms counted twice
+  return a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x +
+         a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y +
+         a[7] * z * z + 2.0 * a[8] * z +
+         a[9];
+}
+
+inline std::vector<bool> MeshSimplifier::_findLockedVertices(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices) {
+  std::vector<bool> locked(positions.size(), false);
+
+  // seams: the OBJ loader splits a position into one vertex per normal/texCoord pair
+  std::map<std::tuple<GLfloat, GLfloat, GLfloat>, GLuint> firstAtPosition;
+  for (GLuint v = 0; v < positions.size(); v++) {
+    const auto inserted = firstAtPosition.emplace(std::make_tuple(positions[v].x, positions[v].y, positions[v].z), v);
+    if (!inserted.second) {
+      locked[v] = true;
+      locked[inserted.first->second] = true;
+    }
+  }
+
+  // borders: edges used by only one triangle
+  std::unordered_map<std::uint64_t, GLuint> edgeUses;
+  for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+    for (int e = 0; e < 3; e++) {
+      const GLuint a = indices[t + e], b = indices[t + (e + 1) % 3];
+      edgeUses[(static_cast<std::uint64_t>(std::min(a, b)) << 32) | std::max(a, b)]++;
+    }
+  }
+  for (const auto& edge : edgeUses) {
+    if (edge.second != 1) continue;
+    locked[static_cast<GLuint>(edge.first >> 32)] = true;
+    locked[static_cast<GLuint>(edge.first & 0xFFFFFFFF)] = true;
+  }
+  return locked;
+}
+
+inline bool MeshSimplifier::_flips(const Collapse& collapse, const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices,
+                                   const std::vector<GLuint>& triangleOffsets, const std::vector<GLuint>& triangleList) {
+  for (GLuint i = triangleOffsets[collapse.from]; i < triangleOffsets[collapse.from + 1]; i++) {
+    const GLuint t = triangleList[i] * 3;
+    const GLuint corners[3] = {indices[t], indices[t + 1], indices[t + 2]};
+    // triangles on the edge itself disappear instead of turning
+    if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to) continue;
+    glm::vec3 before[3], after[3];
+    for (int c = 0; c < 3; c++) {
+      before[c] = positions[corners[c]];
+      after[c] = corners[c] == collapse.from ? positions[collapse.to] : before[c];
+    }
+    const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+    const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+    // more than ~78 degrees of turn is as good as a fold
+    if (glm::dot(normalBefore, normalAfter) < 0.2f * glm::length(normalBefore) * glm::length(normalAfter)) return true;
+  }
+  return false;
+}
+
+inline std::vector<GLuint> MeshSimplifier::simplify(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices,
+                                                    const size_t targetIndexCount, const GLfloat maxError) {
+  std::vector<GLuint> result(indices);
+  const GLuint numVertices = static_cast<GLuint>(positions.size());
+  const std::vector<bool> locked = _findLockedVertices(positions, indices);
+
+  // every vertex starts with the planes of the triangles around it, collapses then merge the sums
+  std::vector<Quadric> quadrics(numVertices);
+  for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+    const glm::vec3& p0 = positions[indices[t]];
+    const glm::vec3 normal = glm::cross(positions[indices[t + 1]] - p0, positions[indices[t + 2]] - p0);
+    const GLfloat length = glm::length(normal);
+    if (length <= 0.0f) continue;
+    const glm::vec3 unitNormal = normal / length;
+    for (int c = 0; c < 3; c++) {
+      quadrics[indices[t + c]].addPlane(unitNormal, -glm::dot(unitNormal, p0));
+    }
+  }
+
+  const double maxErrorSquared = static_cast<double>(maxError) * maxError;
+  std::vector<Collapse> collapses;
+  std::vector<GLuint> triangleOffsets(numVertices + 1);
+  std::vector<GLuint> triangleList;
+  std::vector<bool> touched(numVertices);
+  std::vector<GLuint> remap(numVertices);
+
+  // passes of independent collapses, each pass only moves vertices whose triangles nothing else moved this pass
+  while (result.size() > targetIndexCount) {
+    const GLuint numTriangles = static_cast<GLuint>(result.size() / 3);
+
+    // the cheaper direction of every edge that has one, an edge shared by two triangles is just listed twice
+    collapses.clear();
+    for (GLuint t = 0; t < numTriangles; t++) {
+      for (int e = 0; e < 3; e++) {
+        const GLuint a = result[t * 3 + e], b = result[t * 3 + (e + 1) % 3];
+        if (locked[a] && locked[b]) continue;
+        Quadric merged = quadrics[a];
+        merged.add(quadrics[b]);
+        const double aToB = locked[a] ? -1.0 : merged.error(positions[b]);
+        const double bToA = locked[b] ? -1.0 : merged.error(positions[a]);
+        if (bToA < 0.0 || (aToB >= 0.0 && aToB <= bToA)) collapses.push_back({a, b, aToB});
+        else collapses.push_back({b, a, bToA});
+      }
+    }
+    if (collapses.empty()) break;
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+    // triangles around each vertex, counted then filled
+    std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+    for (const GLuint v : result) triangleOffsets[v + 1]++;
+    for (GLuint v = 0; v < numVertices; v++) triangleOffsets[v + 1] += triangleOffsets[v];
+    triangleList.resize(result.size());
+    std::vector<GLuint> filled(triangleOffsets.begin(), triangleOffsets.end() - 1);
+    for (GLuint i = 0; i < result.size(); i++) triangleList[filled[result[i]]++] = i / 3;
+
+    std::fill(touched.begin(), touched.end(), false);
+    for (GLuint v = 0; v < numVertices; v++) remap[v] = v;
+    const size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+    size_t removed = 0;
+    for (const Collapse& collapse : collapses) {
+      if (collapse.error > maxErrorSquared || removed >= trianglesToRemove) break;
+      if (touched[collapse.from] || touched[collapse.to]) continue;
+      if (_flips(collapse, positions, result, triangleOffsets, triangleList)) continue;
+
+      remap[collapse.from] = collapse.to;
+      quadrics[collapse.to].add(quadrics[collapse.from]);
+      // every corner of the moved triangles sits still for the rest of the pass so the adjacency stays true
+      for (GLuint i = triangleOffsets[collapse.from]; i < triangleOffsets[collapse.from + 1]; i++) {
+        const GLuint t = triangleList[i] * 3;
+        bool onEdge = false;
+        for (int c = 0; c < 3; c++) {
+          touched[result[t + c]] = true;
+          onEdge = onEdge || result[t + c] == collapse.to;
+        }
+        if (onEdge) removed++;
+      }
+    }
+    if (removed == 0) break;
+
+    // move the collapsed corners and drop the triangles that folded to a line
+    size_t kept = 0;
+    for (size_t t = 0; t < result.size(); t += 3) {
+      const GLuint a = remap[result[t]], b = remap[result[t + 1]], c = remap[result[t + 2]];
+      if (a == b || b == c || a == c) continue;
+      result[kept++] = a;
+      result[kept++] = b;
+      result[kept++] = c;
+    }
+    result.resize(kept);
+  }
+  return result;
+}
+
+#endif // MESH_SIMPLIFIER_HPP
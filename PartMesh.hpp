@@ -0,0 +1,593 @@
+/**
+ * @file PartMesh.hpp
+ * @brief Several OBJ files merged into one rigidly skinned mesh drawn with a single call
+ */
+
+#ifndef PART_MESH_HPP
+#define PART_MESH_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <stb_image.h>
+
+#include "AssetLoader.hpp"
+#include "Frustum.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "TextureCooker.hpp"
+#include "VertexFormat.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/// \desc every vertex is tagged with the index of the file (part) it came from so the vertex shader can
+/// pick that part's matrix out of a uniform array, letting an articulated model draw in one call.
+/// loading also simplifies the merged mesh into coarser levels of detail that share its vertex buffer, and
+/// reorders every level for the vertex cache and overdraw before it is uploaded or cached
+class PartMesh {
+  public:
+    /// \desc most parts a mesh can hold, must match MAX_PARTS in the shader
+    static constexpr GLuint MAX_PARTS = 16;
+    /// \desc most levels of detail a mesh gets, level 0 is the full mesh
+    static constexpr GLuint MAX_LODS = 4;
+
+    PartMesh();
+    ~PartMesh();
+
+    /// \desc parses every OBJ file and merges them into one vertex/index buffer, file i becomes part i
+    /// \param filenames OBJ files to merge, at most MAX_PARTS
+    /// \param cacheFilename binary MeshCache to load instead of parsing while it is newer than the OBJ files,
+    /// (re)written after parsing otherwise. Leave empty to always parse
+    /// \return true if every file loaded
+    /// \note every part is drawn with the first diffuse texture found in the materials
+    bool loadPartFiles(const std::vector<std::string>& filenames, const std::string& cacheFilename = "");
+
+    /// \desc same as loadPartFiles but every file is parsed (and the texture decoded) on the loader's workers,
+    /// the buffers and texture are created when the GL thread runs loader.processUploads() or loader.finish()
+    /// \note errors are printed from the workers and leave the mesh unloaded, check isLoaded() after finish()
+    void loadPartFilesAsync(AssetLoader& loader, const std::vector<std::string>& filenames, const std::string& cacheFilename = "");
+
+    /// \desc format the vertices are packed in when they are uploaded (compact unless set), call before loading
+    void setVertexFormat(const VertexFormat& format) { _vertexFormat = format; }
+    /// \desc what the shader needs to decode the packed vertices, valid once the mesh is loaded
+    const VertexDecode& getVertexDecode() const { return _packer.getDecode(); }
+
+    /// \desc hooks the merged buffers up to the shader attributes, if the mesh is still loading they are hooked up once it is uploaded
+    void setAttributeLocations(GLint positionLocation, GLint normalLocation, GLint texCoordLocation, GLint partIndexLocation);
+
+    /// \desc true once the merged buffers are on the GPU
+    bool isLoaded() const { return _vao != 0; }
+
+    /// \desc binds the texture (if any) to texture unit 0 and draws every part in one call at full detail
+    void draw() const;
+
+    GLuint getNumParts() const { return _numParts; }
+
+    /// \desc the pieces draw() uses, for submitting the mesh to a RenderQueue instead
+    GLuint getVAO() const { return _vao; }
+    GLuint getTexture() const { return _texture; }
+    /// \desc number of GL_UNSIGNED_INT indices in a level of detail, drawn as GL_TRIANGLES
+    GLsizei getNumIndices(GLuint lod = 0) const { return _lodNumIndices[lod]; }
+    /// \desc where a level of detail starts in the index buffer (in indices, not bytes)
+    GLuint getFirstIndex(GLuint lod) const { return _lodFirstIndex[lod]; }
+    GLuint getNumLods() const { return _numLods; }
+
+    /// \desc level of detail for the mesh covering screenFraction of the screen height. A switch only happens
+    /// once the size is clearly past the switch point so a mesh sitting right on it doesn't flicker between levels
+    /// \param currentLod level drawn last frame
+    GLuint selectLod(GLuint currentLod, GLfloat screenFraction) const;
+
+    /// \desc sphere around one part in the part's own model space, computed when the buffers are uploaded
+    const BoundingSphere& getPartBounds(GLuint part) const { return _partBounds[part]; }
+
+  private:
+    /// \desc interleaved vertex layout the mesh is built and cached in, packed into _vertexFormat for the GPU
+    struct Vertex {
+      glm::vec3 position;
+      glm::vec3 normal;
+      glm::vec2 texCoord;
+      GLfloat partIndex;
+    };
+
+    GLuint _vao;
+    GLuint _vbo;
+    GLuint _ibo;
+    GLuint _texture;
+    GLuint _numParts;
+    /// \desc index range of every level of detail in the shared index buffer
+    GLuint _lodFirstIndex[MAX_LODS];
+    GLsizei _lodNumIndices[MAX_LODS];
+    GLuint _numLods;
+    /// \desc position, normal, texCoord, and part index attribute locations (-1 until set)
+    GLint _attributeLocations[4];
+    VertexFormat _vertexFormat;
+    /// \desc layout of the uploaded vertices, its bytes are freed after the upload
+    VertexPacker _packer;
+    /// \desc bounds of every part, empty spheres for parts that have no vertices
+    BoundingSphere _partBounds[MAX_PARTS];
+
+    /// \desc appends one OBJ file to the vertex and index lists with every vertex tagged as part
+    /// \param texturePath set to the first diffuse map found if it is still empty
+    static bool _parseObj(const std::string& filename, GLfloat part, std::vector<Vertex>& vertices, std::vector<GLuint>& indices, std::string& texturePath);
+    /// \desc runs once per merged mesh before it is uploaded or cached: merges duplicate vertices, builds the levels
+    /// of detail, then reorders each level's triangles and finally the vertices (see MeshOptimizer)
+    /// \return the number of indices in every level, the full mesh first
+    static std::vector<GLuint> _optimizeMesh(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+    /// \desc simplifies the full mesh in indices into coarser levels of detail and appends them to indices
+    /// \return the number of indices in every level, the full mesh first
+    static std::vector<GLuint> _buildLods(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+    /// \desc creates the VAO and uploads the merged buffers, indices holds every level of detail back to back
+    void _uploadBuffers(const void* vertices, GLuint numVertices, const GLuint* indices, GLuint numIndices,
+                        const std::vector<GLuint>& lodIndexCounts);
+    /// \desc points the VAO at the stored attribute locations
+    void _applyAttributeLocations() const;
+    /// \desc decodes the texture on a worker and creates it on the GL thread
+    void _loadTextureAsync(AssetLoader& loader, const std::string& texturePath);
+    /// \desc reads the cooked texture next to texturePath (texturePath + ".ctex"), cooking and writing it first
+    /// if it is missing or stale. Safe off the GL thread
+    /// \return nullptr if the image can't be decoded
+    static std::shared_ptr<TextureCooker::Cooked> _cookTexture(const std::string& texturePath);
+    /// \desc creates _texture from the cooked levels
+    void _uploadTexture(const TextureCooker::Cooked& cooked);
+    /// \desc finds the first map_Kd in an MTL file, returns an empty string if there is none
+    static std::string _findDiffuseMap(const std::string& mtlFilename);
+    /// \desc directory part of a path including the trailing slash
+    static std::string _directoryOf(const std::string& filename);
+};
+
+inline PartMesh::PartMesh() :
+  _vao(0),
+  _vbo(0),
+  _ibo(0),
+  _texture(0),
+  _numParts(0),
+  _lodFirstIndex(),
+  _lodNumIndices(),
+  _numLods(0),
+  _attributeLocations{-1, -1, -1, -1} {
+}
+
+inline PartMesh::~PartMesh() {
+  glDeleteVertexArrays(1, &_vao);
+  glDeleteBuffers(1, &_vbo);
+  glDeleteBuffers(1, &_ibo);
+  glDeleteTextures(1, &_texture);
+}
+
+inline bool PartMesh::loadPartFiles(const std::vector<std::string>& filenames, const std::string& cacheFilename) {
+  if (filenames.size() > MAX_PARTS) {
+    fprintf(stderr, "[ERROR]: PartMesh can hold at most %u parts, got %zu\n", MAX_PARTS, filenames.size());
+    return false;
+  }
+
+  // an up to date cache goes straight from the mapped file to the GPU without any parsing
+  if (!cacheFilename.empty()) {
+    MeshCache cache;
+    MeshCache::Contents contents;
+    if (cache.open(cacheFilename, filenames, sizeof(Vertex), contents) && contents.numParts == filenames.size()) {
+      _numParts = contents.numParts;
+      _uploadBuffers(contents.vertices, contents.numVertices, contents.indices, contents.numIndices, contents.lodIndexCounts);
+      if (!contents.texturePath.empty()) {
+        const std::shared_ptr<TextureCooker::Cooked> cooked = _cookTexture(contents.texturePath);
+        if (cooked) _uploadTexture(*cooked);
+      }
+      fprintf(stdout, "[INFO]: loaded %u parts from mesh cache %s\n", _numParts, cacheFilename.c_str());
+      return true;
+    }
+  }
+
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
+  std::string texturePath;
+  for (size_t i = 0; i < filenames.size(); i++) {
+    if (!_parseObj(filenames[i], static_cast<GLfloat>(i), vertices, indices, texturePath)) {
+      return false;
+    }
+  }
+  const size_t fullTriangles = indices.size() / 3;
+  const std::vector<GLuint> lodIndexCounts = _optimizeMesh(vertices, indices);
+  _numParts = static_cast<GLuint>(filenames.size());
+  _uploadBuffers(vertices.data(), static_cast<GLuint>(vertices.size()), indices.data(), static_cast<GLuint>(indices.size()), lodIndexCounts);
+  if (!texturePath.empty()) {
+    const std::shared_ptr<TextureCooker::Cooked> cooked = _cookTexture(texturePath);
+    if (cooked) _uploadTexture(*cooked);
+  }
+  fprintf(stdout, "[INFO]: merged %u parts into %zu vertices and %zu triangles, %u levels of detail\n",
+          _numParts, vertices.size(), fullTriangles, _numLods);
+
+  // save the parsed result so the next run can skip parsing and simplifying
+  if (!cacheFilename.empty()) {
+    MeshCache::write(cacheFilename, filenames, sizeof(Vertex),
+                     vertices.data(), static_cast<GLuint>(vertices.size()),
+                     indices.data(), static_cast<GLuint>(indices.size()),
+                     lodIndexCounts, _numParts, texturePath);
+  }
+  return true;
+}
+
+inline std::vector<GLuint> PartMesh::_optimizeMesh(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+  // the loader only merges repeated index triplets within a file, identical vertices can still come from different ones
+  MeshOptimizer::deduplicateVertices(vertices, indices);
+  const std::vector<GLuint> lodIndexCounts = _buildLods(vertices, indices);
+
+  std::vector<glm::vec3> positions(vertices.size());
+  for (size_t i = 0; i < vertices.size(); i++) positions[i] = vertices[i].position;
+  const GLuint numVertices = static_cast<GLuint>(vertices.size());
+  const GLfloat missRatioBefore = MeshOptimizer::getAverageCacheMissRatio(indices.data(), lodIndexCounts[0], numVertices);
+  size_t firstIndex = 0;
+  for (const GLuint count : lodIndexCounts) {
+    MeshOptimizer::optimizeVertexCache(indices.data() + firstIndex, count, numVertices);
+    MeshOptimizer::optimizeOverdraw(indices.data() + firstIndex, count, positions);
+    firstIndex += count;
+  }
+  // the full mesh comes first so its vertices are numbered in its order, every coarser level only uses a subset of them
+  MeshOptimizer::optimizeVertexFetch(vertices, indices);
+  fprintf(stdout, "[INFO]: vertex cache misses per triangle %.2f -> %.2f\n", missRatioBefore,
+          MeshOptimizer::getAverageCacheMissRatio(indices.data(), lodIndexCounts[0], static_cast<GLuint>(vertices.size())));
+  return lodIndexCounts;
+}
+
+inline std::vector<GLuint> PartMesh::_buildLods(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+  // share of the full index count each level aims for, and the most it may move the surface as a share of the mesh size
+  const GLfloat targetRatios[MAX_LODS] = {1.0f, 0.5f, 0.25f, 0.1f};
+  const GLfloat errorRatios[MAX_LODS] = {0.0f, 0.005f, 0.015f, 0.04f};
+
+  std::vector<glm::vec3> positions(vertices.size());
+  BoundingBox box;
+  for (size_t i = 0; i < vertices.size(); i++) {
+    positions[i] = vertices[i].position;
+    box.expand(positions[i]);
+  }
+  const GLfloat meshSize = box.isEmpty() ? 0.0f : glm::length(box.max - box.min);
+
+  std::vector<GLuint> lodIndexCounts = {static_cast<GLuint>(indices.size())};
+  // each level starts from the one before, it is already most of the way there
+  std::vector<GLuint> previous(indices);
+  for (GLuint lod = 1; lod < MAX_LODS; lod++) {
+    const size_t target = static_cast<size_t>(lodIndexCounts[0] * targetRatios[lod]) / 3 * 3;
+    std::vector<GLuint> simplified = MeshSimplifier::simplify(positions, previous, target, meshSize * errorRatios[lod]);
+    // a level that barely saves anything isn't worth switching to, and the ones after it won't do better
+    if (simplified.empty() || simplified.size() * 10 > previous.size() * 9) break;
+    indices.insert(indices.end(), simplified.begin(), simplified.end());
+    lodIndexCounts.push_back(static_cast<GLuint>(simplified.size()));
+    previous.swap(simplified);
+  }
+  return lodIndexCounts;
+}
+
+inline GLuint PartMesh::selectLod(const GLuint currentLod, const GLfloat screenFraction) const {
+  if (_numLods == 0) return 0;
+  // level i is wanted once the mesh covers less than this share of the screen height
+  const GLfloat switchFractions[MAX_LODS] = {1.0f, 0.3f, 0.15f, 0.06f};
+  // how far past a switch point the size has to be before switching
+  const GLfloat hysteresis = 0.15f;
+  GLuint lod = std::min(currentLod, _numLods - 1);
+  while (lod + 1 < _numLods && screenFraction < switchFractions[lod + 1] * (1.0f - hysteresis)) lod++;
+  while (lod > 0 && screenFraction > switchFractions[lod] * (1.0f + hysteresis)) lod--;
+  return lod;
+}
+
+inline void PartMesh::_uploadBuffers(const void* vertices, const GLuint numVertices, const GLuint* indices, const GLuint numIndices,
+                                     const std::vector<GLuint>& lodIndexCounts) {
+  _numLods = 0;
+  GLuint firstIndex = 0;
+  for (const GLuint count : lodIndexCounts) {
+    if (_numLods == MAX_LODS) break;
+    _lodFirstIndex[_numLods] = firstIndex;
+    _lodNumIndices[_numLods] = static_cast<GLsizei>(count);
+    firstIndex += count;
+    _numLods++;
+  }
+
+  // boxes first, then the spheres around their centers are tighter than the box corners
+  const Vertex* vertexData = static_cast<const Vertex*>(vertices);
+  BoundingBox partBoxes[MAX_PARTS];
+  for (GLuint i = 0; i < numVertices; i++) {
+    const GLuint part = static_cast<GLuint>(vertexData[i].partIndex);
+    if (part < MAX_PARTS) partBoxes[part].expand(vertexData[i].position);
+  }
+  for (GLuint part = 0; part < MAX_PARTS; part++) {
+    _partBounds[part] = BoundingSphere();
+    if (partBoxes[part].isEmpty()) continue;
+    _partBounds[part].center = partBoxes[part].getCenter();
+  }
+  for (GLuint i = 0; i < numVertices; i++) {
+    const GLuint part = static_cast<GLuint>(vertexData[i].partIndex);
+    if (part >= MAX_PARTS) continue;
+    _partBounds[part].radius = std::max(_partBounds[part].radius, glm::length(vertexData[i].position - _partBounds[part].center));
+  }
+
+  _packer.pack(_vertexFormat,
+               (1u << VertexPacker::POSITION) | (1u << VertexPacker::NORMAL) | (1u << VertexPacker::TEX_COORD) | (1u << VertexPacker::PART_INDEX),
+               numVertices, [vertexData](const GLuint i) {
+                 VertexPacker::Source source;
+                 source.position = vertexData[i].position;
+                 source.normal = vertexData[i].normal;
+                 source.texCoord = vertexData[i].texCoord;
+                 source.partIndex = vertexData[i].partIndex;
+                 return source;
+               });
+  _packer.printSavings("PartMesh");
+
+  glGenVertexArrays(1, &_vao);
+  glBindVertexArray(_vao);
+  glGenBuffers(1, &_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_packer.getBytes().size()), _packer.getBytes().data(), GL_STATIC_DRAW);
+  _packer.releaseBytes();
+  glGenBuffers(1, &_ibo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(GLuint), indices, GL_STATIC_DRAW);
+  glBindVertexArray(0);
+  _applyAttributeLocations();
+}
+
+inline void PartMesh::loadPartFilesAsync(AssetLoader& loader, const std::vector<std::string>& filenames, const std::string& cacheFilename) {
+  if (filenames.size() > MAX_PARTS) {
+    fprintf(stderr, "[ERROR]: PartMesh can hold at most %u parts, got %zu\n", MAX_PARTS, filenames.size());
+    return;
+  }
+
+  // every part is parsed into its own lists by its own job, the last job to finish merges them
+  struct PendingParts {
+    std::vector<std::string> filenames;
+    std::string cacheFilename;
+    std::vector<std::vector<Vertex>> vertices;
+    std::vector<std::vector<GLuint>> indices;
+    std::vector<std::string> texturePaths;
+    std::atomic<GLuint> remaining;
+    std::atomic<bool> failed;
+  };
+  auto pending = std::make_shared<PendingParts>();
+  pending->filenames = filenames;
+  pending->cacheFilename = cacheFilename;
+  pending->vertices.resize(filenames.size());
+  pending->indices.resize(filenames.size());
+  pending->texturePaths.resize(filenames.size());
+  pending->remaining = static_cast<GLuint>(filenames.size());
+  pending->failed = false;
+
+  AssetLoader* pLoader = &loader;
+  loader.submit([this, pLoader, pending]() -> AssetLoader::Upload {
+    // an up to date cache skips parsing entirely, the mapping stays open until the upload has read it
+    if (!pending->cacheFilename.empty()) {
+      auto cache = std::make_shared<MeshCache>();
+      MeshCache::Contents contents;
+      if (cache->open(pending->cacheFilename, pending->filenames, sizeof(Vertex), contents) && contents.numParts == pending->filenames.size()) {
+        _loadTextureAsync(*pLoader, contents.texturePath);
+        return [this, cache, contents, pending]() {
+          _numParts = contents.numParts;
+          _uploadBuffers(contents.vertices, contents.numVertices, contents.indices, contents.numIndices, contents.lodIndexCounts);
+          fprintf(stdout, "[INFO]: loaded %u parts from mesh cache %s\n", _numParts, pending->cacheFilename.c_str());
+        };
+      }
+    }
+
+    for (size_t i = 0; i < pending->filenames.size(); i++) {
+      pLoader->submit([this, pLoader, pending, i]() -> AssetLoader::Upload {
+        if (!_parseObj(pending->filenames[i], static_cast<GLfloat>(i), pending->vertices[i], pending->indices[i], pending->texturePaths[i])) {
+          pending->failed = true;
+        }
+        if (--pending->remaining != 0 || pending->failed) return nullptr;
+
+        // last part done, merge everything by offsetting each part's indices past the earlier parts' vertices
+        auto vertices = std::make_shared<std::vector<Vertex>>();
+        auto indices = std::make_shared<std::vector<GLuint>>();
+        std::string texturePath;
+        for (size_t part = 0; part < pending->filenames.size(); part++) {
+          const GLuint base = static_cast<GLuint>(vertices->size());
+          vertices->insert(vertices->end(), pending->vertices[part].begin(), pending->vertices[part].end());
+          for (const GLuint index : pending->indices[part]) {
+            indices->push_back(base + index);
+          }
+          if (texturePath.empty()) texturePath = pending->texturePaths[part];
+        }
+        _loadTextureAsync(*pLoader, texturePath);
+        // simplifying and reordering are the slowest part of loading, they stay on this worker with the merge
+        const size_t fullTriangles = indices->size() / 3;
+        auto lodIndexCounts = std::make_shared<std::vector<GLuint>>(_optimizeMesh(*vertices, *indices));
+        if (!pending->cacheFilename.empty()) {
+          MeshCache::write(pending->cacheFilename, pending->filenames, sizeof(Vertex),
+                           vertices->data(), static_cast<GLuint>(vertices->size()),
+                           indices->data(), static_cast<GLuint>(indices->size()),
+                           *lodIndexCounts, static_cast<GLuint>(pending->filenames.size()), texturePath);
+        }
+        return [this, vertices, indices, lodIndexCounts, fullTriangles, pending]() {
+          _numParts = static_cast<GLuint>(pending->filenames.size());
+          _uploadBuffers(vertices->data(), static_cast<GLuint>(vertices->size()), indices->data(), static_cast<GLuint>(indices->size()),
+                         *lodIndexCounts);
+          fprintf(stdout, "[INFO]: merged %u parts into %zu vertices and %zu triangles, %u levels of detail\n",
+                  _numParts, vertices->size(), fullTriangles, _numLods);
+        };
+      });
+    }
+    return nullptr;
+  });
+}
+
+inline void PartMesh::_loadTextureAsync(AssetLoader& loader, const std::string& texturePath) {
+  if (texturePath.empty()) return;
+  loader.submit([this, texturePath]() -> AssetLoader::Upload {
+    // decoding and block compression both stay on the worker, the GL thread only copies blocks
+    const std::shared_ptr<TextureCooker::Cooked> cooked = _cookTexture(texturePath);
+    if (!cooked) return nullptr;
+    return [this, cooked]() { _uploadTexture(*cooked); };
+  });
+}
+
+inline std::shared_ptr<TextureCooker::Cooked> PartMesh::_cookTexture(const std::string& texturePath) {
+  const std::string cookedPath = texturePath + ".ctex";
+  auto cooked = std::make_shared<TextureCooker::Cooked>();
+  if (TextureCooker::load(cookedPath, texturePath, *cooked)) return cooked;
+
+  int width = 0, height = 0, channels = 0;
+  unsigned char* pixels = stbi_load(texturePath.c_str(), &width, &height, &channels, 4);
+  if (!pixels) {
+    fprintf(stderr, "[ERROR]: Could not load texture %s\n", texturePath.c_str());
+    return nullptr;
+  }
+  // flip on Y like TextureUtils does, by hand because stbi's flip flag is shared by every thread
+  const size_t rowBytes = static_cast<size_t>(width) * 4;
+  std::vector<unsigned char> image(rowBytes * height);
+  for (int row = 0; row < height; row++) {
+    memcpy(image.data() + row * rowBytes, pixels + (height - 1 - row) * rowBytes, rowBytes);
+  }
+  stbi_image_free(pixels);
+
+  *cooked = TextureCooker::cook(image.data(), width, height);
+  if (TextureCooker::write(cookedPath, texturePath, *cooked)) {
+    fprintf(stdout, "[INFO]: cooked %s into %zu mip levels\n", texturePath.c_str(), cooked->levels.size());
+  }
+  return cooked;
+}
+
+inline void PartMesh::_uploadTexture(const TextureCooker::Cooked& cooked) {
+  _texture = TextureCooker::upload(cooked);
+  fprintf(stdout, "[INFO]: texture uses %zu KB as %s instead of %zu KB as RGBA8\n",
+          TextureCooker::getCompressedSize(cooked) / 1024, cooked.format == TextureCooker::FORMAT_BC1 ? "BC1" : "BC3",
+          TextureCooker::getUncompressedSize(cooked) / 1024);
+}
+
+inline void PartMesh::setAttributeLocations(const GLint positionLocation, const GLint normalLocation, const GLint texCoordLocation, const GLint partIndexLocation) {
+  _attributeLocations[0] = positionLocation;
+  _attributeLocations[1] = normalLocation;
+  _attributeLocations[2] = texCoordLocation;
+  _attributeLocations[3] = partIndexLocation;
+  _applyAttributeLocations();
+}
+
+inline void PartMesh::_applyAttributeLocations() const {
+  // nothing to hook up until both the buffers and the locations exist
+  if (!_vao || _attributeLocations[0] < 0) return;
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  _packer.setAttributePointer(VertexPacker::POSITION, _attributeLocations[0]);
+  _packer.setAttributePointer(VertexPacker::NORMAL, _attributeLocations[1]);
+  _packer.setAttributePointer(VertexPacker::TEX_COORD, _attributeLocations[2]);
+  _packer.setAttributePointer(VertexPacker::PART_INDEX, _attributeLocations[3]);
+  glBindVertexArray(0);
+}
+
+inline void PartMesh::draw() const {
+  if (_texture) {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _texture);
+  }
+  glBindVertexArray(_vao);
+  glDrawElements(GL_TRIANGLES, _lodNumIndices[0], GL_UNSIGNED_INT, (void*)0);
+  glBindVertexArray(0);
+}
+
+inline bool PartMesh::_parseObj(const std::string& filename, const GLfloat part, std::vector<Vertex>& vertices, std::vector<GLuint>& indices, std::string& texturePath) {
+  std::ifstream in(filename);
+  if (!in) {
+    fprintf(stderr, "[ERROR]: Could not open OBJ file %s\n", filename.c_str());
+    return false;
+  }
+
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec2> texCoords;
+  // one vertex per unique position/texCoord/normal triplet within this file
+  std::map<std::tuple<int, int, int>, GLuint> uniqueVertices;
+
+  // OBJ indices are 1-based and may be negative (relative to the end of the list)
+  auto resolve = [](const int index, const size_t count) {
+    return index < 0 ? static_cast<int>(count) + index : index - 1;
+  };
+
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream tokens(line);
+    std::string type;
+    tokens >> type;
+    if (type == "v") {
+      glm::vec3 p;
+      tokens >> p.x >> p.y >> p.z;
+      positions.push_back(p);
+    } else if (type == "vn") {
+      glm::vec3 n;
+      tokens >> n.x >> n.y >> n.z;
+      normals.push_back(n);
+    } else if (type == "vt") {
+      glm::vec2 t;
+      tokens >> t.x >> t.y;
+      texCoords.push_back(t);
+    } else if (type == "mtllib" && texturePath.empty()) {
+      std::string mtlName;
+      tokens >> mtlName;
+      const std::string mtlFilename = _directoryOf(filename) + mtlName;
+      const std::string mapName = _findDiffuseMap(mtlFilename);
+      if (!mapName.empty()) {
+        texturePath = _directoryOf(mtlFilename) + mapName;
+      }
+    } else if (type == "f") {
+      // fan triangulate in case the face is not a triangle
+      std::vector<GLuint> face;
+      std::string corner;
+      while (tokens >> corner) {
+        int v = 0, t = 0, n = 0;
+        if (sscanf(corner.c_str(), "%d/%d/%d", &v, &t, &n) != 3 &&
+            sscanf(corner.c_str(), "%d//%d", &v, &n) != 2 &&
+            sscanf(corner.c_str(), "%d/%d", &v, &t) != 2) {
+          sscanf(corner.c_str(), "%d", &v);
+        }
+        const std::tuple<int, int, int> key(resolve(v, positions.size()),
+                                            t ? resolve(t, texCoords.size()) : -1,
+                                            n ? resolve(n, normals.size()) : -1);
+        // a position index of 0, or any index past what was declared so far, makes the whole file unusable
+        if (std::get<0>(key) < 0 || std::get<0>(key) >= static_cast<int>(positions.size()) ||
+            (t && (std::get<1>(key) < 0 || std::get<1>(key) >= static_cast<int>(texCoords.size()))) ||
+            (n && (std::get<2>(key) < 0 || std::get<2>(key) >= static_cast<int>(normals.size())))) {
+          fprintf(stderr, "[ERROR]: face corner %s is out of range in OBJ file %s\n", corner.c_str(), filename.c_str());
+          return false;
+        }
+        auto found = uniqueVertices.find(key);
+        if (found == uniqueVertices.end()) {
+          Vertex vertex = {positions[std::get<0>(key)], glm::vec3(0.0f), glm::vec2(0.0f), part};
+          if (std::get<1>(key) >= 0) vertex.texCoord = texCoords[std::get<1>(key)];
+          if (std::get<2>(key) >= 0) vertex.normal = normals[std::get<2>(key)];
+          found = uniqueVertices.emplace(key, static_cast<GLuint>(vertices.size())).first;
+          vertices.push_back(vertex);
+        }
+        face.push_back(found->second);
+      }
+      for (size_t i = 2; i < face.size(); i++) {
+        indices.insert(indices.end(), {face[0], face[i - 1], face[i]});
+      }
+    }
+  }
+  return true;
+}
+
+inline std::string PartMesh::_findDiffuseMap(const std::string& mtlFilename) {
+  std::ifstream in(mtlFilename);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream tokens(line);
+    std::string type, mapName;
+    tokens >> type;
+    if (type == "map_Kd" && tokens >> mapName) {
+      return mapName;
+    }
+  }
+  return "";
+}
+
+inline std::string PartMesh::_directoryOf(const std::string& filename) {
+  const size_t slash = filename.find_last_of("/\\");
+  return slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+}
+
+#endif // PART_MESH_HPP
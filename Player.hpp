@@ -10,10 +10,18 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include "EntityStore.hpp"
+
+/// \desc position and orientation live in the shared EntityStore, a Player only holds its entity id
 class Player {
   public:
-    virtual ~Player() = default;
-    
+    virtual ~Player();
+    Player(const Player&) = delete;
+    Player& operator=(const Player&) = delete;
+
+    /// \desc store every Player's entity is created in, update() it once a frame to move everything at its own speed
+    /// \note the store is not locked, create, update, and read players from one thread only
+    static EntityStore& getEntityStore();
 
     /// \param modelMtx existing model matrix to apply to Caedilas
     /// \param viewMtx camera view matrix to apply to Caedilas
@@ -27,18 +35,24 @@ class Player {
     virtual void moveBackward(const GLfloat speed) final;
     virtual void rotate(const GLfloat dTheta, const GLfloat dPhi) final;
 
+    /// \desc units per second along the direction, negative walks backward, applied by EntityStore::update()
+    virtual void setSpeed(const GLfloat speed) final { getEntityStore().setSpeed(mEntity, speed); }
+    /// \desc radians per second added to theta, applied by EntityStore::update()
+    virtual void setTurnRate(const GLfloat turnRate) final { getEntityStore().setTurnRate(mEntity, turnRate); }
+
     // set world boundaries (assumed to be symmetrical from 0,0,0)
     virtual void setWorldEdges(const GLfloat x, const GLfloat y, const GLfloat z) final {
-      _worldEdges = glm::vec3(x, y, z);
+      getEntityStore().setWorldEdges(mEntity, glm::vec3(x, y, z));
     }
 
     // setters and getters
-    virtual GLfloat getPhi() const final { return mPhi; }
-    virtual GLfloat getTheta() const final { return mTheta; }
-    virtual glm::vec3 getPosition() final {return mPosition; }
-    virtual void setPhi(const GLfloat p) final { mPhi = p; _computeOrientation(); }
-    virtual void setTheta(const GLfloat t) final { mTheta = t; _computeOrientation(); }
-    virtual void setPosition(const glm::vec3 pos) final {mPosition = pos; _computeOrientation(); }
+    virtual GLfloat getPhi() const final { return getEntityStore().getPhi(mEntity); }
+    virtual GLfloat getTheta() const final { return getEntityStore().getTheta(mEntity); }
+    virtual glm::vec3 getPosition() const final { return getEntityStore().getPosition(mEntity); }
+    virtual glm::vec3 getDirection() const final { return getEntityStore().getDirection(mEntity); }
+    virtual void setPhi(const GLfloat p) final { getEntityStore().setPhi(mEntity, p); }
+    virtual void setTheta(const GLfloat t) final { getEntityStore().setTheta(mEntity, t); }
+    virtual void setPosition(const glm::vec3 pos) final { getEntityStore().setPosition(mEntity, pos); }
 
     /// \param shaderProgramHandle shader program handle that the Caedilas should be drawn using
     /// \param mvpMtxUniformLocation uniform location for the full precomputed MVP matrix
@@ -49,13 +63,6 @@ class Player {
     mShaderProgramUniformLocations = { mvpMtxUniformLocation, normalMtxUniformLocation };
     }
 
-  private:
-    glm::vec3 _worldEdges;
-    void _clampPhi();
-    // \desc keep player inside of world boundaries
-    void _computeOrientation();
-    void _clampPosition();
-
   protected:
     // helpers
     static constexpr GLfloat s_PI = glm::pi<float>();
@@ -63,12 +70,9 @@ class Player {
     static constexpr GLfloat s_PI_OVER_2 = glm::half_pi<float>();
 
     Player();
-    glm::vec3 mPosition;
-    glm::vec3 mDirection; // normalized direction vector
-    GLfloat mPhi;
-    GLfloat mTheta;
+    /// \desc id of this player's entity in getEntityStore()
+    EntityStore::Id mEntity;
 
-    
     virtual void mComputeAndSendMatrixUniforms(const glm::mat4& modelMtx, const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
 
     /// \desc handle of the shader program to use when drawing
@@ -82,54 +86,29 @@ class Player {
     } mShaderProgramUniformLocations;
 };
 
+inline EntityStore& Player::getEntityStore() {
+  static EntityStore store;
+  return store;
+}
+
 inline void Player::moveForward(const GLfloat speed) {
-  mPosition += mDirection * speed;
-  _clampPosition();
+  getEntityStore().moveForward(mEntity, speed);
 }
 
 inline void Player::moveBackward(const GLfloat speed){
-  mPosition -= mDirection * speed;
-  _clampPosition();
+  getEntityStore().moveForward(mEntity, -speed);
 }
 
 inline void Player::rotate(const GLfloat dTheta, const GLfloat dPhi) {
-  mPhi += dPhi;
-  mTheta += dTheta;
-  _clampPhi();
-  _computeOrientation();
+  getEntityStore().rotate(mEntity, dTheta, dPhi);
 }
 
 inline Player::Player() :
-  _worldEdges(glm::vec3(5.0f, 5.0f, 5.0f)),
-  mPosition(glm::vec3(0,0,0)),
-  mDirection(glm::vec3(1,0,0)),
-  mPhi(glm::pi<float>() / 2.0f),
-  mTheta(0.0f) {
-}
-
-inline void Player::_clampPhi() {
-    if(mPhi <= 0.0f) mPhi = 0.0f + 0.001f;
-    if(mPhi >= glm::pi<float>()) mPhi = glm::pi<float>() - 0.001f;
+  mEntity(getEntityStore().create(glm::vec3(0,0,0), 0.0f, glm::pi<float>() / 2.0f)) {
 }
 
-inline void Player::_computeOrientation() {
-  // TODO: phi
-  mDirection.x = glm::cos(mTheta);
-  mDirection.z = glm::sin(mTheta);
-
-  mDirection = glm::normalize(mDirection);
-
-}
-
-inline void Player::_clampPosition() {
-  for (size_t i = 0; i < 3; i++) {
-    if (mPosition[i] > _worldEdges[i]) {
-      mPosition[i] = _worldEdges[i];
-    }
-    else if (mPosition[i] < -_worldEdges[i]) {
-      mPosition[i] = -_worldEdges[i];
-    }
-  }
+inline Player::~Player() {
+  getEntityStore().destroy(mEntity);
 }
 
 inline void Player::mComputeAndSendMatrixUniforms(const glm::mat4& modelMtx, const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
@@ -0,0 +1,175 @@
+/**
+ * @file RenderQueue.hpp
+ * @brief Draw submissions sorted by GL state before they are issued
+ */
+
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/// \desc draw code submits what it wants drawn instead of drawing it. flush() sorts the items by a key packing
+/// (program, texture, VAO, material) so items sharing state end up next to each other, then binds each piece of
+/// state only when it differs from the previous item
+class RenderQueue {
+  public:
+    /// \desc binds a material or object slot, called only when the slot differs from the previous item's
+    using BindSlot = std::function<void(GLuint slot)>;
+
+    /// \desc one draw, either of a VAO the queue binds or of whatever the draw function binds itself
+    struct Item {
+      /// \desc program to draw with
+      GLuint program = 0;
+      /// \desc 2D texture bound to unit 0, 0 leaves the unit alone
+      GLuint texture = 0;
+      /// \desc VAO drawn with mode/count/indexType, 0 when draw is set
+      GLuint vao = 0;
+      GLenum mode = GL_TRIANGLES;
+      GLsizei count = 0;
+      /// \desc first vertex for glDrawArrays, first index for glDrawElements (e.g. a level of detail sharing the buffer)
+      GLuint first = 0;
+      /// \desc GL_UNSIGNED_SHORT/GL_UNSIGNED_INT for glDrawElements, 0 for glDrawArrays
+      GLenum indexType = 0;
+      /// \desc more than 1 uses the instanced draw
+      GLsizei instanceCount = 1;
+      /// \desc slots handed to the bind functions
+      GLuint material = 0;
+      GLuint object = 0;
+      /// \desc per-item uniforms, runs once the program, texture, material and object are bound (may be empty)
+      std::function<void()> setup;
+      /// \desc replaces the VAO draw for objects that bind their own VAOs and textures (CSCI441 objects, MD5 models),
+      /// it must leave the program bound
+      std::function<void()> draw;
+    };
+
+    /// \desc how much state the last flush() changed
+    struct Stats {
+      GLuint draws;
+      GLuint programChanges;
+      GLuint textureChanges;
+      GLuint vaoChanges;
+      GLuint materialChanges;
+      GLuint objectChanges;
+    };
+
+    RenderQueue();
+
+    /// \desc sets what binds material and object slots, either may be empty if the items don't use them
+    void setSlotBinders(BindSlot bindMaterial, BindSlot bindObject);
+
+    /// \desc queues an item for the next flush()
+    void submit(Item item);
+
+    /// \desc sorts and issues every queued item, then empties the queue (keeping its memory for the next frame)
+    void flush();
+
+    /// \desc counts from the last flush()
+    const Stats& getStats() const { return _stats; }
+
+  private:
+    /// \desc marks cached state as unknown so the next item binds it no matter what
+    static constexpr GLuint UNKNOWN = 0xFFFFFFFF;
+
+    std::vector<Item> _items;
+    /// \desc (sort key, index into _items), sorted instead of the items themselves
+    std::vector<std::pair<std::uint64_t, GLuint>> _order;
+    BindSlot _bindMaterial;
+    BindSlot _bindObject;
+    Stats _stats;
+
+    /// \desc program in the top 16 bits down to material in the bottom 16, GL names are small so truncating
+    /// them only ever merges groups in the sort, the binds themselves compare the full names
+    static std::uint64_t _key(const Item& item);
+};
+
+inline RenderQueue::RenderQueue() :
+  _stats({0, 0, 0, 0, 0, 0}) {
+}
+
+inline void RenderQueue::setSlotBinders(BindSlot bindMaterial, BindSlot bindObject) {
+  _bindMaterial = std::move(bindMaterial);
+  _bindObject = std::move(bindObject);
+}
+
+inline void RenderQueue::submit(Item item) {
+  _order.emplace_back(_key(item), static_cast<GLuint>(_items.size()));
+  _items.push_back(std::move(item));
+}
+
+inline std::uint64_t RenderQueue::_key(const Item& item) {
+  return (static_cast<std::uint64_t>(item.program & 0xFFFF) << 48) |
+         (static_cast<std::uint64_t>(item.texture & 0xFFFF) << 32) |
+         (static_cast<std::uint64_t>(item.vao & 0xFFFF) << 16) |
+          static_cast<std::uint64_t>(item.material & 0xFFFF);
+}
+
+inline void RenderQueue::flush() {
+  // stable so items with equal state keep the order they were submitted in
+  std::stable_sort(_order.begin(), _order.end(),
+                   [](const std::pair<std::uint64_t, GLuint>& a, const std::pair<std::uint64_t, GLuint>& b) { return a.first < b.first; });
+
+  _stats = {0, 0, 0, 0, 0, 0};
+  GLuint currentProgram = UNKNOWN, currentTexture = UNKNOWN, currentVAO = UNKNOWN;
+  GLuint currentMaterial = UNKNOWN, currentObject = UNKNOWN;
+  for (const std::pair<std::uint64_t, GLuint>& entry : _order) {
+    const Item& item = _items[entry.second];
+
+    if (item.program != currentProgram) {
+      glUseProgram(item.program);
+      currentProgram = item.program;
+      _stats.programChanges++;
+    }
+    if (item.texture != 0 && item.texture != currentTexture) {
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, item.texture);
+      currentTexture = item.texture;
+      _stats.textureChanges++;
+    }
+    if (_bindMaterial && item.material != currentMaterial) {
+      _bindMaterial(item.material);
+      currentMaterial = item.material;
+      _stats.materialChanges++;
+    }
+    if (_bindObject && item.object != currentObject) {
+      _bindObject(item.object);
+      currentObject = item.object;
+      _stats.objectChanges++;
+    }
+    if (item.setup) item.setup();
+
+    if (item.draw) {
+      item.draw();
+      // the draw binds its own VAO and textures, the cached ones can't be trusted afterwards
+      currentTexture = currentVAO = UNKNOWN;
+    } else {
+      if (item.vao != currentVAO) {
+        glBindVertexArray(item.vao);
+        currentVAO = item.vao;
+        _stats.vaoChanges++;
+      }
+      if (item.indexType == 0) {
+        if (item.instanceCount > 1) glDrawArraysInstanced(item.mode, static_cast<GLint>(item.first), item.count, item.instanceCount);
+        else glDrawArrays(item.mode, static_cast<GLint>(item.first), item.count);
+      } else {
+        const size_t indexSize = item.indexType == GL_UNSIGNED_INT ? 4 : item.indexType == GL_UNSIGNED_SHORT ? 2 : 1;
+        const void* offset = reinterpret_cast<const void*>(static_cast<size_t>(item.first) * indexSize);
+        if (item.instanceCount > 1) glDrawElementsInstanced(item.mode, item.count, item.indexType, offset, item.instanceCount);
+        else glDrawElements(item.mode, item.count, item.indexType, offset);
+      }
+    }
+    _stats.draws++;
+  }
+  glBindVertexArray(0);
+
+  _items.clear();
+  _order.clear();
+}
+
+#endif // RENDER_QUEUE_HPP
@@ -0,0 +1,158 @@
+/**
+ * @file ShaderVariants.hpp
+ * @brief Every permutation of a shader's optional features compiled from one source with preprocessor defines
+ */
+
+#ifndef SHADER_VARIANTS_HPP
+#define SHADER_VARIANTS_HPP
+
+#include <glad/gl.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// \desc the vertex and fragment sources are read once and compiled once per combination of features.
+/// Variant i #defines the name of every feature whose bit is set in i, so the shader wraps each optional
+/// feature in #ifdef and a draw runs only the code it needs instead of branching on uniforms
+class ShaderVariants {
+  public:
+    /// \desc most features one set can switch, up to 2^MAX_FEATURES programs get compiled
+    static constexpr GLuint MAX_FEATURES = 4;
+
+    /// \desc compiles and links the requested variants, the others keep handle 0
+    /// \param featureDefines macro names, feature j is bit (1 << j) of the variant index
+    /// \param variants indices to build, every variant if empty
+    ShaderVariants(const char* vertexShaderFilename, const char* fragmentShaderFilename, const std::vector<std::string>& featureDefines,
+                   const std::vector<GLuint>& variants = {});
+    ~ShaderVariants();
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    /// \desc number of variants (2^features)
+    GLuint getNumVariants() const { return static_cast<GLuint>(_programs.size()); }
+    /// \desc handle of a variant's program, 0 if it wasn't requested or failed to build
+    GLuint getShaderProgramHandle(const GLuint variant) const { return _programs[variant]; }
+    /// \desc makes the variant the current program
+    void useProgram(const GLuint variant) const { glUseProgram(_programs[variant]); }
+    GLint getUniformLocation(const GLuint variant, const char* name) const { return glGetUniformLocation(_programs[variant], name); }
+    GLint getAttributeLocation(const GLuint variant, const char* name) const { return glGetAttribLocation(_programs[variant], name); }
+
+  private:
+    std::vector<GLuint> _programs;
+
+    static bool _readFile(const char* filename, std::string& source);
+    /// \desc source with one #define per enabled feature placed right after the #version line
+    static std::string _addDefines(const std::string& source, const std::vector<std::string>& featureDefines, GLuint variant);
+    static GLuint _compile(GLenum type, const std::string& source, const char* filename, GLuint variant);
+};
+
+inline ShaderVariants::ShaderVariants(const char* vertexShaderFilename, const char* fragmentShaderFilename, const std::vector<std::string>& featureDefines,
+                                      const std::vector<GLuint>& variants) {
+  if (featureDefines.size() > MAX_FEATURES) {
+    fprintf(stderr, "[ERROR]: ShaderVariants can switch at most %u features, got %zu\n", MAX_FEATURES, featureDefines.size());
+    return;
+  }
+  // every variant gets a slot, ones not built stay 0 so a draw with them just renders nothing
+  const GLuint numVariants = 1u << featureDefines.size();
+  _programs.assign(numVariants, 0);
+  std::string vertexSource, fragmentSource;
+  if (!_readFile(vertexShaderFilename, vertexSource) || !_readFile(fragmentShaderFilename, fragmentSource)) {
+    return;
+  }
+
+  std::vector<GLuint> toBuild = variants;
+  if (toBuild.empty()) {
+    for (GLuint variant = 0; variant < numVariants; variant++) toBuild.push_back(variant);
+  }
+  for (const GLuint variant : toBuild) {
+    if (variant >= numVariants || _programs[variant] != 0) continue;
+    GLuint vertexShader = _compile(GL_VERTEX_SHADER, _addDefines(vertexSource, featureDefines, variant), vertexShaderFilename, variant);
+    GLuint fragmentShader = _compile(GL_FRAGMENT_SHADER, _addDefines(fragmentSource, featureDefines, variant), fragmentShaderFilename, variant);
+    if (vertexShader == 0 || fragmentShader == 0) {
+      glDeleteShader(vertexShader);
+      glDeleteShader(fragmentShader);
+      continue;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    // the program keeps the compiled code, the shader objects can go right away
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+      GLint logLength = 0;
+      glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+      std::string log(logLength > 0 ? logLength : 1, '\0');
+      glGetProgramInfoLog(program, logLength, nullptr, &log[0]);
+      fprintf(stderr, "[ERROR]: Could not link %s + %s variant %u\n%s\n", vertexShaderFilename, fragmentShaderFilename, variant, log.c_str());
+      glDeleteProgram(program);
+      continue;
+    }
+    _programs[variant] = program;
+  }
+  fprintf(stdout, "[INFO]: built %zu of %u variants of %s + %s\n", toBuild.size(), numVariants, vertexShaderFilename, fragmentShaderFilename);
+}
+
+inline ShaderVariants::~ShaderVariants() {
+  for (GLuint program : _programs) {
+    glDeleteProgram(program);
+  }
+}
+
+inline bool ShaderVariants::_readFile(const char* filename, std::string& source) {
+  std::ifstream file(filename);
+  if (!file) {
+    fprintf(stderr, "[ERROR]: Could not open shader file %s\n", filename);
+    return false;
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  source = contents.str();
+  return true;
+}
+
+inline std::string ShaderVariants::_addDefines(const std::string& source, const std::vector<std::string>& featureDefines, const GLuint variant) {
+  std::string defines;
+  for (size_t j = 0; j < featureDefines.size(); j++) {
+    if (variant & (1u << j)) defines += "#define " + featureDefines[j] + "\n";
+  }
+  // #version has to stay the first directive, comments above it are fine
+  size_t versionLine = source.find("#version");
+  size_t insertAt = versionLine == std::string::npos ? 0 : source.find('\n', versionLine);
+  insertAt = insertAt == std::string::npos ? source.size() : insertAt + 1;
+  std::string result = source;
+  result.insert(insertAt, defines);
+  return result;
+}
+
+inline GLuint ShaderVariants::_compile(const GLenum type, const std::string& source, const char* filename, const GLuint variant) {
+  GLuint shader = glCreateShader(type);
+  const char* sourceText = source.c_str();
+  glShaderSource(shader, 1, &sourceText, nullptr);
+  glCompileShader(shader);
+
+  GLint compiled = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+  if (!compiled) {
+    GLint logLength = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+    std::string log(logLength > 0 ? logLength : 1, '\0');
+    glGetShaderInfoLog(shader, logLength, nullptr, &log[0]);
+    fprintf(stderr, "[ERROR]: Could not compile %s variant %u\n%s\n", filename, variant, log.c_str());
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+#endif // SHADER_VARIANTS_HPP
@@ -0,0 +1,16 @@
+/**
+ * @file Simd.hpp
+ * @brief Compile time check for the SSE2 paths of the struct-of-arrays kernels
+ */
+
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+// every x86-64 compiler targets SSE2, 32-bit x86 only when asked to.  Kernels wrap their four-wide loops in
+// #ifdef SIMD_USE_SSE2 and keep a scalar loop that handles everything on other targets
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_USE_SSE2 1
+#endif
+
+#endif // SIMD_HPP
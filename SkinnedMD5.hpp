@@ -0,0 +1,682 @@
+/**
+ * @file SkinnedMD5.hpp
+ * @brief MD5 model skinned in the vertex shader from a per-frame joint palette, or drawn as a crowd from baked palettes
+ */
+
+#ifndef SKINNED_MD5_HPP
+#define SKINNED_MD5_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <CSCI441/TextureUtils.hpp>
+
+#include "InstancingUtils.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// \desc reads the same md5mesh/md5anim pair as CSCI441::MD5Model, but instead of weighting every vertex on the CPU and
+/// uploading the result each frame, every vertex keeps its bind pose and its MAX_INFLUENCES strongest joints and weights
+/// as static attributes. animate() only interpolates the skeleton between two frames and sends one matrix per joint
+/// (current pose * inverse bind pose) to a texture buffer the vertex shader blends the vertex with.
+///
+/// for crowds the whole clip is baked once into a second texture buffer holding the palette of every frame, and each
+/// crowd instance only carries where it stands and how far it is into the clip. The crowd shader picks and blends the two
+/// palettes around its time, so any number of copies animate with nothing done per copy on the CPU
+class SkinnedMD5 {
+  public:
+    /// \desc joints a vertex is blended from, the weakest past this are dropped and the rest renormalized
+    static constexpr GLuint MAX_INFLUENCES = 4;
+    /// \desc joints are indexed by a byte
+    static constexpr GLuint MAX_JOINTS = 256;
+    /// \desc RGBA32F texels per joint in the palette, the 4 matrix columns. Must match TEXELS_PER_JOINT in SkinnedMD5Shader
+    static constexpr GLuint TEXELS_PER_JOINT = 4;
+
+    SkinnedMD5();
+    ~SkinnedMD5();
+    SkinnedMD5(const SkinnedMD5&) = delete;
+    SkinnedMD5& operator=(const SkinnedMD5&) = delete;
+
+    /// \desc parses both files into bind pose vertices and the model space skeleton of every frame, makes no GL calls
+    /// \note an animation that doesn't match the mesh's joints is reported and the model stays in its bind pose
+    bool load(const std::string& meshFilename, const std::string& animFilename);
+
+    /// \desc creates the VAO, the diffuse textures, and the palette buffer, needs a current GL context
+    /// \param jointIndicesLocation unsigned integer vec4 attribute, jointWeightsLocation normalized vec4 attribute
+    void setup(GLint positionLocation, GLint normalLocation, GLint texCoordLocation, GLint jointIndicesLocation, GLint jointWeightsLocation);
+
+    /// \desc advances the animation clock and sends the palette for the new pose
+    void animate(GLfloat dTime);
+
+    /// \desc draws every mesh with its diffuse map on texture unit 0 and the palette on paletteUnit
+    void draw(GLuint paletteUnit) const;
+
+    /// \desc one copy drawn by drawCrowd()
+    struct CrowdInstance {
+      /// \desc xyz where it stands, w its heading about +Y in radians
+      glm::vec4 placement;
+      /// \desc seconds added to the crowd clock so the copies don't move in step
+      GLfloat timeOffset;
+    };
+
+    /// \desc samples the palette at every frame of the clip into the baked palette buffer, frame after frame with
+    /// TEXELS_PER_JOINT texels per joint. A model without an animation bakes its bind pose as a single frame
+    /// \note needs setup() first
+    /// \return false if the texture buffer can't hold the clip
+    bool bakeAnimation();
+
+    /// \desc builds the crowd VAO over the model's buffers with one instance per entry, the locations are the crowd
+    /// program's. Calling it again replaces the instances
+    /// \param placementLocation vec4 instance attribute, timeOffsetLocation float instance attribute
+    void setCrowd(const std::vector<CrowdInstance>& instances, GLint positionLocation, GLint normalLocation, GLint texCoordLocation,
+                  GLint jointIndicesLocation, GLint jointWeightsLocation, GLint placementLocation, GLint timeOffsetLocation);
+
+    /// \desc refills the crowd buffer with only the listed instances, the next drawCrowd() draws just those
+    /// \param visible indices into the setCrowd() instances, e.g. from Frustum::cullSpheres()
+    void setVisibleCrowd(const std::vector<GLuint>& visible);
+
+    /// \desc draws the crowd instances in the buffer with one instanced call per mesh, the diffuse map on texture
+    /// unit 0 and the baked palettes on paletteUnit
+    void drawCrowd(GLuint paletteUnit) const;
+
+    GLuint getNumJoints() const { return static_cast<GLuint>(_joints.size()); }
+    GLuint getNumFrames() const { return _numFrames; }
+    GLfloat getFrameRate() const { return _frameRate; }
+    /// \desc frames in the baked palette buffer
+    GLuint getNumBakedFrames() const { return std::max(_numFrames, 1u); }
+
+  private:
+    struct JointPose {
+      glm::vec3 position;
+      glm::quat orientation;
+    };
+    struct Joint {
+      std::string name;
+      GLint parent;
+      /// \desc model space bind pose
+      JointPose pose;
+    };
+    struct Vertex {
+      glm::vec3 position;
+      glm::vec3 normal;
+      glm::vec2 texCoord;
+      GLubyte joints[MAX_INFLUENCES];
+      /// \desc UNORM8, always summing to 255
+      GLubyte weights[MAX_INFLUENCES];
+    };
+    struct Mesh {
+      std::string shader;
+      GLuint firstIndex;
+      GLsizei numIndices;
+      GLuint texture;
+    };
+
+    std::vector<Joint> _joints;
+    /// \desc inverse of each joint's bind pose, takes a bind pose vertex into the joint's space
+    std::vector<glm::mat4> _inverseBindMatrices;
+    /// \desc model space skeleton of every frame, getNumJoints() poses per frame
+    std::vector<JointPose> _framePoses;
+    GLuint _numFrames;
+    GLfloat _frameRate;
+    /// \desc frame the pose is blended from and how far (0-1) it is towards the next one
+    GLuint _currentFrame;
+    GLfloat _frameFraction;
+
+    /// \desc CPU copies kept only until setup() uploads them
+    std::vector<Vertex> _vertices;
+    std::vector<GLuint> _indices;
+    std::vector<Mesh> _meshes;
+    /// \desc directory of the md5mesh, shader paths are also tried relative to it
+    std::string _directory;
+
+    std::vector<glm::mat4> _palette;
+    GLuint _vao;
+    GLuint _vbo;
+    GLuint _ibo;
+    GLuint _paletteBuffer;
+    GLuint _paletteTexture;
+    GLuint _bakedBuffer;
+    GLuint _bakedTexture;
+    GLuint _crowdVAO;
+    GLuint _crowdBuffer;
+    GLsizei _numCrowdInstances;
+    /// \desc every setCrowd() instance, and the visible ones gathered for the buffer
+    std::vector<CrowdInstance> _crowd;
+    std::vector<CrowdInstance> _visibleCrowd;
+
+    /// \desc reads a file with // comments removed and brackets split into their own tokens
+    static bool _readTokens(const std::string& filename, std::stringstream& tokens);
+    bool _parseMesh(std::istream& in);
+    bool _parseAnim(std::istream& in, const std::string& animFilename);
+    /// \desc reads "( x y z )"
+    static void _readVec3(std::istream& in, glm::vec3& v);
+    /// \desc MD5 stores unit quaternions without w, which is the negative root
+    static glm::quat _quatFromXYZ(const glm::vec3& xyz);
+    static glm::mat4 _poseMatrix(const JointPose& pose);
+    /// \desc points the bound VAO's vertex attributes at the model's buffers
+    void _bindVertexAttributes(GLint positionLocation, GLint normalLocation, GLint texCoordLocation, GLint jointIndicesLocation, GLint jointWeightsLocation) const;
+    /// \desc writes getNumJoints() matrices for the pose fraction of the way from frame to the next
+    void _computePalette(GLuint frame, GLfloat fraction, glm::mat4* palette) const;
+    /// \desc blends the current and next frame and sends the palette
+    void _uploadPalette();
+    static GLuint _loadTexture(const std::string& shader, const std::string& directory);
+};
+
+inline SkinnedMD5::SkinnedMD5() :
+  _numFrames(0),
+  _frameRate(0.0f),
+  _currentFrame(0),
+  _frameFraction(0.0f),
+  _vao(0),
+  _vbo(0),
+  _ibo(0),
+  _paletteBuffer(0),
+  _paletteTexture(0),
+  _bakedBuffer(0),
+  _bakedTexture(0),
+  _crowdVAO(0),
+  _crowdBuffer(0),
+  _numCrowdInstances(0) {
+}
+
+inline SkinnedMD5::~SkinnedMD5() {
+  glDeleteVertexArrays(1, &_vao);
+  glDeleteBuffers(1, &_vbo);
+  glDeleteBuffers(1, &_ibo);
+  glDeleteTextures(1, &_paletteTexture);
+  glDeleteBuffers(1, &_paletteBuffer);
+  glDeleteTextures(1, &_bakedTexture);
+  glDeleteBuffers(1, &_bakedBuffer);
+  glDeleteVertexArrays(1, &_crowdVAO);
+  glDeleteBuffers(1, &_crowdBuffer);
+  for (const Mesh& mesh : _meshes) {
+    glDeleteTextures(1, &mesh.texture);
+  }
+}
+
+inline bool SkinnedMD5::_readTokens(const std::string& filename, std::stringstream& tokens) {
+  std::ifstream file(filename);
+  if (!file) {
+    fprintf(stderr, "[ERROR]: Could not open MD5 file %s\n", filename.c_str());
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+      const char c = line[i];
+      if (c == '"') quoted = !quoted;
+      if (!quoted && c == '/' && i + 1 < line.size() && line[i + 1] == '/') break;
+      if (!quoted && (c == '(' || c == ')' || c == '{' || c == '}')) tokens << ' ' << c << ' ';
+      else tokens << c;
+    }
+    tokens << '\n';
+  }
+  return true;
+}
+
+inline void SkinnedMD5::_readVec3(std::istream& in, glm::vec3& v) {
+  std::string bracket;
+  in >> bracket >> v.x >> v.y >> v.z >> bracket;
+}
+
+inline glm::quat SkinnedMD5::_quatFromXYZ(const glm::vec3& xyz) {
+  const GLfloat t = 1.0f - glm::dot(xyz, xyz);
+  return glm::quat(t < 0.0f ? 0.0f : -std::sqrt(t), xyz.x, xyz.y, xyz.z);
+}
+
+inline glm::mat4 SkinnedMD5::_poseMatrix(const JointPose& pose) {
+  return glm::translate(glm::mat4(1.0f), pose.position) * glm::mat4_cast(pose.orientation);
+}
+
+inline bool SkinnedMD5::load(const std::string& meshFilename, const std::string& animFilename) {
+  const size_t slash = meshFilename.find_last_of("/\\");
+  _directory = slash == std::string::npos ? std::string() : meshFilename.substr(0, slash + 1);
+
+  std::stringstream meshTokens;
+  if (!_readTokens(meshFilename, meshTokens) || !_parseMesh(meshTokens)) return false;
+
+  _inverseBindMatrices.resize(_joints.size());
+  for (size_t j = 0; j < _joints.size(); j++) {
+    _inverseBindMatrices[j] = glm::inverse(_poseMatrix(_joints[j].pose));
+  }
+  _palette.assign(_joints.size(), glm::mat4(1.0f));
+
+  std::stringstream animTokens;
+  if (!animFilename.empty() && _readTokens(animFilename, animTokens) && !_parseAnim(animTokens, animFilename)) {
+    _framePoses.clear();
+    _numFrames = 0;
+  }
+  fprintf(stdout, "[INFO]: %s has %zu joints, %zu meshes, %zu vertices, %u frames of animation\n",
+          meshFilename.c_str(), _joints.size(), _meshes.size(), _vertices.size(), _numFrames);
+  return true;
+}
+
+inline bool SkinnedMD5::_parseMesh(std::istream& in) {
+  std::string token;
+  while (in >> token) {
+    if (token == "joints") {
+      in >> token; // {
+      while (in >> std::ws && in.peek() == '"') {
+        Joint joint;
+        glm::vec3 orientation;
+        in >> std::quoted(joint.name) >> joint.parent;
+        _readVec3(in, joint.pose.position);
+        _readVec3(in, orientation);
+        joint.pose.orientation = _quatFromXYZ(orientation);
+        _joints.push_back(joint);
+      }
+      in >> token; // }
+      if (_joints.size() > MAX_JOINTS) {
+        fprintf(stderr, "[ERROR]: SkinnedMD5 supports at most %u joints, got %zu\n", MAX_JOINTS, _joints.size());
+        return false;
+      }
+    } else if (token == "mesh") {
+      struct MeshVertex {
+        glm::vec2 texCoord;
+        GLuint firstWeight;
+        GLuint numWeights;
+      };
+      struct Weight {
+        GLuint joint;
+        GLfloat bias;
+        glm::vec3 position;
+      };
+      std::vector<MeshVertex> meshVertices;
+      std::vector<GLuint> meshIndices;
+      std::vector<Weight> weights;
+      Mesh mesh = {std::string(), static_cast<GLuint>(_indices.size()), 0, 0};
+
+      in >> token; // {
+      GLuint index = 0, count = 0;
+      std::string bracket;
+      while (in >> token && token != "}") {
+        if (token == "shader") {
+          in >> std::quoted(mesh.shader);
+        } else if (token == "numverts") {
+          in >> count;
+          meshVertices.resize(count);
+        } else if (token == "vert") {
+          MeshVertex vertex;
+          in >> index >> bracket >> vertex.texCoord.x >> vertex.texCoord.y >> bracket >> vertex.firstWeight >> vertex.numWeights;
+          if (index < meshVertices.size()) meshVertices[index] = vertex;
+        } else if (token == "numtris") {
+          in >> count;
+          meshIndices.resize(static_cast<size_t>(count) * 3);
+        } else if (token == "tri") {
+          GLuint a, b, c;
+          in >> index >> a >> b >> c;
+          if (static_cast<size_t>(index) * 3 + 2 < meshIndices.size()) {
+            meshIndices[index * 3] = a;
+            meshIndices[index * 3 + 1] = b;
+            meshIndices[index * 3 + 2] = c;
+          }
+        } else if (token == "numweights") {
+          in >> count;
+          weights.resize(count);
+        } else if (token == "weight") {
+          Weight weight;
+          in >> index >> weight.joint >> weight.bias;
+          _readVec3(in, weight.position);
+          if (index < weights.size()) weights[index] = weight;
+        }
+      }
+
+      // bind pose positions from the weights, and each vertex's strongest joints for the shader
+      const GLuint baseVertex = static_cast<GLuint>(_vertices.size());
+      for (const MeshVertex& meshVertex : meshVertices) {
+        Vertex vertex = {glm::vec3(0.0f), glm::vec3(0.0f), meshVertex.texCoord, {0, 0, 0, 0}, {0, 0, 0, 0}};
+        std::vector<const Weight*> influences;
+        for (GLuint w = meshVertex.firstWeight; w < meshVertex.firstWeight + meshVertex.numWeights && w < weights.size(); w++) {
+          const Weight& weight = weights[w];
+          if (weight.joint >= _joints.size()) continue;
+          const JointPose& joint = _joints[weight.joint].pose;
+          vertex.position += weight.bias * (joint.position + joint.orientation * weight.position);
+          influences.push_back(&weight);
+        }
+        std::sort(influences.begin(), influences.end(), [](const Weight* a, const Weight* b) { return a->bias > b->bias; });
+        if (influences.size() > MAX_INFLUENCES) influences.resize(MAX_INFLUENCES);
+        GLfloat total = 0.0f;
+        for (const Weight* weight : influences) total += weight->bias;
+        // quantize so the bytes add up to exactly 255, the rounding left over goes to the strongest joint
+        GLint remaining = 255;
+        for (size_t i = 0; i < influences.size(); i++) {
+          vertex.joints[i] = static_cast<GLubyte>(influences[i]->joint);
+          vertex.weights[i] = static_cast<GLubyte>(std::lround(255.0f * influences[i]->bias / std::max(total, 1e-6f)));
+          remaining -= vertex.weights[i];
+        }
+        vertex.weights[0] = static_cast<GLubyte>(std::min(255, std::max(0, vertex.weights[0] + remaining)));
+        _vertices.push_back(vertex);
+      }
+
+      // smooth bind pose normals, each face weighted by its area
+      for (size_t i = 0; i + 2 < meshIndices.size(); i += 3) {
+        if (meshIndices[i] >= meshVertices.size() || meshIndices[i + 1] >= meshVertices.size() || meshIndices[i + 2] >= meshVertices.size()) continue;
+        Vertex& v0 = _vertices[baseVertex + meshIndices[i]];
+        Vertex& v1 = _vertices[baseVertex + meshIndices[i + 1]];
+        Vertex& v2 = _vertices[baseVertex + meshIndices[i + 2]];
+        const glm::vec3 faceNormal = glm::cross(v2.position - v0.position, v1.position - v0.position);
+        v0.normal += faceNormal;
+        v1.normal += faceNormal;
+        v2.normal += faceNormal;
+        _indices.push_back(baseVertex + meshIndices[i]);
+        _indices.push_back(baseVertex + meshIndices[i + 1]);
+        _indices.push_back(baseVertex + meshIndices[i + 2]);
+      }
+      for (GLuint v = baseVertex; v < _vertices.size(); v++) {
+        const GLfloat length = glm::length(_vertices[v].normal);
+        _vertices[v].normal = length > 0.0f ? _vertices[v].normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+      }
+
+      mesh.numIndices = static_cast<GLsizei>(_indices.size() - mesh.firstIndex);
+      _meshes.push_back(mesh);
+    }
+  }
+  if (_joints.empty() || _meshes.empty()) {
+    fprintf(stderr, "[ERROR]: MD5 mesh has no joints or no meshes\n");
+    return false;
+  }
+  return true;
+}
+
+inline bool SkinnedMD5::_parseAnim(std::istream& in, const std::string& animFilename) {
+  struct Channel {
+    GLint parent;
+    GLuint flags;
+    GLuint firstComponent;
+  };
+  /// \desc parent space values the frame components are written over
+  struct BaseJoint {
+    glm::vec3 position;
+    glm::vec3 orientation;
+  };
+  std::vector<Channel> hierarchy;
+  std::vector<BaseJoint> baseFrame;
+  GLuint numJoints = 0, numComponents = 0;
+
+  std::string token, name;
+  while (in >> token) {
+    if (token == "numFrames") {
+      in >> _numFrames;
+    } else if (token == "numJoints") {
+      in >> numJoints;
+    } else if (token == "frameRate") {
+      in >> _frameRate;
+    } else if (token == "numAnimatedComponents") {
+      in >> numComponents;
+    } else if (token == "hierarchy") {
+      in >> token; // {
+      while (in >> std::ws && in.peek() == '"') {
+        Channel channel;
+        in >> std::quoted(name) >> channel.parent >> channel.flags >> channel.firstComponent;
+        hierarchy.push_back(channel);
+      }
+      in >> token; // }
+      if (hierarchy.size() != _joints.size()) {
+        fprintf(stderr, "[ERROR]: %s animates %zu joints, the mesh has %zu\n", animFilename.c_str(), hierarchy.size(), _joints.size());
+        return false;
+      }
+      for (size_t j = 0; j < hierarchy.size(); j++) {
+        if (hierarchy[j].parent >= static_cast<GLint>(j) || hierarchy[j].parent != _joints[j].parent) {
+          fprintf(stderr, "[ERROR]: %s has a different joint hierarchy than the mesh\n", animFilename.c_str());
+          return false;
+        }
+      }
+      _framePoses.resize(static_cast<size_t>(_numFrames) * hierarchy.size());
+    } else if (token == "bounds") {
+      // only the skeleton is needed
+      while (in >> token && token != "}") {}
+    } else if (token == "baseframe") {
+      in >> token; // {
+      while (in >> std::ws && in.peek() == '(') {
+        BaseJoint joint;
+        _readVec3(in, joint.position);
+        _readVec3(in, joint.orientation);
+        baseFrame.push_back(joint);
+      }
+      in >> token; // }
+    } else if (token == "frame") {
+      GLuint frame = 0;
+      in >> frame >> token; // {
+      std::vector<GLfloat> components(numComponents);
+      for (GLfloat& component : components) in >> component;
+      in >> token; // }
+      if (frame >= _numFrames || baseFrame.size() != hierarchy.size() || hierarchy.empty()) {
+        fprintf(stderr, "[ERROR]: %s has a frame before its hierarchy and base frame\n", animFilename.c_str());
+        return false;
+      }
+
+      // components replace base frame values for the flagged channels (tx ty tz qx qy qz), then each joint is
+      // moved into model space by its parent, which always comes earlier
+      JointPose* poses = &_framePoses[static_cast<size_t>(frame) * hierarchy.size()];
+      for (size_t j = 0; j < hierarchy.size(); j++) {
+        const Channel& channel = hierarchy[j];
+        glm::vec3 position = baseFrame[j].position;
+        glm::vec3 orientation = baseFrame[j].orientation;
+        GLuint component = channel.firstComponent;
+        for (int axis = 0; axis < 3; axis++) {
+          if ((channel.flags & (1u << axis)) && component < components.size()) position[axis] = components[component++];
+        }
+        for (int axis = 0; axis < 3; axis++) {
+          if ((channel.flags & (8u << axis)) && component < components.size()) orientation[axis] = components[component++];
+        }
+        JointPose pose = {position, _quatFromXYZ(orientation)};
+        if (channel.parent >= 0) {
+          const JointPose& parent = poses[channel.parent];
+          pose.position = parent.position + parent.orientation * pose.position;
+          pose.orientation = glm::normalize(parent.orientation * pose.orientation);
+        }
+        poses[j] = pose;
+      }
+    }
+  }
+  if (_numFrames == 0 || _frameRate <= 0.0f || _framePoses.empty()) {
+    fprintf(stderr, "[ERROR]: %s has no frames to play\n", animFilename.c_str());
+    return false;
+  }
+  return true;
+}
+
+inline GLuint SkinnedMD5::_loadTexture(const std::string& shader, const std::string& directory) {
+  // shader names may leave out the extension, and may be relative to the working directory or the mesh
+  for (const std::string& base : {shader, directory + shader}) {
+    for (const char* extension : {"", ".png", ".tga", ".jpg"}) {
+      const std::string filename = base + extension;
+      struct stat info;
+      if (stat(filename.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+        return CSCI441::TextureUtils::loadAndRegisterTexture(filename.c_str());
+      }
+    }
+  }
+  fprintf(stderr, "[WARN]: Could not find a texture for MD5 shader %s\n", shader.c_str());
+  return 0;
+}
+
+inline void SkinnedMD5::setup(const GLint positionLocation, const GLint normalLocation, const GLint texCoordLocation,
+                              const GLint jointIndicesLocation, const GLint jointWeightsLocation) {
+  glGenVertexArrays(1, &_vao);
+  glBindVertexArray(_vao);
+  glGenBuffers(1, &_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_vertices.size() * sizeof(Vertex)), _vertices.data(), GL_STATIC_DRAW);
+  glGenBuffers(1, &_ibo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(_indices.size() * sizeof(GLuint)), _indices.data(), GL_STATIC_DRAW);
+  _bindVertexAttributes(positionLocation, normalLocation, texCoordLocation, jointIndicesLocation, jointWeightsLocation);
+  glBindVertexArray(0);
+
+  for (Mesh& mesh : _meshes) {
+    mesh.texture = _loadTexture(mesh.shader, _directory);
+  }
+
+  glGenBuffers(1, &_paletteBuffer);
+  glGenTextures(1, &_paletteTexture);
+  glBindBuffer(GL_TEXTURE_BUFFER, _paletteBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(_palette.size() * sizeof(glm::mat4)), nullptr, GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  glBindTexture(GL_TEXTURE_BUFFER, _paletteTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _paletteBuffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  _uploadPalette();
+
+  // nothing on the CPU touches the vertices again
+  std::vector<Vertex>().swap(_vertices);
+  std::vector<GLuint>().swap(_indices);
+}
+
+inline void SkinnedMD5::_bindVertexAttributes(const GLint positionLocation, const GLint normalLocation, const GLint texCoordLocation,
+                                              const GLint jointIndicesLocation, const GLint jointWeightsLocation) const {
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+  glEnableVertexAttribArray(positionLocation);
+  glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+  if (normalLocation >= 0) {
+    glEnableVertexAttribArray(normalLocation);
+    glVertexAttribPointer(normalLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+  }
+  if (texCoordLocation >= 0) {
+    glEnableVertexAttribArray(texCoordLocation);
+    glVertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+  }
+  glEnableVertexAttribArray(jointIndicesLocation);
+  glVertexAttribIPointer(jointIndicesLocation, MAX_INFLUENCES, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, joints));
+  glEnableVertexAttribArray(jointWeightsLocation);
+  glVertexAttribPointer(jointWeightsLocation, MAX_INFLUENCES, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, weights));
+}
+
+inline bool SkinnedMD5::bakeAnimation() {
+  const GLuint numFrames = getNumBakedFrames();
+  const size_t numTexels = static_cast<size_t>(numFrames) * _joints.size() * TEXELS_PER_JOINT;
+  const GLuint maxTexels = getMaxTextureBufferTexels();
+  if (numTexels > maxTexels) {
+    fprintf(stderr, "[ERROR]: %u frames of %zu joints don't fit in a texture buffer of %u texels\n", numFrames, _joints.size(), maxTexels);
+    return false;
+  }
+
+  std::vector<glm::mat4> palettes(static_cast<size_t>(numFrames) * _joints.size(), glm::mat4(1.0f));
+  if (_numFrames > 0) {
+    for (GLuint frame = 0; frame < numFrames; frame++) {
+      _computePalette(frame, 0.0f, &palettes[static_cast<size_t>(frame) * _joints.size()]);
+    }
+  }
+  if (_bakedBuffer == 0) {
+    glGenBuffers(1, &_bakedBuffer);
+    glGenTextures(1, &_bakedTexture);
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, _bakedBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(palettes.size() * sizeof(glm::mat4)), palettes.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  glBindTexture(GL_TEXTURE_BUFFER, _bakedTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _bakedBuffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  fprintf(stdout, "[INFO]: baked %u frames of %zu joints into %zu KB of palettes\n",
+          numFrames, _joints.size(), palettes.size() * sizeof(glm::mat4) / 1024);
+  return true;
+}
+
+inline void SkinnedMD5::setCrowd(const std::vector<CrowdInstance>& instances, const GLint positionLocation, const GLint normalLocation,
+                                 const GLint texCoordLocation, const GLint jointIndicesLocation, const GLint jointWeightsLocation,
+                                 const GLint placementLocation, const GLint timeOffsetLocation) {
+  if (_crowdVAO == 0) {
+    glGenVertexArrays(1, &_crowdVAO);
+    glGenBuffers(1, &_crowdBuffer);
+  }
+  glBindVertexArray(_crowdVAO);
+  _bindVertexAttributes(positionLocation, normalLocation, texCoordLocation, jointIndicesLocation, jointWeightsLocation);
+  glBindBuffer(GL_ARRAY_BUFFER, _crowdBuffer);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instances.size() * sizeof(CrowdInstance)), instances.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(placementLocation);
+  glVertexAttribPointer(placementLocation, 4, GL_FLOAT, GL_FALSE, sizeof(CrowdInstance), (void*)offsetof(CrowdInstance, placement));
+  glVertexAttribDivisor(placementLocation, 1);
+  glEnableVertexAttribArray(timeOffsetLocation);
+  glVertexAttribPointer(timeOffsetLocation, 1, GL_FLOAT, GL_FALSE, sizeof(CrowdInstance), (void*)offsetof(CrowdInstance, timeOffset));
+  glVertexAttribDivisor(timeOffsetLocation, 1);
+  glBindVertexArray(0);
+  _numCrowdInstances = static_cast<GLsizei>(instances.size());
+  _crowd = instances;
+}
+
+inline void SkinnedMD5::setVisibleCrowd(const std::vector<GLuint>& visible) {
+  if (_crowdBuffer == 0) return;
+  _visibleCrowd.clear();
+  for (const GLuint instance : visible) {
+    if (instance < _crowd.size()) _visibleCrowd.push_back(_crowd[instance]);
+  }
+  // a frame's views see different copies, orphan the old storage rather than overwrite it under a pending draw
+  glBindBuffer(GL_ARRAY_BUFFER, _crowdBuffer);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_crowd.size() * sizeof(CrowdInstance)), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(_visibleCrowd.size() * sizeof(CrowdInstance)), _visibleCrowd.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  _numCrowdInstances = static_cast<GLsizei>(_visibleCrowd.size());
+}
+
+inline void SkinnedMD5::drawCrowd(const GLuint paletteUnit) const {
+  if (_numCrowdInstances == 0 || _bakedTexture == 0) return;
+  glActiveTexture(GL_TEXTURE0 + paletteUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, _bakedTexture);
+  glActiveTexture(GL_TEXTURE0);
+  glBindVertexArray(_crowdVAO);
+  for (const Mesh& mesh : _meshes) {
+    glBindTexture(GL_TEXTURE_2D, mesh.texture);
+    glDrawElementsInstanced(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_INT,
+                            reinterpret_cast<const void*>(static_cast<size_t>(mesh.firstIndex) * sizeof(GLuint)), _numCrowdInstances);
+  }
+  glBindVertexArray(0);
+}
+
+inline void SkinnedMD5::animate(const GLfloat dTime) {
+  if (_numFrames == 0) return;
+  _frameFraction += dTime * _frameRate;
+  const GLuint framesPassed = static_cast<GLuint>(_frameFraction);
+  _frameFraction -= static_cast<GLfloat>(framesPassed);
+  _currentFrame = (_currentFrame + framesPassed) % _numFrames;
+  _uploadPalette();
+}
+
+inline void SkinnedMD5::_computePalette(const GLuint frame, const GLfloat fraction, glm::mat4* palette) const {
+  const size_t numJoints = _joints.size();
+  const JointPose* current = &_framePoses[static_cast<size_t>(frame) * numJoints];
+  const JointPose* next = &_framePoses[static_cast<size_t>((frame + 1) % _numFrames) * numJoints];
+  for (size_t j = 0; j < numJoints; j++) {
+    const JointPose pose = {glm::mix(current[j].position, next[j].position, fraction),
+                            glm::slerp(current[j].orientation, next[j].orientation, fraction)};
+    palette[j] = _poseMatrix(pose) * _inverseBindMatrices[j];
+  }
+}
+
+inline void SkinnedMD5::_uploadPalette() {
+  // without an animation the palette stays identity and the shader draws the bind pose
+  if (_numFrames > 0) _computePalette(_currentFrame, _frameFraction, _palette.data());
+  if (_paletteBuffer == 0) return;
+  // orphan the old storage so a draw still reading last frame's palette doesn't stall the upload
+  const GLsizeiptr size = static_cast<GLsizeiptr>(_palette.size() * sizeof(glm::mat4));
+  glBindBuffer(GL_TEXTURE_BUFFER, _paletteBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_TEXTURE_BUFFER, 0, size, _palette.data());
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+inline void SkinnedMD5::draw(const GLuint paletteUnit) const {
+  glActiveTexture(GL_TEXTURE0 + paletteUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, _paletteTexture);
+  glActiveTexture(GL_TEXTURE0);
+  glBindVertexArray(_vao);
+  for (const Mesh& mesh : _meshes) {
+    glBindTexture(GL_TEXTURE_2D, mesh.texture);
+    glDrawElements(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_INT, reinterpret_cast<const void*>(static_cast<size_t>(mesh.firstIndex) * sizeof(GLuint)));
+  }
+  glBindVertexArray(0);
+}
+
+#endif // SKINNED_MD5_HPP
@@ -0,0 +1,303 @@
+/**
+ * @file StarField.hpp
+ * @brief Large instanced star field kept in GPU buffers with struct-of-arrays CPU mirrors
+ */
+
+#ifndef STAR_FIELD_HPP
+#define STAR_FIELD_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "Frustum.hpp"
+#include "InstancingUtils.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+/// \desc every star is CUBES_PER_STAR spinning cubes drawn as instances of one unit cube. The per-star data lives in
+/// a texture buffer the vertex shader fetches from, written only where stars were spawned or despawned, so the only
+/// thing streamed each frame is the list of visible star indices. The CPU keeps each attribute in its own array for
+/// the frustum test and for repacking the GPU data
+class StarField {
+  public:
+    /// \desc cube 0 is unrotated, cubes 1-3 spin about x, y, z. Must match CUBES_PER_STAR in MPStarShader
+    static constexpr GLuint CUBES_PER_STAR = 4;
+    /// \desc RGBA32F texels per star in the data buffer. Must match TEXELS_PER_STAR in MPStarShader
+    static constexpr GLuint TEXELS_PER_STAR = 3;
+    /// \desc returned by spawn() when the field is full
+    static constexpr GLuint INVALID_STAR = 0xFFFFFFFF;
+
+    /// \desc everything that describes one star
+    struct Star {
+      glm::vec3 position;
+      glm::vec3 color;
+      /// \desc side length of the cubes
+      GLfloat size;
+      /// \desc starting rotation of the spinning cubes in degrees
+      GLfloat phase;
+      /// \desc degrees per second the x, y, and z cubes spin
+      glm::vec3 spinRate;
+    };
+
+    StarField();
+    ~StarField();
+    StarField(const StarField&) = delete;
+    StarField& operator=(const StarField&) = delete;
+
+    /// \desc builds the cube geometry and the buffers, needs a current GL context
+    /// \param starIndexLocation unsigned integer instance attribute the star index is fed through
+    /// \param reserveStars stars to make room for up front, the buffers grow as needed past it
+    void setup(GLint vPosLocation, GLint vNormalLocation, GLint starIndexLocation, GLuint reserveStars);
+
+    /// \desc adds a star, it shows up at the next update()
+    /// \return id to despawn it with, stays valid until then. INVALID_STAR if the texture buffer can't hold more
+    GLuint spawn(const Star& star);
+    /// \desc removes a star, the last star moves into its slot so the arrays stay packed
+    void despawn(GLuint id);
+    /// \desc removes every star
+    void clear();
+    GLuint getNumStars() const { return static_cast<GLuint>(_idOfSlot.size()); }
+    /// \desc most stars the texture buffer can hold, known after setup(). GL 4.1 only guarantees 65536 texels
+    GLuint getMaxStars() const { return _maxStars; }
+
+    /// \desc sends spawned/despawned stars to the GPU and replaces the visible list with the stars inside the frustum,
+    /// call once per frame before drawing
+    void update(const Frustum& frustum);
+
+    /// \desc the pieces to draw with: getNumIndices() GL_UNSIGNED_SHORT triangles,
+    /// getNumVisible() * CUBES_PER_STAR instances, getDataTexture() bound as a GL_TEXTURE_BUFFER
+    GLuint getVAO() const { return _vao; }
+    GLsizei getNumIndices() const { return _numIndices; }
+    GLuint getDataTexture() const { return _dataTexture; }
+    GLuint getNumVisible() const { return _numUploadedVisible; }
+
+  private:
+    /// \desc the CPU mirrors, slot i of every array is the same star. Position and bounding radius live in _bounds
+    BoundingSphereList _bounds;
+    std::vector<glm::vec3> _colors;
+    std::vector<GLfloat> _sizes;
+    std::vector<GLfloat> _phases;
+    std::vector<glm::vec3> _spinRates;
+    /// \desc id of the star in each slot and slot of each id (INVALID_STAR for ids not in use)
+    std::vector<GLuint> _idOfSlot;
+    std::vector<GLuint> _slotOfId;
+    /// \desc despawned ids handed out again before new ones
+    std::vector<GLuint> _freeIds;
+
+    GLuint _vao;
+    GLuint _cubeVBO;
+    GLuint _cubeIBO;
+    GLsizei _numIndices;
+    /// \desc TEXELS_PER_STAR texels per slot: (position, size), (color, phase), (spin rates, unused)
+    GLuint _dataBuffer;
+    GLuint _dataTexture;
+    /// \desc slots the data buffer has storage for, and the most the texture buffer can address
+    GLuint _capacity;
+    GLuint _maxStars;
+    /// \desc slots whose GPU data is stale, begin == end when everything is up to date
+    GLuint _dirtyBegin;
+    GLuint _dirtyEnd;
+    /// \desc slots reported by the last frustum test and the slots in the visible buffer
+    std::vector<GLuint> _visible;
+    std::vector<GLuint> _uploadedVisible;
+    GLuint _numUploadedVisible;
+    /// \desc per-instance star indices, the only data streamed every frame
+    GLuint _visibleBuffer;
+    GLuint _visibleCapacity;
+
+    /// \desc sphere around all the spinning cubes of a star, the shader scales cube i by 1.01 + 0.01 * i
+    static GLfloat _boundingRadius(const GLfloat size) {
+      return 0.5f * glm::sqrt(3.0f) * size * (1.01f + 0.01f * static_cast<GLfloat>(CUBES_PER_STAR - 1));
+    }
+    void _markDirty(GLuint slot);
+    /// \desc makes room for at least the given number of slots, stale data is re-sent on the next upload
+    void _reserve(GLuint stars);
+    void _uploadDirty();
+};
+
+inline StarField::StarField() :
+  _vao(0),
+  _cubeVBO(0),
+  _cubeIBO(0),
+  _numIndices(0),
+  _dataBuffer(0),
+  _dataTexture(0),
+  _capacity(0),
+  _maxStars(0),
+  _dirtyBegin(0),
+  _dirtyEnd(0),
+  _numUploadedVisible(0),
+  _visibleBuffer(0),
+  _visibleCapacity(0) {
+}
+
+inline StarField::~StarField() {
+  glDeleteVertexArrays(1, &_vao);
+  glDeleteBuffers(1, &_cubeVBO);
+  glDeleteBuffers(1, &_cubeIBO);
+  glDeleteBuffers(1, &_visibleBuffer);
+  glDeleteTextures(1, &_dataTexture);
+  glDeleteBuffers(1, &_dataBuffer);
+}
+
+inline void StarField::setup(const GLint vPosLocation, const GLint vNormalLocation, const GLint starIndexLocation, const GLuint reserveStars) {
+  glGenVertexArrays(1, &_vao);
+  glBindVertexArray(_vao);
+  _numIndices = createUnitCubeBuffers(vPosLocation, vNormalLocation, _cubeVBO, _cubeIBO);
+
+  // the star index advances once every CUBES_PER_STAR instances, storage comes with the first update()
+  glGenBuffers(1, &_visibleBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, _visibleBuffer);
+  glEnableVertexAttribArray(starIndexLocation);
+  glVertexAttribIPointer(starIndexLocation, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)nullptr);
+  glVertexAttribDivisor(starIndexLocation, CUBES_PER_STAR);
+  glBindVertexArray(0);
+
+  _maxStars = getMaxTextureBufferTexels() / TEXELS_PER_STAR;
+  glGenBuffers(1, &_dataBuffer);
+  glGenTextures(1, &_dataTexture);
+  _reserve(std::max(reserveStars, 1u));
+}
+
+inline void StarField::_reserve(const GLuint stars) {
+  if (stars <= _capacity) return;
+  // double so spawning one star at a time doesn't reallocate every time
+  _capacity = std::min(std::max(stars, _capacity * 2), _maxStars);
+  glBindBuffer(GL_TEXTURE_BUFFER, _dataBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(_capacity) * TEXELS_PER_STAR * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  glBindTexture(GL_TEXTURE_BUFFER, _dataTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _dataBuffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  // the new storage starts out empty
+  _dirtyBegin = 0;
+  _dirtyEnd = getNumStars();
+}
+
+inline GLuint StarField::spawn(const Star& star) {
+  const GLuint slot = getNumStars();
+  if (slot >= _maxStars) {
+    fprintf(stderr, "[ERROR]: StarField can hold at most %u stars\n", _maxStars);
+    return INVALID_STAR;
+  }
+  GLuint id;
+  if (!_freeIds.empty()) {
+    id = _freeIds.back();
+    _freeIds.pop_back();
+  } else {
+    id = static_cast<GLuint>(_slotOfId.size());
+    _slotOfId.push_back(INVALID_STAR);
+  }
+  _slotOfId[id] = slot;
+  _idOfSlot.push_back(id);
+  _bounds.add({star.position, _boundingRadius(star.size)});
+  _colors.push_back(star.color);
+  _sizes.push_back(star.size);
+  _phases.push_back(star.phase);
+  _spinRates.push_back(star.spinRate);
+  _markDirty(slot);
+  return id;
+}
+
+inline void StarField::despawn(const GLuint id) {
+  if (id >= _slotOfId.size() || _slotOfId[id] == INVALID_STAR) return;
+  const GLuint slot = _slotOfId[id];
+  const GLuint last = getNumStars() - 1;
+  // fill the hole with the last star so the arrays and the GPU data stay packed
+  if (slot != last) {
+    _bounds.x[slot] = _bounds.x[last];
+    _bounds.y[slot] = _bounds.y[last];
+    _bounds.z[slot] = _bounds.z[last];
+    _bounds.radius[slot] = _bounds.radius[last];
+    _colors[slot] = _colors[last];
+    _sizes[slot] = _sizes[last];
+    _phases[slot] = _phases[last];
+    _spinRates[slot] = _spinRates[last];
+    _idOfSlot[slot] = _idOfSlot[last];
+    _slotOfId[_idOfSlot[slot]] = slot;
+    _markDirty(slot);
+  }
+  _bounds.x.pop_back();
+  _bounds.y.pop_back();
+  _bounds.z.pop_back();
+  _bounds.radius.pop_back();
+  _colors.pop_back();
+  _sizes.pop_back();
+  _phases.pop_back();
+  _spinRates.pop_back();
+  _idOfSlot.pop_back();
+  _slotOfId[id] = INVALID_STAR;
+  _freeIds.push_back(id);
+  // the visible list may still name the removed slot, have the next update() send a fresh one
+  _uploadedVisible.clear();
+  _numUploadedVisible = 0;
+}
+
+inline void StarField::clear() {
+  _bounds.clear();
+  _colors.clear();
+  _sizes.clear();
+  _phases.clear();
+  _spinRates.clear();
+  _idOfSlot.clear();
+  _slotOfId.clear();
+  _freeIds.clear();
+  _visible.clear();
+  _uploadedVisible.clear();
+  _numUploadedVisible = 0;
+  _dirtyBegin = _dirtyEnd = 0;
+}
+
+inline void StarField::_markDirty(const GLuint slot) {
+  if (_dirtyBegin == _dirtyEnd) {
+    _dirtyBegin = slot;
+    _dirtyEnd = slot + 1;
+  } else {
+    _dirtyBegin = std::min(_dirtyBegin, slot);
+    _dirtyEnd = std::max(_dirtyEnd, slot + 1);
+  }
+}
+
+inline void StarField::_uploadDirty() {
+  _reserve(getNumStars());
+  _dirtyEnd = std::min(_dirtyEnd, getNumStars());
+  if (_dirtyBegin >= _dirtyEnd) {
+    _dirtyBegin = _dirtyEnd = 0;
+    return;
+  }
+  // interleave the mirrors into the texel layout for just the stale slots
+  std::vector<glm::vec4> texels(static_cast<size_t>(_dirtyEnd - _dirtyBegin) * TEXELS_PER_STAR);
+  glm::vec4* texel = texels.data();
+  for (GLuint slot = _dirtyBegin; slot < _dirtyEnd; slot++) {
+    *texel++ = glm::vec4(_bounds.x[slot], _bounds.y[slot], _bounds.z[slot], _sizes[slot]);
+    *texel++ = glm::vec4(_colors[slot], _phases[slot]);
+    *texel++ = glm::vec4(_spinRates[slot], 0.0f);
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, _dataBuffer);
+  glBufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(_dirtyBegin) * TEXELS_PER_STAR * sizeof(glm::vec4),
+                  static_cast<GLsizeiptr>(texels.size() * sizeof(glm::vec4)), texels.data());
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  _dirtyBegin = _dirtyEnd = 0;
+}
+
+inline void StarField::update(const Frustum& frustum) {
+  _uploadDirty();
+  frustum.cullSpheres(_bounds, _visible);
+  // a still camera sees the same stars, nothing to send
+  if (_visible == _uploadedVisible) return;
+  glBindBuffer(GL_ARRAY_BUFFER, _visibleBuffer);
+  if (_visible.size() > _visibleCapacity) {
+    _visibleCapacity = std::max(static_cast<GLuint>(_visible.size()), _capacity);
+  }
+  // orphan the old storage so a draw still reading it doesn't stall the upload
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_visibleCapacity) * sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(_visible.size() * sizeof(GLuint)), _visible.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  _uploadedVisible.swap(_visible);
+  _numUploadedVisible = static_cast<GLuint>(_uploadedVisible.size());
+}
+
+#endif // STAR_FIELD_HPP
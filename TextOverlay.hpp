@@ -0,0 +1,184 @@
+/**
+ * @file TextOverlay.hpp
+ * @brief Screen space text drawn from a built-in 3x5 pixel font
+ */
+
+#ifndef TEXT_OVERLAY_HPP
+#define TEXT_OVERLAY_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <CSCI441/ShaderProgram.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// \desc draws lines of text on top of the frame for debug displays. The font is compiled in (printable ASCII up to
+/// '_', lowercase drawn as uppercase) so no font files are needed, and every string becomes one draw call
+class TextOverlay {
+  public:
+    TextOverlay();
+    ~TextOverlay();
+    TextOverlay(const TextOverlay&) = delete;
+    TextOverlay& operator=(const TextOverlay&) = delete;
+
+    /// \desc builds the shader, glyph atlas, and buffers, needs a current GL context
+    void setup();
+
+    /// \desc draws text with a one pixel drop shadow, '\n' starts a new line
+    /// \param position top left corner of the first glyph in pixels from the top left of the framebuffer
+    /// \param scale size of one font pixel in framebuffer pixels
+    /// \param framebufferSize size of the framebuffer being drawn to
+    void draw(const std::string& text, glm::vec2 position, GLfloat scale, glm::vec4 color, glm::vec2 framebufferSize);
+
+  private:
+    static constexpr GLuint GLYPH_WIDTH = 3;
+    static constexpr GLuint GLYPH_HEIGHT = 5;
+    /// \desc glyphs per atlas row, the atlas holds ' ' through '_'
+    static constexpr GLuint ATLAS_COLUMNS = 8;
+    static constexpr GLuint FIRST_GLYPH = ' ';
+    static constexpr GLuint NUM_GLYPHS = 64;
+
+    struct Vertex {
+      glm::vec2 position;
+      glm::vec2 texCoord;
+      glm::vec4 color;
+    };
+
+    CSCI441::ShaderProgram* _shaderProgram;
+    GLint _screenSizeLocation;
+    GLuint _atlas;
+    GLuint _vao;
+    GLuint _vbo;
+    /// \desc reused between draws so a steady HUD doesn't allocate
+    std::vector<Vertex> _vertices;
+
+    void _addGlyphs(const std::string& text, glm::vec2 position, GLfloat scale, glm::vec4 color);
+};
+
+inline TextOverlay::TextOverlay() :
+  _shaderProgram(nullptr),
+  _screenSizeLocation(-1),
+  _atlas(0),
+  _vao(0),
+  _vbo(0) {
+}
+
+inline TextOverlay::~TextOverlay() {
+  delete _shaderProgram;
+  glDeleteTextures(1, &_atlas);
+  glDeleteBuffers(1, &_vbo);
+  glDeleteVertexArrays(1, &_vao);
+}
+
+inline void TextOverlay::setup() {
+  _shaderProgram = new CSCI441::ShaderProgram("shaders/TextOverlay.v.glsl", "shaders/TextOverlay.f.glsl");
+  _screenSizeLocation = _shaderProgram->getUniformLocation("screenSize");
+  _shaderProgram->setProgramUniform(_shaderProgram->getUniformLocation("glyphAtlas"), 0);
+
+  // every glyph is 5 rows of 3 bits, the top row in the highest bits
+  static constexpr GLushort FONT[NUM_GLYPHS] = {
+    0x0000, 0x2482, 0x5A00, 0x5F7D, 0x3C9E, 0x52A5, 0x2AAB, 0x2400,  //  !"#$%&'
+    0x2922, 0x224A, 0x0AA8, 0x05D0, 0x0014, 0x01C0, 0x0002, 0x12A4,  // ()*+,-./
+    0x7B6F, 0x2C97, 0x62A7, 0x628E, 0x5BC9, 0x798E, 0x39EF, 0x7292,  // 01234567
+    0x7BEF, 0x7BCE, 0x0410, 0x0414, 0x1511, 0x0E38, 0x4454, 0x6282,  // 89:;<=>?
+    0x7BE3, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,  // @ABCDEFG
+    0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,  // HIJKLMNO
+    0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,  // PQRSTUVW
+    0x5AAD, 0x5A92, 0x72A7, 0x6926, 0x4889, 0x324B, 0x2A00, 0x0007   // XYZ[ ]^_ with '\' in the gap
+  };
+  const GLuint atlasWidth = ATLAS_COLUMNS * GLYPH_WIDTH;
+  const GLuint atlasHeight = (NUM_GLYPHS / ATLAS_COLUMNS) * GLYPH_HEIGHT;
+  std::vector<GLubyte> texels(atlasWidth * atlasHeight, 0);
+  for (GLuint glyph = 0; glyph < NUM_GLYPHS; glyph++) {
+    const GLuint cellX = (glyph % ATLAS_COLUMNS) * GLYPH_WIDTH;
+    const GLuint cellY = (glyph / ATLAS_COLUMNS) * GLYPH_HEIGHT;
+    for (GLuint row = 0; row < GLYPH_HEIGHT; row++) {
+      for (GLuint column = 0; column < GLYPH_WIDTH; column++) {
+        const GLuint bit = (GLYPH_HEIGHT - 1 - row) * GLYPH_WIDTH + (GLYPH_WIDTH - 1 - column);
+        if (FONT[glyph] & (1u << bit)) texels[(cellY + row) * atlasWidth + cellX + column] = 255;
+      }
+    }
+  }
+  glGenTextures(1, &_atlas);
+  glBindTexture(GL_TEXTURE_2D, _atlas);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  // nearest keeps the pixel font crisp at any scale
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glGenVertexArrays(1, &_vao);
+  glBindVertexArray(_vao);
+  glGenBuffers(1, &_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+  glBindVertexArray(0);
+}
+
+inline void TextOverlay::_addGlyphs(const std::string& text, const glm::vec2 position, const GLfloat scale, const glm::vec4 color) {
+  const glm::vec2 glyphSize = glm::vec2(GLYPH_WIDTH, GLYPH_HEIGHT) * scale;
+  // one blank font pixel between glyphs and between lines
+  const glm::vec2 advance = glm::vec2(GLYPH_WIDTH + 1, GLYPH_HEIGHT + 1) * scale;
+  const glm::vec2 atlasSize(ATLAS_COLUMNS * GLYPH_WIDTH, (NUM_GLYPHS / ATLAS_COLUMNS) * GLYPH_HEIGHT);
+  glm::vec2 pen = position;
+  for (char c : text) {
+    if (c == '\n') {
+      pen = glm::vec2(position.x, pen.y + advance.y);
+      continue;
+    }
+    if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+    const GLuint glyph = static_cast<GLuint>(static_cast<unsigned char>(c)) - FIRST_GLYPH;
+    if (glyph > 0 && glyph < NUM_GLYPHS) {
+      const glm::vec2 cell = glm::vec2((glyph % ATLAS_COLUMNS) * GLYPH_WIDTH, (glyph / ATLAS_COLUMNS) * GLYPH_HEIGHT);
+      const glm::vec2 uv0 = cell / atlasSize;
+      const glm::vec2 uv1 = (cell + glm::vec2(GLYPH_WIDTH, GLYPH_HEIGHT)) / atlasSize;
+      const glm::vec2 p0 = pen;
+      const glm::vec2 p1 = pen + glyphSize;
+      const Vertex quad[6] = {
+        {p0, uv0, color}, {{p1.x, p0.y}, {uv1.x, uv0.y}, color}, {p1, uv1, color},
+        {p0, uv0, color}, {p1, uv1, color}, {{p0.x, p1.y}, {uv0.x, uv1.y}, color}
+      };
+      _vertices.insert(_vertices.end(), quad, quad + 6);
+    }
+    // spaces and glyphs outside the font still move the pen
+    pen.x += advance.x;
+  }
+}
+
+inline void TextOverlay::draw(const std::string& text, const glm::vec2 position, const GLfloat scale, const glm::vec4 color, const glm::vec2 framebufferSize) {
+  if (!_shaderProgram) return;
+  _vertices.clear();
+  // shadow first so the text lands on top of it
+  _addGlyphs(text, position + glm::vec2(scale), scale, glm::vec4(0.0f, 0.0f, 0.0f, color.a));
+  _addGlyphs(text, position, scale, color);
+  if (_vertices.empty()) return;
+
+  _shaderProgram->useProgram();
+  glUniform2fv(_screenSizeLocation, 1, &framebufferSize[0]);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, _atlas);
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  // fresh storage every draw so the GPU never waits on last frame's text
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_vertices.size() * sizeof(Vertex)), _vertices.data(), GL_STREAM_DRAW);
+
+  // the overlay sits on top of whatever was drawn
+  const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+  glDisable(GL_DEPTH_TEST);
+  glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_vertices.size()));
+  if (depthTest) glEnable(GL_DEPTH_TEST);
+  glBindVertexArray(0);
+}
+
+#endif // TEXT_OVERLAY_HPP
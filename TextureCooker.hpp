@@ -0,0 +1,470 @@
+/**
+ * @file TextureCooker.hpp
+ * @brief Mipmapped BC1/BC3 textures cooked from images once and uploaded as compressed blocks afterwards
+ */
+
+#ifndef TEXTURE_COOKER_HPP
+#define TEXTURE_COOKER_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// S3TC is an extension in 4.1 core, the enums may not be in the loader
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+/// \desc cooking turns an RGBA8 image into its whole mip chain encoded as BC1 (opaque, 8 bytes per 4x4 block)
+/// or BC3 (with alpha, 16 bytes per block), which is 8x or 4x smaller than RGBA8 on the GPU. The cooked file
+/// is stamped with the source image's modification time and size and is stale once they change.
+///
+/// file layout (native endian): Header | numLevels x LevelHeader | numLevels x blocks
+class TextureCooker {
+  public:
+    enum Format : std::uint32_t { FORMAT_BC1, FORMAT_BC3 };
+
+    /// \desc one mip level's blocks, row by row
+    struct Level {
+      GLsizei width;
+      GLsizei height;
+      std::vector<unsigned char> blocks;
+    };
+
+    /// \desc a cooked texture, finest level first
+    struct Cooked {
+      Format format = FORMAT_BC1;
+      std::vector<Level> levels;
+    };
+
+    /// \desc reads cookedFilename if it was cooked from sourceFilename as it is now
+    static bool load(const std::string& cookedFilename, const std::string& sourceFilename, Cooked& cooked);
+
+    /// \desc builds the mip chain of an RGBA8 image and encodes every level, BC3 only if some pixel isn't opaque
+    static Cooked cook(const unsigned char* rgba, GLsizei width, GLsizei height);
+
+    /// \desc writes a cooked texture stamped with the current state of sourceFilename
+    static bool write(const std::string& cookedFilename, const std::string& sourceFilename, const Cooked& cooked);
+
+    /// \desc creates a trilinear, repeating texture from the cooked levels. The blocks go up as they are when the
+    /// driver lists the format, otherwise they are decoded back to RGBA8 first
+    /// \note GL thread only
+    static GLuint upload(const Cooked& cooked);
+
+    /// \desc bytes the cooked levels take, and what the same chain takes as RGBA8
+    static size_t getCompressedSize(const Cooked& cooked);
+    static size_t getUncompressedSize(const Cooked& cooked);
+
+  private:
+    /// \desc "CTEX" read as a little endian integer
+    static constexpr std::uint32_t MAGIC = 0x58455443;
+    static constexpr std::uint32_t VERSION = 1;
+
+    struct Header {
+      std::uint32_t magic;
+      std::uint32_t version;
+      std::uint32_t format;
+      std::uint32_t numLevels;
+      std::int64_t sourceModifiedTime;
+      std::uint64_t sourceSize;
+    };
+    struct LevelHeader {
+      std::uint32_t width;
+      std::uint32_t height;
+      std::uint32_t size;
+      std::uint32_t padding;
+    };
+
+    static bool _stampSource(const std::string& filename, std::int64_t& modifiedTime, std::uint64_t& size);
+    /// \desc half size level by averaging 2x2 pixels, an odd last row or column is folded into its neighbour
+    static std::vector<unsigned char> _downsample(const std::vector<unsigned char>& rgba, GLsizei width, GLsizei height);
+    /// \desc the 4x4 pixels of a block, edge pixels repeated past the image
+    static void _readBlock(const unsigned char* rgba, GLsizei width, GLsizei height, GLsizei blockX, GLsizei blockY, glm::vec4 pixels[16]);
+    /// \desc BC1 color block: endpoints at the extremes of the pixels along their principal axis
+    static void _encodeColorBlock(const glm::vec4 pixels[16], unsigned char out[8]);
+    /// \desc BC3 alpha block: endpoints at the alpha extremes, 8 interpolated values
+    static void _encodeAlphaBlock(const glm::vec4 pixels[16], unsigned char out[8]);
+    static void _decodeColorBlock(const unsigned char in[8], bool alwaysFourColors, unsigned char out[16][4]);
+    static void _decodeAlphaBlock(const unsigned char in[8], unsigned char out[16][4]);
+    static std::uint16_t _toRGB565(const glm::vec3& color);
+    static glm::vec3 _fromRGB565(std::uint16_t color);
+    static bool _isFormatSupported(GLenum internalFormat);
+    static GLsizei _blocksAcross(const GLsizei size) { return (size + 3) / 4; }
+    static size_t _blockBytes(const Format format) { return format == FORMAT_BC1 ? 8 : 16; }
+};
+
+inline bool TextureCooker::_stampSource(const std::string& filename, std::int64_t& modifiedTime, std::uint64_t& size) {
+  struct stat info;
+  if (stat(filename.c_str(), &info) != 0) return false;
+  modifiedTime = static_cast<std::int64_t>(info.st_mtime);
+  size = static_cast<std::uint64_t>(info.st_size);
+  return true;
+}
+
+inline bool TextureCooker::load(const std::string& cookedFilename, const std::string& sourceFilename, Cooked& cooked) {
+  FILE* in = fopen(cookedFilename.c_str(), "rb");
+  if (!in) return false;
+
+  // anything that doesn't line up is just stale, the caller cooks again
+  Header header;
+  std::int64_t modifiedTime = 0;
+  std::uint64_t size = 0;
+  if (fread(&header, sizeof(Header), 1, in) != 1 || header.magic != MAGIC || header.version != VERSION ||
+      header.format > FORMAT_BC3 || header.numLevels == 0 || header.numLevels > 32 ||
+      !_stampSource(sourceFilename, modifiedTime, size) ||
+      header.sourceModifiedTime != modifiedTime || header.sourceSize != size) {
+    fclose(in);
+    return false;
+  }
+  std::vector<LevelHeader> levelHeaders(header.numLevels);
+  if (fread(levelHeaders.data(), sizeof(LevelHeader), header.numLevels, in) != header.numLevels) {
+    fclose(in);
+    return false;
+  }
+  cooked.format = static_cast<Format>(header.format);
+  cooked.levels.resize(header.numLevels);
+  for (std::uint32_t i = 0; i < header.numLevels; i++) {
+    Level& level = cooked.levels[i];
+    level.width = static_cast<GLsizei>(levelHeaders[i].width);
+    level.height = static_cast<GLsizei>(levelHeaders[i].height);
+    const size_t expected = static_cast<size_t>(_blocksAcross(level.width)) * _blocksAcross(level.height) * _blockBytes(cooked.format);
+    if (levelHeaders[i].size != expected) {
+      fclose(in);
+      return false;
+    }
+    level.blocks.resize(expected);
+    if (fread(level.blocks.data(), 1, expected, in) != expected) {
+      fclose(in);
+      return false;
+    }
+  }
+  fclose(in);
+  return true;
+}
+
+inline bool TextureCooker::write(const std::string& cookedFilename, const std::string& sourceFilename, const Cooked& cooked) {
+  Header header;
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.format = cooked.format;
+  header.numLevels = static_cast<std::uint32_t>(cooked.levels.size());
+  if (!_stampSource(sourceFilename, header.sourceModifiedTime, header.sourceSize)) return false;
+
+  FILE* out = fopen(cookedFilename.c_str(), "wb");
+  if (!out) {
+    fprintf(stderr, "[WARN]: Could not write cooked texture %s\n", cookedFilename.c_str());
+    return false;
+  }
+  fwrite(&header, sizeof(Header), 1, out);
+  for (const Level& level : cooked.levels) {
+    const LevelHeader levelHeader = {static_cast<std::uint32_t>(level.width), static_cast<std::uint32_t>(level.height),
+                                     static_cast<std::uint32_t>(level.blocks.size()), 0};
+    fwrite(&levelHeader, sizeof(LevelHeader), 1, out);
+  }
+  for (const Level& level : cooked.levels) {
+    fwrite(level.blocks.data(), 1, level.blocks.size(), out);
+  }
+  const bool ok = ferror(out) == 0;
+  fclose(out);
+  if (!ok) remove(cookedFilename.c_str());
+  return ok;
+}
+
+inline std::vector<unsigned char> TextureCooker::_downsample(const std::vector<unsigned char>& rgba, const GLsizei width, const GLsizei height) {
+  const GLsizei halfWidth = std::max(width / 2, 1), halfHeight = std::max(height / 2, 1);
+  std::vector<unsigned char> half(static_cast<size_t>(halfWidth) * halfHeight * 4);
+  // source rows/columns of an output row/column: its 2, the last one also takes an odd one left over
+  const auto sources = [](const GLsizei i, const GLsizei half, const GLsizei size) {
+    const GLsizei last = i == half - 1 ? size : std::min(i * 2 + 2, size);
+    return std::make_pair(i * 2, std::max(last, i * 2 + 1));
+  };
+  for (GLsizei y = 0; y < halfHeight; y++) {
+    const auto rows = sources(y, halfHeight, height);
+    for (GLsizei x = 0; x < halfWidth; x++) {
+      const auto columns = sources(x, halfWidth, width);
+      for (int channel = 0; channel < 4; channel++) {
+        GLuint sum = 0, count = 0;
+        for (GLsizei sy = rows.first; sy < rows.second; sy++) {
+          for (GLsizei sx = columns.first; sx < columns.second; sx++) {
+            sum += rgba[(static_cast<size_t>(sy) * width + sx) * 4 + channel];
+            count++;
+          }
+        }
+        half[(static_cast<size_t>(y) * halfWidth + x) * 4 + channel] = static_cast<unsigned char>((sum + count / 2) / count);
+      }
+    }
+  }
+  return half;
+}
+
+inline void TextureCooker::_readBlock(const unsigned char* rgba, const GLsizei width, const GLsizei height,
+                                      const GLsizei blockX, const GLsizei blockY, glm::vec4 pixels[16]) {
+  for (int y = 0; y < 4; y++) {
+    const GLsizei sy = std::min(blockY * 4 + y, height - 1);
+    for (int x = 0; x < 4; x++) {
+      const GLsizei sx = std::min(blockX * 4 + x, width - 1);
+      const unsigned char* p = rgba + (static_cast<size_t>(sy) * width + sx) * 4;
+      pixels[y * 4 + x] = glm::vec4(p[0], p[1], p[2], p[3]) / 255.0f;
+    }
+  }
+}
+
+inline std::uint16_t TextureCooker::_toRGB565(const glm::vec3& color) {
+  const auto channel = [](const GLfloat value, const GLfloat levels) {
+    return static_cast<std::uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * levels));
+  };
+  return static_cast<std::uint16_t>((channel(color.r, 31.0f) << 11) | (channel(color.g, 63.0f) << 5) | channel(color.b, 31.0f));
+}
+
+inline glm::vec3 TextureCooker::_fromRGB565(const std::uint16_t color) {
+  return glm::vec3(static_cast<GLfloat>((color >> 11) & 31) / 31.0f,
+                   static_cast<GLfloat>((color >> 5) & 63) / 63.0f,
+                   static_cast<GLfloat>(color & 31) / 31.0f);
+}
+
+inline void TextureCooker::_encodeColorBlock(const glm::vec4 pixels[16], unsigned char out[8]) {
+  glm::vec3 mean(0.0f);
+  for (int i = 0; i < 16; i++) mean += glm::vec3(pixels[i]);
+  mean /= 16.0f;
+
+  // principal axis of the block's colors by a few rounds of power iteration on their covariance
+  GLfloat covariance[6] = {0, 0, 0, 0, 0, 0};
+  for (int i = 0; i < 16; i++) {
+    const glm::vec3 d = glm::vec3(pixels[i]) - mean;
+    covariance[0] += d.r * d.r; covariance[1] += d.r * d.g; covariance[2] += d.r * d.b;
+    covariance[3] += d.g * d.g; covariance[4] += d.g * d.b; covariance[5] += d.b * d.b;
+  }
+  glm::vec3 axis(1.0f, 1.0f, 1.0f);
+  for (int iteration = 0; iteration < 4; iteration++) {
+    const glm::vec3 next(covariance[0] * axis.r + covariance[1] * axis.g + covariance[2] * axis.b,
+                         covariance[1] * axis.r + covariance[3] * axis.g + covariance[4] * axis.b,
+                         covariance[2] * axis.r + covariance[4] * axis.g + covariance[5] * axis.b);
+    const GLfloat length = glm::length(next);
+    if (length <= 1e-8f) break;
+    axis = next / length;
+  }
+
+  // the extremes along the axis become the endpoints
+  GLfloat minProjection = 1e9f, maxProjection = -1e9f;
+  for (int i = 0; i < 16; i++) {
+    const GLfloat projection = glm::dot(glm::vec3(pixels[i]) - mean, axis);
+    minProjection = std::min(minProjection, projection);
+    maxProjection = std::max(maxProjection, projection);
+  }
+  std::uint16_t color0 = _toRGB565(mean + axis * maxProjection);
+  std::uint16_t color1 = _toRGB565(mean + axis * minProjection);
+  // color0 > color1 picks the 4 color mode, equal endpoints just give a flat block
+  if (color0 < color1) std::swap(color0, color1);
+
+  const glm::vec3 endpoint0 = _fromRGB565(color0), endpoint1 = _fromRGB565(color1);
+  const glm::vec3 palette[4] = {endpoint0, endpoint1, (endpoint0 * 2.0f + endpoint1) / 3.0f, (endpoint0 + endpoint1 * 2.0f) / 3.0f};
+  std::uint32_t indices = 0;
+  for (int i = 0; i < 16; i++) {
+    GLuint best = 0;
+    GLfloat bestDistance = 1e9f;
+    for (GLuint candidate = 0; candidate < 4; candidate++) {
+      const glm::vec3 d = glm::vec3(pixels[i]) - palette[candidate];
+      const GLfloat distance = glm::dot(d, d);
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        best = candidate;
+      }
+    }
+    indices |= best << (i * 2);
+  }
+  if (color0 == color1) indices = 0;
+
+  out[0] = static_cast<unsigned char>(color0 & 0xFF);
+  out[1] = static_cast<unsigned char>(color0 >> 8);
+  out[2] = static_cast<unsigned char>(color1 & 0xFF);
+  out[3] = static_cast<unsigned char>(color1 >> 8);
+  for (int i = 0; i < 4; i++) out[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+}
+
+inline void TextureCooker::_encodeAlphaBlock(const glm::vec4 pixels[16], unsigned char out[8]) {
+  GLfloat minAlpha = 1.0f, maxAlpha = 0.0f;
+  for (int i = 0; i < 16; i++) {
+    minAlpha = std::min(minAlpha, pixels[i].a);
+    maxAlpha = std::max(maxAlpha, pixels[i].a);
+  }
+  // alpha0 > alpha1 picks the 8 value mode
+  const unsigned char alpha0 = static_cast<unsigned char>(std::lround(maxAlpha * 255.0f));
+  const unsigned char alpha1 = static_cast<unsigned char>(std::lround(minAlpha * 255.0f));
+  GLfloat palette[8] = {static_cast<GLfloat>(alpha0), static_cast<GLfloat>(alpha1)};
+  for (int i = 1; i < 7; i++) {
+    palette[i + 1] = (static_cast<GLfloat>(7 - i) * alpha0 + static_cast<GLfloat>(i) * alpha1) / 7.0f;
+  }
+  std::uint64_t indices = 0;
+  if (alpha0 != alpha1) {
+    for (int i = 0; i < 16; i++) {
+      const GLfloat alpha = pixels[i].a * 255.0f;
+      std::uint64_t best = 0;
+      for (std::uint64_t candidate = 1; candidate < 8; candidate++) {
+        if (std::fabs(alpha - palette[candidate]) < std::fabs(alpha - palette[best])) best = candidate;
+      }
+      indices |= best << (i * 3);
+    }
+  }
+  out[0] = alpha0;
+  out[1] = alpha1;
+  for (int i = 0; i < 6; i++) out[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+}
+
+inline TextureCooker::Cooked TextureCooker::cook(const unsigned char* rgba, const GLsizei width, const GLsizei height) {
+  Cooked cooked;
+  bool opaque = true;
+  for (size_t i = 3; i < static_cast<size_t>(width) * height * 4 && opaque; i += 4) opaque = rgba[i] == 255;
+  cooked.format = opaque ? FORMAT_BC1 : FORMAT_BC3;
+
+  std::vector<unsigned char> level(rgba, rgba + static_cast<size_t>(width) * height * 4);
+  GLsizei levelWidth = width, levelHeight = height;
+  glm::vec4 pixels[16];
+  while (true) {
+    Level encoded;
+    encoded.width = levelWidth;
+    encoded.height = levelHeight;
+    const GLsizei blocksX = _blocksAcross(levelWidth), blocksY = _blocksAcross(levelHeight);
+    encoded.blocks.resize(static_cast<size_t>(blocksX) * blocksY * _blockBytes(cooked.format));
+    unsigned char* out = encoded.blocks.data();
+    for (GLsizei blockY = 0; blockY < blocksY; blockY++) {
+      for (GLsizei blockX = 0; blockX < blocksX; blockX++) {
+        _readBlock(level.data(), levelWidth, levelHeight, blockX, blockY, pixels);
+        // BC3 is the alpha block followed by a BC1 color block
+        if (cooked.format == FORMAT_BC3) {
+          _encodeAlphaBlock(pixels, out);
+          out += 8;
+        }
+        _encodeColorBlock(pixels, out);
+        out += 8;
+      }
+    }
+    cooked.levels.push_back(std::move(encoded));
+
+    if (levelWidth == 1 && levelHeight == 1) break;
+    level = _downsample(level, levelWidth, levelHeight);
+    levelWidth = std::max(levelWidth / 2, 1);
+    levelHeight = std::max(levelHeight / 2, 1);
+  }
+  return cooked;
+}
+
+inline void TextureCooker::_decodeColorBlock(const unsigned char in[8], const bool alwaysFourColors, unsigned char out[16][4]) {
+  const std::uint16_t color0 = static_cast<std::uint16_t>(in[0] | (in[1] << 8));
+  const std::uint16_t color1 = static_cast<std::uint16_t>(in[2] | (in[3] << 8));
+  const glm::vec3 endpoint0 = _fromRGB565(color0), endpoint1 = _fromRGB565(color1);
+  glm::vec4 palette[4] = {glm::vec4(endpoint0, 1.0f), glm::vec4(endpoint1, 1.0f)};
+  if (alwaysFourColors || color0 > color1) {
+    palette[2] = glm::vec4((endpoint0 * 2.0f + endpoint1) / 3.0f, 1.0f);
+    palette[3] = glm::vec4((endpoint0 + endpoint1 * 2.0f) / 3.0f, 1.0f);
+  } else {
+    palette[2] = glm::vec4((endpoint0 + endpoint1) / 2.0f, 1.0f);
+    palette[3] = glm::vec4(0.0f);
+  }
+  const std::uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<std::uint32_t>(in[7]) << 24);
+  for (int i = 0; i < 16; i++) {
+    const glm::vec4& color = palette[(indices >> (i * 2)) & 3];
+    for (int channel = 0; channel < 4; channel++) out[i][channel] = static_cast<unsigned char>(std::lround(color[channel] * 255.0f));
+  }
+}
+
+inline void TextureCooker::_decodeAlphaBlock(const unsigned char in[8], unsigned char out[16][4]) {
+  const GLfloat alpha0 = in[0], alpha1 = in[1];
+  GLfloat palette[8] = {alpha0, alpha1};
+  if (in[0] > in[1]) {
+    for (int i = 1; i < 7; i++) palette[i + 1] = (static_cast<GLfloat>(7 - i) * alpha0 + static_cast<GLfloat>(i) * alpha1) / 7.0f;
+  } else {
+    // the 6 value mode with explicit 0 and 255
+    for (int i = 1; i < 5; i++) palette[i + 1] = (static_cast<GLfloat>(5 - i) * alpha0 + static_cast<GLfloat>(i) * alpha1) / 5.0f;
+    palette[6] = 0.0f;
+    palette[7] = 255.0f;
+  }
+  std::uint64_t indices = 0;
+  for (int i = 0; i < 6; i++) indices |= static_cast<std::uint64_t>(in[2 + i]) << (i * 8);
+  for (int i = 0; i < 16; i++) out[i][3] = static_cast<unsigned char>(std::lround(palette[(indices >> (i * 3)) & 7]));
+}
+
+inline bool TextureCooker::_isFormatSupported(const GLenum internalFormat) {
+  GLint numFormats = 0;
+  glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &numFormats);
+  std::vector<GLint> formats(static_cast<size_t>(std::max(numFormats, 0)));
+  if (!formats.empty()) glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+  return std::find(formats.begin(), formats.end(), static_cast<GLint>(internalFormat)) != formats.end();
+}
+
+inline GLuint TextureCooker::upload(const Cooked& cooked) {
+  if (cooked.levels.empty()) return 0;
+  const GLenum internalFormat = cooked.format == FORMAT_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  const bool compressed = _isFormatSupported(internalFormat);
+  if (!compressed) {
+    fprintf(stdout, "[WARN]: S3TC is not available, cooked textures are decoded to RGBA8\n");
+  }
+
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(cooked.levels.size() - 1));
+  std::vector<unsigned char> decoded;
+  unsigned char pixels[16][4];
+  for (GLint i = 0; i < static_cast<GLint>(cooked.levels.size()); i++) {
+    const Level& level = cooked.levels[i];
+    if (compressed) {
+      glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.width, level.height, 0,
+                             static_cast<GLsizei>(level.blocks.size()), level.blocks.data());
+      continue;
+    }
+    // no S3TC, still the right texture, just without the savings
+    decoded.assign(static_cast<size_t>(level.width) * level.height * 4, 255);
+    const GLsizei blocksX = _blocksAcross(level.width), blocksY = _blocksAcross(level.height);
+    const unsigned char* in = level.blocks.data();
+    for (GLsizei blockY = 0; blockY < blocksY; blockY++) {
+      for (GLsizei blockX = 0; blockX < blocksX; blockX++) {
+        if (cooked.format == FORMAT_BC3) {
+          _decodeColorBlock(in + 8, true, pixels);
+          _decodeAlphaBlock(in, pixels);
+        } else {
+          _decodeColorBlock(in, false, pixels);
+        }
+        in += _blockBytes(cooked.format);
+        for (int y = 0; y < 4 && blockY * 4 + y < level.height; y++) {
+          for (int x = 0; x < 4 && blockX * 4 + x < level.width; x++) {
+            memcpy(&decoded[(static_cast<size_t>(blockY * 4 + y) * level.width + blockX * 4 + x) * 4], pixels[y * 4 + x], 4);
+          }
+        }
+      }
+    }
+    glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data());
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return texture;
+}
+
+inline size_t TextureCooker::getCompressedSize(const Cooked& cooked) {
+  size_t size = 0;
+  for (const Level& level : cooked.levels) size += level.blocks.size();
+  return size;
+}
+
+inline size_t TextureCooker::getUncompressedSize(const Cooked& cooked) {
+  size_t size = 0;
+  for (const Level& level : cooked.levels) size += static_cast<size_t>(level.width) * level.height * 4;
+  return size;
+}
+
+#endif // TEXTURE_COOKER_HPP
@@ -0,0 +1,109 @@
+/**
+ * @file TransformNode.hpp
+ * @brief Node in a transform hierarchy with cached world and normal matrices
+ */
+
+#ifndef TRANSFORM_NODE_HPP
+#define TRANSFORM_NODE_HPP
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class TransformNode {
+  public:
+    TransformNode();
+    ~TransformNode();
+
+    /// \desc attaches a node below this one, the node is owned (and deleted) by its parent from then on
+    /// \param child node to attach, must not already have a parent
+    /// \return the attached child so parts can be built inline
+    TransformNode* addChild(TransformNode* child);
+
+    /// \desc sets the transform relative to the parent and marks this subtree for recomputation
+    void setLocalMatrix(const glm::mat4& localMtx);
+    const glm::mat4& getLocalMatrix() const { return _localMtx; }
+
+    /// \desc recomputes the world and normal matrices of every node below this one whose inputs changed
+    /// \note untouched subtrees are skipped entirely, so an idle hierarchy costs a single flag check
+    void updateWorldMatrices();
+
+    /// \desc world matrix as of the last updateWorldMatrices()
+    const glm::mat4& getWorldMatrix() const { return _worldMtx; }
+    /// \desc inverse-transpose of the world matrix as of the last updateWorldMatrices()
+    const glm::mat3& getNormalMatrix() const { return _normalMtx; }
+
+  private:
+    TransformNode* _parent;
+    std::vector<TransformNode*> _children;
+
+    glm::mat4 _localMtx;
+    glm::mat4 _worldMtx;
+    glm::mat3 _normalMtx;
+
+    /// \desc this node's local matrix changed since the last update
+    bool _dirty;
+    /// \desc some node below this one is dirty
+    bool _childDirty;
+
+    void _markChildDirty();
+    void _update(bool parentChanged);
+};
+
+inline TransformNode::TransformNode() :
+  _parent(nullptr),
+  _children(),
+  _localMtx(1.0f),
+  _worldMtx(1.0f),
+  _normalMtx(1.0f),
+  _dirty(true),
+  _childDirty(false) {
+}
+
+inline TransformNode::~TransformNode() {
+  for (TransformNode* child : _children) {
+    delete child;
+  }
+}
+
+inline TransformNode* TransformNode::addChild(TransformNode* child) {
+  child->_parent = this;
+  _children.push_back(child);
+  child->_dirty = true;
+  _markChildDirty();
+  return child;
+}
+
+inline void TransformNode::setLocalMatrix(const glm::mat4& localMtx) {
+  _localMtx = localMtx;
+  _dirty = true;
+  if (_parent) _parent->_markChildDirty();
+}
+
+inline void TransformNode::updateWorldMatrices() {
+  _update(false);
+}
+
+inline void TransformNode::_markChildDirty() {
+  // stop as soon as an ancestor already knows, everything above it does too
+  for (TransformNode* node = this; node && !node->_childDirty; node = node->_parent) {
+    node->_childDirty = true;
+  }
+}
+
+inline void TransformNode::_update(const bool parentChanged) {
+  const bool changed = _dirty || parentChanged;
+  if (!changed && !_childDirty) return;
+
+  if (changed) {
+    _worldMtx = _parent ? _parent->_worldMtx * _localMtx : _localMtx;
+    _normalMtx = glm::mat3(glm::transpose(glm::inverse(_worldMtx)));
+  }
+  for (TransformNode* child : _children) {
+    child->_update(changed);
+  }
+  _dirty = false;
+  _childDirty = false;
+}
+
+#endif // TRANSFORM_NODE_HPP
@@ -0,0 +1,329 @@
+/**
+ * @file VertexFormat.hpp
+ * @brief Compact vertex attribute encodings and the packer that interleaves a mesh in them
+ */
+
+#ifndef VERTEX_FORMAT_HPP
+#define VERTEX_FORMAT_HPP
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/// \desc how a mesh stores each vertex attribute. Half floats and normalized integers are turned back into
+/// floats by the attribute fetch, UNORM16 positions and octahedral normals need the VertexDecode in the shader
+struct VertexFormat {
+  /// \desc FLOAT 12 bytes, HALF 8, UNORM16 8 (quantized to the mesh's box)
+  enum Position : GLubyte { POSITION_FLOAT, POSITION_HALF, POSITION_UNORM16 };
+  /// \desc FLOAT 12 bytes, INT_2_10_10_10 4 (GL_INT_2_10_10_10_REV), OCTAHEDRAL 4 (two SNORM16)
+  enum Normal : GLubyte { NORMAL_FLOAT, NORMAL_INT_2_10_10_10, NORMAL_OCTAHEDRAL };
+  /// \desc FLOAT 8 bytes, HALF 4, UNORM16 4 (falls back to HALF for coordinates outside [0, 1])
+  enum TexCoord : GLubyte { TEXCOORD_FLOAT, TEXCOORD_HALF, TEXCOORD_UNORM16 };
+  /// \desc FLOAT 12 bytes, UNORM8 4
+  enum Color : GLubyte { COLOR_FLOAT, COLOR_UNORM8 };
+
+  Position position = POSITION_UNORM16;
+  Normal normal = NORMAL_OCTAHEDRAL;
+  TexCoord texCoord = TEXCOORD_UNORM16;
+  Color color = COLOR_UNORM8;
+
+  /// \desc 32-bit floats everywhere, what every mesh used before
+  static VertexFormat full() { return {POSITION_FLOAT, NORMAL_FLOAT, TEXCOORD_FLOAT, COLOR_FLOAT}; }
+  /// \desc formats the attribute fetch decodes on its own
+  static VertexFormat half() { return {POSITION_HALF, NORMAL_INT_2_10_10_10, TEXCOORD_HALF, COLOR_UNORM8}; }
+  /// \desc the smallest formats, positions and normals decoded by the shader
+  static VertexFormat compact() { return {}; }
+
+  /// \desc reads --vertex-format full|half|compact, compact when it is not given
+  static VertexFormat parse(int argc, char* argv[]);
+
+  bool isFull() const {
+    return position == POSITION_FLOAT && normal == NORMAL_FLOAT && texCoord == TEXCOORD_FLOAT && color == COLOR_FLOAT;
+  }
+};
+
+/// \desc what the shader needs to turn the stored position and normal back into model space,
+/// goes out with the object's uniforms (the defaults decode full floats)
+struct VertexDecode {
+  /// \desc model space position = stored position * positionScale + positionOffset
+  glm::vec3 positionScale = glm::vec3(1.0f);
+  glm::vec3 positionOffset = glm::vec3(0.0f);
+  /// \desc the normal attribute holds an octahedral encoding in xy
+  bool octahedralNormals = false;
+};
+
+/// \desc interleaves a mesh's vertices in a VertexFormat, every attribute starting on a 4 byte boundary
+class VertexPacker {
+  public:
+    /// \desc attributes a vertex can have, interleaved in this order
+    enum Attribute : GLuint { POSITION, NORMAL, TEX_COORD, COLOR, PART_INDEX, NUM_ATTRIBUTES };
+
+    /// \desc one vertex in full floats, only the attributes that are packed are read
+    struct Source {
+      glm::vec3 position;
+      glm::vec3 normal;
+      glm::vec2 texCoord;
+      glm::vec3 color;
+      GLfloat partIndex;
+    };
+
+    /// \desc packs numVertices vertices, getVertex(i) returns vertex i as a Source
+    /// \param attributes bit (1 << Attribute) set for every attribute the mesh has
+    template <typename GetVertex>
+    void pack(const VertexFormat& format, GLuint attributes, GLuint numVertices, GetVertex getVertex);
+
+    const std::vector<unsigned char>& getBytes() const { return _bytes; }
+    GLsizei getStride() const { return _stride; }
+    GLuint getNumVertices() const { return _numVertices; }
+    const VertexDecode& getDecode() const { return _decode; }
+
+    /// \desc points location at the attribute in the currently bound GL_ARRAY_BUFFER, does nothing for
+    /// attributes that weren't packed or a location of -1
+    void setAttributePointer(Attribute attribute, GLint location) const;
+
+    /// \desc prints the packed size next to what the same vertices take in full floats
+    void printSavings(const char* meshName) const;
+
+    /// \desc frees the packed bytes once they are uploaded, the layout stays for setAttributePointer
+    void releaseBytes() { std::vector<unsigned char>().swap(_bytes); }
+
+  private:
+    /// \desc size, type, and normalization of every packed attribute, size 0 when it isn't packed
+    struct Layout {
+      GLint size = 0;
+      GLenum type = GL_FLOAT;
+      GLboolean normalized = GL_FALSE;
+      GLuint offset = 0;
+      GLuint bytes = 0;
+    };
+    Layout _layouts[NUM_ATTRIBUTES];
+    std::vector<unsigned char> _bytes;
+    /// \desc bytes per packed vertex, and per vertex with the same attributes in full floats
+    GLsizei _stride = 0;
+    GLsizei _floatStride = 0;
+    GLuint _numVertices = 0;
+    VertexDecode _decode;
+
+    static std::uint16_t _toHalf(GLfloat value);
+    static std::uint16_t _toUnorm16(GLfloat value);
+    static std::int16_t _toSnorm16(GLfloat value);
+    static std::uint8_t _toUnorm8(GLfloat value);
+    /// \desc signed normalized 10 bits per axis in GL_INT_2_10_10_10_REV order, w left 0
+    static std::uint32_t _toInt2101010(const glm::vec3& normal);
+    /// \desc unit normal folded onto the octahedron and flattened into [-1, 1]^2
+    static glm::vec2 _toOctahedral(const glm::vec3& normal);
+};
+
+inline VertexFormat VertexFormat::parse(const int argc, char* argv[]) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--vertex-format") != 0) continue;
+    const char* name = argv[i + 1];
+    if (strcmp(name, "full") == 0) return full();
+    if (strcmp(name, "half") == 0) return half();
+    if (strcmp(name, "compact") != 0) {
+      fprintf(stderr, "[WARN]: unknown --vertex-format %s, expected full, half, or compact\n", name);
+    }
+  }
+  return compact();
+}
+
+inline std::uint16_t VertexPacker::_toHalf(const GLfloat value) {
+  std::uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  const std::uint32_t sign = (bits >> 16) & 0x8000;
+  const std::int32_t exponent = static_cast<std::int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+  std::uint32_t mantissa = bits & 0x7FFFFF;
+  if (exponent >= 31) return static_cast<std::uint16_t>(sign | 0x7C00);
+  if (exponent <= 0) {
+    // too small for a normal half, shift into a subnormal (or all the way to zero)
+    if (exponent < -10) return static_cast<std::uint16_t>(sign);
+    mantissa |= 0x800000;
+    const std::uint32_t shift = static_cast<std::uint32_t>(14 - exponent);
+    return static_cast<std::uint16_t>(sign | ((mantissa + (1u << (shift - 1))) >> shift));
+  }
+  // round to nearest, a carry out of the mantissa correctly bumps the exponent
+  return static_cast<std::uint16_t>(sign | ((static_cast<std::uint32_t>(exponent) << 10) + ((mantissa + 0x1000) >> 13)));
+}
+
+inline std::uint16_t VertexPacker::_toUnorm16(const GLfloat value) {
+  return static_cast<std::uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+inline std::int16_t VertexPacker::_toSnorm16(const GLfloat value) {
+  return static_cast<std::int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+inline std::uint8_t VertexPacker::_toUnorm8(const GLfloat value) {
+  return static_cast<std::uint8_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+}
+
+inline std::uint32_t VertexPacker::_toInt2101010(const glm::vec3& normal) {
+  const auto axis = [](const GLfloat value) {
+    return static_cast<std::uint32_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 511.0f)) & 0x3FF;
+  };
+  return axis(normal.x) | (axis(normal.y) << 10) | (axis(normal.z) << 20);
+}
+
+inline glm::vec2 VertexPacker::_toOctahedral(const glm::vec3& normal) {
+  const GLfloat sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+  if (sum <= 0.0f) return glm::vec2(0.0f);
+  glm::vec2 folded(normal.x / sum, normal.y / sum);
+  if (normal.z < 0.0f) {
+    // the lower half folds over the diagonals
+    folded = glm::vec2((1.0f - std::fabs(folded.y)) * (folded.x >= 0.0f ? 1.0f : -1.0f),
+                       (1.0f - std::fabs(folded.x)) * (folded.y >= 0.0f ? 1.0f : -1.0f));
+  }
+  return folded;
+}
+
+template <typename GetVertex>
+inline void VertexPacker::pack(const VertexFormat& format, const GLuint attributes, const GLuint numVertices, GetVertex getVertex) {
+  _numVertices = numVertices;
+  _decode = VertexDecode();
+  for (Layout& layout : _layouts) layout = Layout();
+
+  // UNORM16 positions are stored relative to the mesh's box, UNORM16 texCoords only fit in [0, 1]
+  glm::vec3 boxMin(0.0f), boxMax(0.0f);
+  bool texCoordsInUnitRange = true;
+  for (GLuint i = 0; i < numVertices; i++) {
+    const Source vertex = getVertex(i);
+    boxMin = i == 0 ? vertex.position : glm::min(boxMin, vertex.position);
+    boxMax = i == 0 ? vertex.position : glm::max(boxMax, vertex.position);
+    texCoordsInUnitRange = texCoordsInUnitRange && vertex.texCoord.x >= 0.0f && vertex.texCoord.x <= 1.0f &&
+                           vertex.texCoord.y >= 0.0f && vertex.texCoord.y <= 1.0f;
+  }
+  const VertexFormat::TexCoord texCoordFormat = format.texCoord == VertexFormat::TEXCOORD_UNORM16 && !texCoordsInUnitRange
+                                                ? VertexFormat::TEXCOORD_HALF : format.texCoord;
+
+  const auto place = [this](const Attribute attribute, const GLint size, const GLenum type, const GLboolean normalized, const GLuint bytes) {
+    _layouts[attribute] = {size, type, normalized, static_cast<GLuint>(_stride), bytes};
+    _stride += static_cast<GLsizei>((bytes + 3) & ~3u);
+  };
+  _stride = 0;
+  _floatStride = 0;
+  if (attributes & (1u << POSITION)) {
+    if (format.position == VertexFormat::POSITION_HALF) place(POSITION, 3, GL_HALF_FLOAT, GL_FALSE, 6);
+    else if (format.position == VertexFormat::POSITION_UNORM16) place(POSITION, 3, GL_UNSIGNED_SHORT, GL_TRUE, 6);
+    else place(POSITION, 3, GL_FLOAT, GL_FALSE, 12);
+    _floatStride += 12;
+  }
+  if (attributes & (1u << NORMAL)) {
+    if (format.normal == VertexFormat::NORMAL_INT_2_10_10_10) place(NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 4);
+    else if (format.normal == VertexFormat::NORMAL_OCTAHEDRAL) place(NORMAL, 2, GL_SHORT, GL_TRUE, 4);
+    else place(NORMAL, 3, GL_FLOAT, GL_FALSE, 12);
+    _floatStride += 12;
+  }
+  if (attributes & (1u << TEX_COORD)) {
+    if (texCoordFormat == VertexFormat::TEXCOORD_HALF) place(TEX_COORD, 2, GL_HALF_FLOAT, GL_FALSE, 4);
+    else if (texCoordFormat == VertexFormat::TEXCOORD_UNORM16) place(TEX_COORD, 2, GL_UNSIGNED_SHORT, GL_TRUE, 4);
+    else place(TEX_COORD, 2, GL_FLOAT, GL_FALSE, 8);
+    _floatStride += 8;
+  }
+  if (attributes & (1u << COLOR)) {
+    if (format.color == VertexFormat::COLOR_UNORM8) place(COLOR, 3, GL_UNSIGNED_BYTE, GL_TRUE, 3);
+    else place(COLOR, 3, GL_FLOAT, GL_FALSE, 12);
+    _floatStride += 12;
+  }
+  if (attributes & (1u << PART_INDEX)) {
+    // a small whole number, a byte holds it exactly unless everything is meant to stay a float
+    if (format.isFull()) place(PART_INDEX, 1, GL_FLOAT, GL_FALSE, 4);
+    else place(PART_INDEX, 1, GL_UNSIGNED_BYTE, GL_FALSE, 1);
+    _floatStride += 4;
+  }
+
+  if (format.position == VertexFormat::POSITION_UNORM16) {
+    _decode.positionScale = boxMax - boxMin;
+    _decode.positionOffset = boxMin;
+  }
+  _decode.octahedralNormals = (attributes & (1u << NORMAL)) && format.normal == VertexFormat::NORMAL_OCTAHEDRAL;
+
+  _bytes.assign(static_cast<size_t>(_stride) * numVertices, 0);
+  for (GLuint i = 0; i < numVertices; i++) {
+    const Source vertex = getVertex(i);
+    unsigned char* out = _bytes.data() + static_cast<size_t>(_stride) * i;
+    const auto write = [out](const Layout& layout, const void* data) { memcpy(out + layout.offset, data, layout.bytes); };
+
+    const Layout& position = _layouts[POSITION];
+    if (position.size) {
+      if (position.type == GL_HALF_FLOAT) {
+        const std::uint16_t packed[3] = {_toHalf(vertex.position.x), _toHalf(vertex.position.y), _toHalf(vertex.position.z)};
+        write(position, packed);
+      } else if (position.type == GL_UNSIGNED_SHORT) {
+        std::uint16_t packed[3];
+        for (int axis = 0; axis < 3; axis++) {
+          const GLfloat extent = _decode.positionScale[axis];
+          packed[axis] = _toUnorm16(extent > 0.0f ? (vertex.position[axis] - boxMin[axis]) / extent : 0.0f);
+        }
+        write(position, packed);
+      } else {
+        write(position, &vertex.position);
+      }
+    }
+    const Layout& normal = _layouts[NORMAL];
+    if (normal.size) {
+      if (normal.type == GL_INT_2_10_10_10_REV) {
+        const std::uint32_t packed = _toInt2101010(vertex.normal);
+        write(normal, &packed);
+      } else if (normal.type == GL_SHORT) {
+        const glm::vec2 octahedral = _toOctahedral(vertex.normal);
+        const std::int16_t packed[2] = {_toSnorm16(octahedral.x), _toSnorm16(octahedral.y)};
+        write(normal, packed);
+      } else {
+        write(normal, &vertex.normal);
+      }
+    }
+    const Layout& texCoord = _layouts[TEX_COORD];
+    if (texCoord.size) {
+      if (texCoord.type == GL_HALF_FLOAT) {
+        const std::uint16_t packed[2] = {_toHalf(vertex.texCoord.x), _toHalf(vertex.texCoord.y)};
+        write(texCoord, packed);
+      } else if (texCoord.type == GL_UNSIGNED_SHORT) {
+        const std::uint16_t packed[2] = {_toUnorm16(vertex.texCoord.x), _toUnorm16(vertex.texCoord.y)};
+        write(texCoord, packed);
+      } else {
+        write(texCoord, &vertex.texCoord);
+      }
+    }
+    const Layout& color = _layouts[COLOR];
+    if (color.size) {
+      if (color.type == GL_UNSIGNED_BYTE) {
+        const std::uint8_t packed[3] = {_toUnorm8(vertex.color.r), _toUnorm8(vertex.color.g), _toUnorm8(vertex.color.b)};
+        write(color, packed);
+      } else {
+        write(color, &vertex.color);
+      }
+    }
+    const Layout& partIndex = _layouts[PART_INDEX];
+    if (partIndex.size) {
+      if (partIndex.type == GL_UNSIGNED_BYTE) {
+        const std::uint8_t packed = static_cast<std::uint8_t>(vertex.partIndex + 0.5f);
+        write(partIndex, &packed);
+      } else {
+        write(partIndex, &vertex.partIndex);
+      }
+    }
+  }
+}
+
+inline void VertexPacker::setAttributePointer(const Attribute attribute, const GLint location) const {
+  const Layout& layout = _layouts[attribute];
+  if (location < 0 || layout.size == 0) return;
+  glEnableVertexAttribArray(location);
+  glVertexAttribPointer(location, layout.size, layout.type, layout.normalized, _stride, reinterpret_cast<const void*>(static_cast<size_t>(layout.offset)));
+}
+
+inline void VertexPacker::printSavings(const char* meshName) const {
+  const size_t packedBytes = _bytes.size();
+  const size_t floatBytes = static_cast<size_t>(_floatStride) * _numVertices;
+  fprintf(stdout, "[INFO]: %s vertices take %d bytes each, %zu bytes in all (%zu as floats, %.0f%% saved)\n",
+          meshName, _stride, packedBytes, floatBytes,
+          floatBytes ? 100.0 * (1.0 - static_cast<double>(packedBytes) / floatBytes) : 0.0);
+}
+
+#endif // VERTEX_FORMAT_HPP
@@ -11,18 +11,49 @@
  *
  */
 
+#include "A3Engine.h"
 #include "MPEngine.h"
 
+#include <cstdio>
+#include <cstring>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
+//returns true when --engine asks for the A3 city instead of the MP scene
+static bool parseUseA3Engine(const int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--engine") != 0) continue;
+        const char* name = argv[i + 1];
+        if (strcmp(name, "a3") == 0) return true;
+        if (strcmp(name, "mp") != 0) {
+            fprintf(stderr, "[WARN]: unknown --engine %s, expected mp or a3\n", name);
+        }
+    }
+    return false;
+}
+
 ///*****************************************************************************
 //
 // Our main function
-int main() {
-    const auto Engine = new MPEngine();
+//      pass --engine mp|a3 to pick the MP scene (default) or the A3 city
+//      pass --benchmark to render a scripted path offscreen and print frame statistics as JSON
+//      (see BenchmarkSettings::parse for the other options)
+//      pass --vertex-format full|half|compact to pick how the MP meshes are packed (compact by default)
+int main(int argc, char* argv[]) {
+    CSCI441::OpenGLEngine* Engine;
+    if (parseUseA3Engine(argc, argv)) {
+        const auto a3Engine = new A3Engine();
+        a3Engine->setBenchmark(BenchmarkSettings::parse(argc, argv));
+        Engine = a3Engine;
+    } else {
+        const auto mpEngine = new MPEngine();
+        mpEngine->setBenchmark(BenchmarkSettings::parse(argc, argv));
+        mpEngine->setVertexFormat(VertexFormat::parse(argc, argv));
+        Engine = mpEngine;
+    }
     Engine->initialize();
     if (Engine->getError() == CSCI441::OpenGLEngine::OPENGL_ENGINE_ERROR_NO_ERROR) {
         Engine->run();
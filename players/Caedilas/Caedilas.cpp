@@ -12,18 +12,20 @@ Caedilas::Caedilas(
     const GLint normalMtxUniformLocation,
     const GLint vPos,
     const GLint vNormal,
-    const GLint vTexCoord
+    const GLint vTexCoord,
+    const GLint vJointIndices,
+    const GLint vJointWeights
 ) {
-  mPosition = glm::vec3(1.0f, 1.0f, 0.0f);
-  mDirection = glm::vec3(1.0f, 0.0f, 0.0f);
-  mPhi = glm::pi<float>() / 2.0f;
-  mTheta = 0.0f;
+  setPosition(glm::vec3(1.0f, 1.0f, 0.0f));
+  setPhi(glm::pi<float>() / 2.0f);
+  setTheta(0.0f);
     setProgramUniformLocations(shaderProgramHandle, mvpMtxUniformLocation, normalMtxUniformLocation);
 
-  _model = new CSCI441::MD5Model();
-    //if ( _model->loadMD5Model("assets/models/monsters/hellknight/mesh/hellknight.md5mesh", "assets/models/monsters/hellknight/animations/idle2.md5anim") ) {
-    if ( _model->loadMD5Model("assets/models/Caedilas/mesh/Caedilas.md5mesh", "assets/models/Caedilas/animations/move.md5anim") ) {
-        _model->allocVertexArrays(vPos, vNormal, vTexCoord);
+  _model = new SkinnedMD5();
+    //if ( _model->load("assets/models/monsters/hellknight/mesh/hellknight.md5mesh", "assets/models/monsters/hellknight/animations/idle2.md5anim") ) {
+    if ( _model->load(MESH_FILENAME, ANIM_FILENAME) ) {
+        _model->setup(vPos, vNormal, vTexCoord, vJointIndices, vJointWeights);
+        glProgramUniform1i( shaderProgramHandle, glGetUniformLocation(shaderProgramHandle, "jointPalette"), PALETTE_TEXTURE_UNIT );
     } else {
         fprintf(stderr, "[ERROR]: Could not open MD5 Model\n");
         delete _model;
@@ -39,10 +41,21 @@ Caedilas::~Caedilas() {
 void Caedilas::draw(const glm::mat4& viewMtx, const glm::mat4& projMtx ) const {
     glm::mat4 modelMtx(1.0f);
 
-    modelMtx = glm::translate(modelMtx, mPosition);
-    modelMtx = glm::rotate(modelMtx, -mTheta, CSCI441::Y_AXIS);
-    //modelMtx = glm::rotate(modelMtx, mPhi, CSCI441::Z_AXIS);
-    
+    modelMtx = glm::translate(modelMtx, getPosition());
+    modelMtx = glm::rotate(modelMtx, -getTheta(), CSCI441::Y_AXIS);
+    //modelMtx = glm::rotate(modelMtx, getPhi(), CSCI441::Z_AXIS);
+    modelMtx = modelMtx * getModelSpaceMatrix();
+
+    _computeAndSendMatrixUniforms(modelMtx, viewMtx, projMtx);
+
+    //glm::vec3 color(0.0f, 0.0f, 0.0f);
+
+    //glProgramUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(color));
+    if (_model) _model->draw(PALETTE_TEXTURE_UNIT);
+}
+
+glm::mat4 Caedilas::getModelSpaceMatrix() {
+    glm::mat4 modelMtx(1.0f);
     // don't hover
     modelMtx = glm::translate(modelMtx, glm::vec3(0.0f, -1.0f, 0.0f));
     // stand upright
@@ -50,17 +63,12 @@ void Caedilas::draw(const glm::mat4& viewMtx, const glm::mat4& projMtx ) const {
     // face the right direction
     modelMtx = glm::rotate( modelMtx, glm::radians(90.0f), CSCI441::Z_AXIS );
     modelMtx = glm::scale(modelMtx, glm::vec3(2.5f, 2.5f, 2.5f));
-
-    _computeAndSendMatrixUniforms(modelMtx, viewMtx, projMtx);
-
-    //glm::vec3 color(0.0f, 0.0f, 0.0f);
-
-    //glProgramUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(color));
-    _model->draw();
+    return modelMtx;
 }
 
 void Caedilas::animate(const GLfloat dTime) {
-  _model->animate(dTime);
+  // only the skeleton is interpolated here, the vertices are skinned in the vertex shader
+  if (_model) _model->animate(dTime);
 }
 
 void Caedilas::_computeAndSendMatrixUniforms(const glm::mat4& modelMtx, const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
@@ -69,6 +77,7 @@ void Caedilas::_computeAndSendMatrixUniforms(const glm::mat4& modelMtx, const gl
     // then send it to the shader on the GPU to apply to every vertex
     glProgramUniformMatrix4fv( mShaderProgramHandle, mShaderProgramUniformLocations.mvpMtx, 1, GL_FALSE, &mvpMtx[0][0] );
 
-    //glm::mat3 normalMtx = glm::mat3( glm::transpose( glm::inverse( modelMtx )));
-    //glProgramUniformMatrix3fv( _shaderProgramHandle, _shaderProgramUniformLocations.normalMtx, 1, GL_FALSE, &normalMtx[0][0] );
+    // the skinned normals are lit in world space
+    glm::mat3 normalMtx = glm::mat3( glm::transpose( glm::inverse( modelMtx )));
+    glProgramUniformMatrix3fv( mShaderProgramHandle, mShaderProgramUniformLocations.normalMtx, 1, GL_FALSE, &normalMtx[0][0] );
 }
@@ -5,9 +5,8 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
-#include <CSCI441/MD5Model.hpp>
-
 #include "../../Player.hpp"
+#include "../../SkinnedMD5.hpp"
 
 class Caedilas : public Player  {
 public:
@@ -16,7 +15,9 @@ public:
     /// \param mvpMtxUniformLocation uniform location for the full precomputed MVP matrix
     /// \param normalMtxUniformLocation uniform location for the precomputed Normal matrix
     /// \param materialColorUniformLocation uniform location for the material diffuse color
-    Caedilas( GLuint shaderProgramHandle, GLint mvpMtxUniformLocation, GLint normalMtxUniformLocation, GLint vPos, GLint vNormal, GLint vTexCoord );
+    /// \param vJointIndices vJointWeights skinning attributes, the program is expected to be SkinnedMD5Shader
+    Caedilas( GLuint shaderProgramHandle, GLint mvpMtxUniformLocation, GLint normalMtxUniformLocation, GLint vPos, GLint vNormal, GLint vTexCoord,
+              GLint vJointIndices, GLint vJointWeights );
 
     ~Caedilas();
 
@@ -29,8 +30,20 @@ public:
     void draw(const glm::mat4& viewMtx, const glm::mat4& projMtx ) const;
     void animate(const GLfloat dTime);
 
+    /// \desc the skinned model, null if it failed to load. Background crowds bake and draw from it
+    SkinnedMD5* getModel() const { return _model; }
+    /// \desc stands the model upright, facing forward, at its size, before it is placed in the world
+    static glm::mat4 getModelSpaceMatrix();
+
+    /// \desc the mesh and the clip it plays
+    static constexpr const char* MESH_FILENAME = "assets/models/Caedilas/mesh/Caedilas.md5mesh";
+    static constexpr const char* ANIM_FILENAME = "assets/models/Caedilas/animations/move.md5anim";
+
 private:
-    CSCI441::MD5Model* _model;
+    /// \desc skinned in the vertex shader, animate() only moves the skeleton
+    SkinnedMD5* _model;
+    /// \desc texture unit the joint palette is bound to, unit 0 holds the diffuse map
+    static constexpr GLuint PALETTE_TEXTURE_UNIT = 1;
 
     /// \desc precomputes the matrix uniforms CPU-side and then sends them
     /// to the GPU to be used in the shader for each vertex.  It is more efficient
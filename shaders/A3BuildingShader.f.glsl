@@ -0,0 +1,18 @@
+/*
+ *   Fragment Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Instanced city buildings
+ */
+
+#version 410 core
+
+// all inputs from vertex shader
+in vec3 vertexColor;
+
+// all fragment outputs
+out vec4 fragColor;
+
+void main() {
+    fragColor = vec4(vertexColor, 1.0);
+}
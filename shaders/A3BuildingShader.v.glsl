@@ -0,0 +1,54 @@
+/*
+ *   Vertex Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Instanced city buildings: every building is an instance of one unit cube,
+ *   its model matrix and color are fetched from the building data texture buffer
+ */
+
+#version 410 core
+
+//cube vertex Attributes
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+//per-building instance Attribute
+layout(location = 2) in uint buildingIndex;
+
+//all Uniforms
+uniform mat4 viewProjMatrix;
+uniform vec3 lightDirection;
+uniform vec3 lightColor;
+//TEXELS_PER_BUILDING texels per building: the 4 model matrix columns, then (color, unused)
+uniform samplerBuffer buildingData;
+
+//must match A3Engine::TEXELS_PER_BUILDING
+const int TEXELS_PER_BUILDING = 5;
+
+//outputs to fragment shader
+out vec3 vertexColor;
+
+void main() {
+    //*****************************************
+    //********* Vertex Calculations  **********
+    //*****************************************
+
+    //this instance's building
+    int texel = int(buildingIndex) * TEXELS_PER_BUILDING;
+    mat4 modelMtx = mat4(texelFetch(buildingData, texel),
+                         texelFetch(buildingData, texel + 1),
+                         texelFetch(buildingData, texel + 2),
+                         texelFetch(buildingData, texel + 3));
+    vec3 materialColor = texelFetch(buildingData, texel + 4).rgb;
+
+    gl_Position = viewProjMatrix * modelMtx * vec4(vPos, 1.0);
+
+    //LIGHTING (per-vertex diffuse with a little ambient)
+    //buildings are scaled unevenly so the normal matrix is the inverse transpose, derived here instead of per draw on the CPU
+    mat3 normalMtx = transpose(inverse(mat3(modelMtx)));
+    vec3 N = normalize(normalMtx * vNormal);
+    vec3 L = normalize(-lightDirection);
+
+    vec3 ambient = 0.2 * materialColor;
+    vec3 diffuse = max(dot(N, L), 0.0) * lightColor * materialColor;
+    vertexColor = ambient + diffuse;
+}
@@ -0,0 +1,109 @@
+/*
+ *   Fragment Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Procedural ground grid: anti-aliased lines on the y = 0 plane computed per pixel, faded out with distance
+ */
+
+#version 410 core
+
+//per frame data shared with MPShader (layout must match MPEngine::FrameBlock)
+layout(std140) uniform FrameData {
+    mat4 viewMtx;
+    mat4 projMtx;
+    mat4 viewProjMtx;
+    vec4 lightDir;   //xyz used
+    vec4 lightColor; //xyz used
+    vec4 animClock;  //x = seconds, y = seconds spent walking
+};
+
+//all Uniforms
+uniform float gridSpacing;  //world units between lines
+uniform float fadeDistance; //lines are gone by this far from the camera
+
+//clustered point lights, see ClusteredLights.hpp (block layout must match ClusteredLights::ClusterBlock)
+layout(std140) uniform ClusterData {
+    vec4 clusterCounts; //xyz = clusters across, down, and deep
+    vec4 depthParams;   //x = near, y = far, z = slice scale, w = slice bias
+    vec4 screenSize;    //xy = framebuffer size in pixels
+};
+uniform samplerBuffer lightData;      //2 texels per light: (position, radius), (color, unused)
+uniform usamplerBuffer clusterLights; //per cluster: (first entry in lightIndices, number of lights)
+uniform usamplerBuffer lightIndices;
+
+//diffuse light from the point lights of this fragment's cluster
+vec3 clusteredPointLights(vec3 position, vec3 N, vec3 baseColor, float depth) {
+    //screen tile from the pixel, depth slice from the log of the view depth
+    uvec3 cluster = uvec3(clamp(gl_FragCoord.xy / screenSize.xy * clusterCounts.xy, vec2(0.0), clusterCounts.xy - 1.0),
+                          clamp(log(max(depth, depthParams.x)) * depthParams.z + depthParams.w, 0.0, clusterCounts.z - 1.0));
+    int clusterIndex = int(cluster.x + uint(clusterCounts.x) * (cluster.y + uint(clusterCounts.y) * cluster.z));
+    uvec2 range = texelFetch(clusterLights, clusterIndex).xy;
+    vec3 color = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(lightIndices, int(range.x + i)).x);
+        vec4 positionRadius = texelFetch(lightData, 2 * light);
+        vec3 pointColor = texelFetch(lightData, 2 * light + 1).rgb;
+        vec3 toLight = positionRadius.xyz - position;
+        float distance = length(toLight);
+        //smooth falloff that reaches zero at the radius so lights end at their cluster bounds
+        float falloff = clamp(1.0 - distance / positionRadius.w, 0.0, 1.0);
+        color += max(dot(N, toLight / max(distance, 1e-4)), 0.0) * falloff * falloff * pointColor * baseColor;
+    }
+    return color;
+}
+
+//inputs from vertex shader
+in vec3 nearPoint;
+in vec3 farPoint;
+flat in vec3 cameraPos;
+
+// all fragment outputs
+out vec4 fragColor;
+
+//every other line is white, the rest cyan (the same colors the line list grid used)
+const vec3 EVEN_LINE_COLOR = vec3(1.0, 1.0, 1.0);
+const vec3 ODD_LINE_COLOR = vec3(0.2, 0.84, 0.84);
+//line width in pixels
+const float LINE_WIDTH = 1.0;
+
+void main() {
+    //where the view ray through this pixel meets the ground, no hit (or past the far plane) draws nothing
+    float t = -nearPoint.y / (farPoint.y - nearPoint.y);
+    if (t <= 0.0 || t > 1.0) discard;
+    vec3 worldPos = nearPoint + t * (farPoint - nearPoint);
+
+    //distance to the nearest line of each family in grid cells, divided by how many cells a pixel covers
+    //to get it in pixels, so lines are LINE_WIDTH pixels wide and anti-aliased at any distance or angle
+    vec2 coord = worldPos.xz / gridSpacing;
+    vec2 cellsPerPixel = fwidth(coord);
+    vec2 pixelsToLine = abs(fract(coord - 0.5) - 0.5) / max(cellsPerPixel, vec2(1e-6));
+    vec2 coverage = 1.0 - clamp(pixelsToLine / LINE_WIDTH, 0.0, 1.0);
+    //once a pixel spans several lines they just average out, fade them before they shimmer
+    coverage *= 1.0 - clamp(cellsPerPixel - 0.5, 0.0, 1.0);
+
+    //the stronger family decides the color where lines cross
+    vec2 lineIndex = floor(coord + 0.5);
+    float alongX = step(coverage.x, coverage.y);
+    float index = mix(lineIndex.x, lineIndex.y, alongX);
+    vec3 baseColor = mod(index, 2.0) == 0.0 ? EVEN_LINE_COLOR : ODD_LINE_COLOR;
+    float alpha = max(coverage.x, coverage.y);
+    //fade with distance so the grid ends smoothly instead of at the far plane
+    alpha *= 1.0 - smoothstep(0.5 * fadeDistance, fadeDistance, length(worldPos - cameraPos));
+    if (alpha < 1.0 / 255.0) discard;
+
+    //same phong terms MPShader gives the upward facing line list grid
+    vec3 N = vec3(0.0, 1.0, 0.0);
+    vec3 L = normalize(-lightDir.xyz);
+    vec3 V = normalize(vec3(0.0, 0.0, 1.0));
+    vec3 R = reflect(-L, N);
+    vec3 ambient = 0.25 * baseColor;
+    vec3 diffuse = max(dot(N, L), 0.0) * lightColor.rgb * baseColor;
+    vec3 specular = pow(max(dot(R, V), 0.0), 20.0) * lightColor.rgb;
+    //plus the point lights near this part of the ground
+    vec3 pointLights = clusteredPointLights(worldPos, N, baseColor, -(viewMtx * vec4(worldPos, 1.0)).z);
+    fragColor = vec4(ambient + diffuse + specular + pointLights, alpha);
+
+    //depth of the ground point so the grid sorts against everything else
+    vec4 clipPos = viewProjMtx * vec4(worldPos, 1.0);
+    gl_FragDepth = 0.5 * (clipPos.z / clipPos.w) + 0.5;
+}
@@ -0,0 +1,40 @@
+/*
+ *   Vertex Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Procedural ground grid: one triangle covering the screen, the fragment shader finds the ground under each pixel
+ */
+
+#version 410 core
+
+//per frame data shared with MPShader (layout must match MPEngine::FrameBlock)
+layout(std140) uniform FrameData {
+    mat4 viewMtx;
+    mat4 projMtx;
+    mat4 viewProjMtx;
+    vec4 lightDir;   //xyz used
+    vec4 lightColor; //xyz used
+    vec4 animClock;  //x = seconds, y = seconds spent walking
+};
+
+//outputs to fragment shader: the world space points on the near and far planes behind this corner of the screen
+out vec3 nearPoint;
+out vec3 farPoint;
+flat out vec3 cameraPos;
+
+//clip space point back to world space
+vec3 unproject(vec2 ndc, float depth, mat4 invViewProjMtx) {
+    vec4 world = invViewProjMtx * vec4(ndc, depth, 1.0);
+    return world.xyz / world.w;
+}
+
+void main() {
+    //no vertex buffer, vertices 0-2 make a triangle big enough to cover the whole screen
+    vec2 ndc = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2)) * 2.0 - 1.0;
+    gl_Position = vec4(ndc, 0.0, 1.0);
+
+    mat4 invViewProjMtx = inverse(viewProjMtx);
+    nearPoint = unproject(ndc, -1.0, invViewProjMtx);
+    farPoint = unproject(ndc, 1.0, invViewProjMtx);
+    cameraPos = inverse(viewMtx)[3].xyz;
+}
@@ -7,31 +7,76 @@
 
 #version 410 core
 
+//optional features are #defined by ShaderVariants, see MPShader.v.glsl
+
 // all uniform inputs from vertex shader
 in vec3 vertexColor;
+in vec3 worldPos;
+in vec3 worldNormal;
+in vec3 pointLightColor;
+in float viewDepth;
+#ifdef USE_TEXTURE
 in vec2 vTexCoord;
-in float texEnabled;
-in vec3 vEmissiveColor;
-in float emissiveEnabled;
 
 //texture stuff
 uniform sampler2D texMap;
+#endif
+
+#ifdef USE_EMISSIVE
+//per material, must match the block in MPShader.v.glsl
+layout(std140) uniform MaterialData {
+    vec4 matColor;      //rgb used
+    vec4 emissiveColor; //rgb used
+};
+#endif
+
+//clustered point lights, see ClusteredLights.hpp (block layout must match ClusteredLights::ClusterBlock)
+layout(std140) uniform ClusterData {
+    vec4 clusterCounts; //xyz = clusters across, down, and deep
+    vec4 depthParams;   //x = near, y = far, z = slice scale, w = slice bias
+    vec4 screenSize;    //xy = framebuffer size in pixels
+};
+uniform samplerBuffer lightData;      //2 texels per light: (position, radius), (color, unused)
+uniform usamplerBuffer clusterLights; //per cluster: (first entry in lightIndices, number of lights)
+uniform usamplerBuffer lightIndices;
+
+//diffuse light from the point lights of this fragment's cluster
+vec3 clusteredPointLights(vec3 position, vec3 N, vec3 baseColor, float depth) {
+    //screen tile from the pixel, depth slice from the log of the view depth
+    uvec3 cluster = uvec3(clamp(gl_FragCoord.xy / screenSize.xy * clusterCounts.xy, vec2(0.0), clusterCounts.xy - 1.0),
+                          clamp(log(max(depth, depthParams.x)) * depthParams.z + depthParams.w, 0.0, clusterCounts.z - 1.0));
+    int clusterIndex = int(cluster.x + uint(clusterCounts.x) * (cluster.y + uint(clusterCounts.y) * cluster.z));
+    uvec2 range = texelFetch(clusterLights, clusterIndex).xy;
+    vec3 color = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(lightIndices, int(range.x + i)).x);
+        vec4 positionRadius = texelFetch(lightData, 2 * light);
+        vec3 pointColor = texelFetch(lightData, 2 * light + 1).rgb;
+        vec3 toLight = positionRadius.xyz - position;
+        float distance = length(toLight);
+        //smooth falloff that reaches zero at the radius so lights end at their cluster bounds
+        float falloff = clamp(1.0 - distance / positionRadius.w, 0.0, 1.0);
+        color += max(dot(N, toLight / max(distance, 1e-4)), 0.0) * falloff * falloff * pointColor * baseColor;
+    }
+    return color;
+}
 
 // all fragment outputs
 out vec4 fragColor;
 
 void main() {
-    vec3 color = vertexColor;
-    //check for texturing
-    if (texEnabled > 0.5) {
-        vec4 texColor = texture(texMap, vTexCoord);
-        color *= texColor.rgb;//modulate lighting with texture color
-    }
+    //directional light from the vertex shader plus the point lights near this fragment
+    vec3 color = vertexColor + clusteredPointLights(worldPos, normalize(worldNormal), pointLightColor, viewDepth);
+    //texturing
+#ifdef USE_TEXTURE
+    vec4 texColor = texture(texMap, vTexCoord);
+    color *= texColor.rgb;//modulate lighting with texture color
+#endif
 
-    //check for emissive
-    if (emissiveEnabled > 0.5) {
-        color += vEmissiveColor;
-    }
+    //emissive
+#ifdef USE_EMISSIVE
+    color += emissiveColor.rgb;
+#endif
 
     fragColor = vec4(color, 1.0);
 }
@@ -7,53 +7,154 @@
 
 #version 410 core
 
+//optional features, ShaderVariants #defines them right after the #version line:
+//  USE_TEXTURE       modulate the lighting with texMap
+//  USE_VERTEX_COLOR  multiply matColor by vColor
+//  USE_EMISSIVE      add the material's emissiveColor
+
 //all vertex Attributes
 layout(location = 0) in vec3 vPosition;
 layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 texCoord;
 layout(location = 3) in vec3 vColor;
+layout(location = 4) in float vPartIndex;
+
+//all Uniform blocks (layouts must match the FrameBlock/MaterialBlock/ObjectBlock structs in MPEngine.h)
+//per frame, uploaded once before drawing
+layout(std140) uniform FrameData {
+    mat4 viewMtx;
+    mat4 projMtx;
+    mat4 viewProjMtx;
+    vec4 lightDir;   //xyz used
+    vec4 lightColor; //xyz used
+    vec4 animClock;  //x = seconds (drives the spiral), y = seconds spent walking (drives the swing)
+};
+//per material, bound by offset (the fragment shader reads emissiveColor from the same block)
+layout(std140) uniform MaterialData {
+    vec4 matColor;      //rgb used
+    vec4 emissiveColor; //rgb used
+};
+//per object, bound by offset
+layout(std140) uniform ObjectData {
+    mat4 modelMtx;
+    mat4 normMtx; //upper 3x3 used
+    vec4 positionScale;  //xyz: model space position = vPosition * positionScale + positionOffset (VertexDecode)
+    vec4 positionOffset; //xyz used
+    ivec4 vertexFlags;   //x = 1 when vNormal holds an octahedral normal in xy
+};
 
 //all Uniforms
-uniform mat4 mvpMtx;
-uniform mat3 normMtx;
-uniform vec3 lightDir;
-uniform vec3 lightColor;
-uniform vec3 matColor;
-uniform bool useTexture;
-uniform bool useVertexColor;
-uniform vec3 emissiveColor;
-uniform bool useEmissive;
+//procedural animation (GPU animation mode)
+uniform int animMode;   //0 = none, 1 = spiral, 2 = swing
+uniform vec4 animParams; //spiral: (thetaMax, seconds to spiral out, radius per radian, bob height)
+                         //swing: (x amplitude, y amplitude, z amplitude in degrees, frequency in Hz)
+//rigid skinning: every part of a PartMesh picks its own matrices and animation by vPartIndex
+const int MAX_PARTS = 16; //must match PartMesh::MAX_PARTS
+uniform bool useParts;
+uniform mat4 partMtx[MAX_PARTS];     //part model matrix (applied before modelMtx)
+uniform mat3 partNormMtx[MAX_PARTS]; //part normal matrix (applied before normMtx)
+uniform int partAnimMode[MAX_PARTS];
+uniform vec4 partAnimParams[MAX_PARTS];
+
+const float PI = 3.14159265;
+//how many times the spiral bobs up and down on its way out
+const float SPIRAL_BOB_FREQUENCY = 4.0;
+
+//rotation about one of the principal axes (0 = x, 1 = y, 2 = z), same direction as glm::rotate
+mat3 axisRotation(int axis, float angle) {
+    float c = cos(angle);
+    float s = sin(angle);
+    if (axis == 0) return mat3(1, 0, 0,   0, c, s,   0, -s, c);
+    if (axis == 1) return mat3(c, 0, -s,  0, 1, 0,   s, 0, c);
+    return mat3(c, s, 0,   -s, c, 0,   0, 0, 1);
+}
+
+//unit normal from its octahedral encoding (VertexPacker::_toOctahedral)
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    //the lower half was folded over the diagonals
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+//triangle wave in [0, 1] that starts at 0 and reaches 1 at t = 1
+float triangle01(float t) {
+    return 1.0 - abs(mod(t, 2.0) - 1.0);
+}
 
 //outputs to fragment shader
 out vec3 vertexColor;
+//what the fragment shader needs to add the clustered point lights
+out vec3 worldPos;
+out vec3 worldNormal;
+out vec3 pointLightColor; //base color the point lights are reflected in
+out float viewDepth;
+#ifdef USE_TEXTURE
 out vec2 vTexCoord;
-out float texEnabled;
-out vec3 vEmissiveColor;
-out float emissiveEnabled;
+#endif
 
 void main() {
     //*****************************************
     //********* Vertex Calculations  **********
     //*****************************************
 
-    //emissive color stuff
-    vEmissiveColor = emissiveColor;
-    emissiveEnabled = useEmissive ? 1.0 : 0.0;
-
     //texture coord stuff
+#ifdef USE_TEXTURE
     vTexCoord = texCoord;
-    texEnabled = useTexture ? 1.0: 0.0;
+#endif
+    float animTime = animClock.x;
+    float walkTime = animClock.y;
     
+    //pick the part's animation when drawing a whole PartMesh
+    int part = int(vPartIndex + 0.5);
+    int mode = useParts ? partAnimMode[part] : animMode;
+    vec4 params = useParts ? partAnimParams[part] : animParams;
+
+    //unpack the stored vertex, then procedural animation in the part's local space
+    vec3 localPos = vPosition * positionScale.xyz + positionOffset.xyz;
+    vec3 localNormal = vertexFlags.x == 1 ? octahedralDecode(vNormal.xy) : vNormal;
+    if (mode == 1) {
+        //head ball spiral: theta ping-pongs between 0 and thetaMax
+        float theta = params.x * triangle01(animTime / params.y);
+        float r = params.z * theta;
+        localPos += vec3(r * cos(theta),
+                         params.w * sin(SPIRAL_BOB_FREQUENCY * PI * (theta / params.x)),
+                         r * sin(theta));
+    } else if (mode == 2) {
+        //limb swing: triangle wave between -amplitude and +amplitude starting at rest
+        float wave = 2.0 / PI * asin(sin(2.0 * PI * params.w * walkTime));
+        vec3 angles = radians(params.xyz) * wave;
+        mat3 swingMtx = axisRotation(1, angles.y) * axisRotation(0, angles.x) * axisRotation(2, angles.z);
+        localPos = swingMtx * localPos;
+        localNormal = swingMtx * localNormal;
+    }
+
+    //move the part into place
+    if (useParts) {
+        localPos = (partMtx[part] * vec4(localPos, 1.0)).xyz;
+        localNormal = partNormMtx[part] * localNormal;
+    }
+
     //transform vertex position
-    gl_Position = mvpMtx * vec4(vPosition, 1.0);
+    vec4 world = modelMtx * vec4(localPos, 1.0);
+    gl_Position = viewProjMtx * world;
+    worldPos = world.xyz;
+    viewDepth = -(viewMtx * world).z;
     
     //combine vColor and matColor for base material color and if we don't use vertex color just use matColor
-    vec3 baseColor = useVertexColor ? vColor * matColor : matColor;
+#ifdef USE_VERTEX_COLOR
+    vec3 baseColor = vColor * matColor.rgb;
+#else
+    vec3 baseColor = matColor.rgb;
+#endif
     
     //LIGHTING
     //normalize normal after transformation
-    vec3 N = normalize(normMtx * vNormal);
-    vec3 L = normalize(-lightDir); //ensure pointing toward light
+    vec3 N = normalize(mat3(normMtx) * localNormal);
+    worldNormal = N;
+    vec3 L = normalize(-lightDir.xyz); //ensure pointing toward light
     //view direction (viewer at origin)
     vec3 V = normalize(vec3(0.0, 0.0, 1.0));
     //Reflection vector
@@ -64,12 +165,13 @@ void main() {
     vec3 ambient = 0.25 * baseColor; //tweak this as seen fit
     //diffuse
     float diff = max(dot(N, L), 0.0);
-    vec3 diffuse = diff * lightColor * baseColor;
+    vec3 diffuse = diff * lightColor.rgb * baseColor;
     //specular
     float shininess = 20.0; //tweak this as seen fit
     float spec = pow(max(dot(R, V), 0.0), shininess);
-    vec3 specular = spec * lightColor;
+    vec3 specular = spec * lightColor.rgb;
     
-    //final vertex color
+    //final vertex color, the point lights are added per fragment
     vertexColor = ambient + diffuse + specular;
+    pointLightColor = baseColor;
 }
@@ -0,0 +1,90 @@
+/*
+ *   Vertex Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Instanced star field: every star is CUBES_PER_STAR rotated cubes drawn as instances,
+ *   the star itself is fetched from the star data texture buffer
+ */
+
+#version 410 core
+
+//cube vertex Attributes
+layout(location = 0) in vec3 vPosition;
+layout(location = 1) in vec3 vNormal;
+//per-star instance Attribute (advances once every CUBES_PER_STAR instances)
+layout(location = 4) in uint starIndex;
+
+//per frame data shared with MPShader (layout must match MPEngine::FrameBlock)
+layout(std140) uniform FrameData {
+    mat4 viewMtx;
+    mat4 projMtx;
+    mat4 viewProjMtx;
+    vec4 lightDir;   //xyz used
+    vec4 lightColor; //xyz used
+    vec4 animClock;  //x = seconds, y = seconds spent walking
+};
+
+//all Uniforms
+uniform float starTime; //seconds
+//TEXELS_PER_STAR texels per star: (position, size), (color, phase in degrees), (x/y/z spin in degrees per second, unused)
+uniform samplerBuffer starData;
+
+//must match StarField::CUBES_PER_STAR and StarField::TEXELS_PER_STAR
+const int CUBES_PER_STAR = 4;
+const int TEXELS_PER_STAR = 3;
+
+//outputs to fragment shader
+out vec3 vertexColor;
+
+//rotation about one of the principal axes (0 = x, 1 = y, 2 = z), same direction as glm::rotate
+mat3 axisRotation(int axis, float angle) {
+    float c = cos(angle);
+    float s = sin(angle);
+    if (axis == 0) return mat3(1, 0, 0,   0, c, s,   0, -s, c);
+    if (axis == 1) return mat3(c, 0, -s,  0, 1, 0,   s, 0, c);
+    return mat3(c, s, 0,   -s, c, 0,   0, 0, 1);
+}
+
+void main() {
+    //*****************************************
+    //********* Vertex Calculations  **********
+    //*****************************************
+
+    //this instance's star
+    int texel = int(starIndex) * TEXELS_PER_STAR;
+    vec4 positionSize = texelFetch(starData, texel);
+    vec4 colorPhase = texelFetch(starData, texel + 1);
+    vec3 spinRate = texelFetch(starData, texel + 2).xyz;
+    vec3 starPosition = positionSize.xyz;
+    vec3 starColor = colorPhase.rgb;
+
+    //which cube of the star this instance is: cube 0 is unrotated, cubes 1-3 spin about x, y, z at their own rate
+    int cube = gl_InstanceID % CUBES_PER_STAR;
+    mat3 rotMtx = mat3(1.0);
+    if (cube > 0) {
+        rotMtx = axisRotation(cube - 1, radians(45.0 + colorPhase.w + spinRate[cube - 1] * starTime));
+    }
+    //tiny scale difference between the cubes to avoid z-fighting
+    float scale = positionSize.w * (1.01 + 0.01 * float(cube));
+
+    //transform vertex position
+    vec3 worldPos = starPosition + rotMtx * (vPosition * scale);
+    gl_Position = viewProjMtx * vec4(worldPos, 1.0);
+
+    //LIGHTING (same per-vertex phong as MPShader with the star color as material and emissive)
+    //uniform scale + rotation so the normal matrix is just the rotation
+    vec3 N = normalize(rotMtx * vNormal);
+    vec3 L = normalize(-lightDir.xyz);
+    vec3 V = normalize(vec3(0.0, 0.0, 1.0));
+    vec3 R = reflect(-L, N);
+
+    vec3 ambient = 0.25 * starColor;
+    float diff = max(dot(N, L), 0.0);
+    vec3 diffuse = diff * lightColor.rgb * starColor;
+    float shininess = 20.0;
+    float spec = pow(max(dot(R, V), 0.0), shininess);
+    vec3 specular = spec * lightColor.rgb;
+
+    //final vertex color with the star glowing in its own color
+    vertexColor = ambient + diffuse + specular + starColor;
+}
@@ -0,0 +1,84 @@
+/*
+ *   Vertex Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Crowd of MD5 models drawn as instances: every instance blends the baked joint palettes of the two
+ *   frames around its own clip time, so nothing is animated per instance on the CPU
+ */
+
+#version 410 core
+
+//bind pose vertex Attributes (same as SkinnedMD5Shader)
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec2 vTexCoord;
+layout(location = 3) in uvec4 vJointIndices;
+layout(location = 4) in vec4 vJointWeights;
+//per-instance Attributes
+layout(location = 5) in vec4 instancePlacement;  //xyz = position, w = heading about +Y in radians
+layout(location = 6) in float instanceTimeOffset; //seconds
+
+//all Uniforms
+uniform mat4 viewProjMatrix;
+//how the model sits in its own space (upright, facing forward, scaled), shared by every instance
+uniform mat4 modelMatrix;
+uniform mat3 normalMatrix;
+uniform vec3 lightDirection;
+uniform vec3 lightColor;
+//clip clock in seconds, and the clip the palettes were baked from
+uniform float crowdTime;
+uniform float frameRate;
+uniform int numFrames;
+uniform int numJoints;
+//numFrames palettes one after another, TEXELS_PER_JOINT texels per joint
+uniform samplerBuffer bakedPalettes;
+
+//must match SkinnedMD5::TEXELS_PER_JOINT
+const int TEXELS_PER_JOINT = 4;
+
+//outputs to fragment shader
+out vec2 texCoord;
+out vec3 lighting;
+
+mat4 jointMatrix(int frame, uint joint) {
+    int texel = (frame * numJoints + int(joint)) * TEXELS_PER_JOINT;
+    return mat4(texelFetch(bakedPalettes, texel),
+                texelFetch(bakedPalettes, texel + 1),
+                texelFetch(bakedPalettes, texel + 2),
+                texelFetch(bakedPalettes, texel + 3));
+}
+
+//this vertex's skinning matrix at one baked frame
+mat4 skinMatrix(int frame) {
+    return vJointWeights.x * jointMatrix(frame, vJointIndices.x)
+         + vJointWeights.y * jointMatrix(frame, vJointIndices.y)
+         + vJointWeights.z * jointMatrix(frame, vJointIndices.z)
+         + vJointWeights.w * jointMatrix(frame, vJointIndices.w);
+}
+
+void main() {
+    //*****************************************
+    //********* Vertex Calculations  **********
+    //*****************************************
+
+    //where this instance is in the looping clip
+    float clipFrame = mod((crowdTime + instanceTimeOffset) * frameRate, float(numFrames));
+    int frame = min(int(clipFrame), numFrames - 1);
+    mat4 skinMtx = mix(skinMatrix(frame), skinMatrix((frame + 1) % numFrames), fract(clipFrame));
+
+    //stand the instance where it belongs, turned about +Y the same way as glm::rotate
+    float c = cos(instancePlacement.w);
+    float s = sin(instancePlacement.w);
+    mat4 placementMtx = mat4(c, 0.0, -s, 0.0,
+                             0.0, 1.0, 0.0, 0.0,
+                             s, 0.0, c, 0.0,
+                             instancePlacement.xyz, 1.0);
+    gl_Position = viewProjMatrix * placementMtx * modelMatrix * (skinMtx * vec4(vPos, 1.0));
+
+    //LIGHTING (per-vertex diffuse with a little ambient, same as SkinnedMD5Shader)
+    vec3 N = normalize(mat3(placementMtx) * (normalMatrix * (mat3(skinMtx) * vNormal)));
+    vec3 L = normalize(-lightDirection);
+    lighting = vec3(0.2) + max(dot(N, L), 0.0) * lightColor;
+
+    texCoord = vTexCoord;
+}
@@ -0,0 +1,23 @@
+/*
+ *   Fragment Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Textured MD5 model skinned on the GPU
+ */
+
+#version 410 core
+
+// all inputs from vertex shader
+in vec2 texCoord;
+in vec3 lighting;
+
+// all uniforms
+uniform sampler2D texMap;
+
+// all fragment outputs
+out vec4 fragColor;
+
+void main() {
+    vec4 texel = texture(texMap, texCoord);
+    fragColor = vec4(texel.rgb * lighting, texel.a);
+}
@@ -0,0 +1,61 @@
+/*
+ *   Vertex Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Textured MD5 model skinned on the GPU: every vertex is blended from up to 4 joint matrices
+ *   fetched from the joint palette texture buffer
+ */
+
+#version 410 core
+
+//bind pose vertex Attributes
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec2 vTexCoord;
+//skinning Attributes, the weights always add up to 1
+layout(location = 3) in uvec4 vJointIndices;
+layout(location = 4) in vec4 vJointWeights;
+
+//all Uniforms
+uniform mat4 mvpMatrix;
+uniform mat3 normalMatrix;
+uniform vec3 lightDirection;
+uniform vec3 lightColor;
+//TEXELS_PER_JOINT texels per joint: the 4 columns of current pose * inverse bind pose
+uniform samplerBuffer jointPalette;
+
+//must match SkinnedMD5::TEXELS_PER_JOINT
+const int TEXELS_PER_JOINT = 4;
+
+//outputs to fragment shader
+out vec2 texCoord;
+out vec3 lighting;
+
+mat4 jointMatrix(uint joint) {
+    int texel = int(joint) * TEXELS_PER_JOINT;
+    return mat4(texelFetch(jointPalette, texel),
+                texelFetch(jointPalette, texel + 1),
+                texelFetch(jointPalette, texel + 2),
+                texelFetch(jointPalette, texel + 3));
+}
+
+void main() {
+    //*****************************************
+    //********* Vertex Calculations  **********
+    //*****************************************
+
+    //linear blend of the joints moving this vertex
+    mat4 skinMtx = vJointWeights.x * jointMatrix(vJointIndices.x)
+                 + vJointWeights.y * jointMatrix(vJointIndices.y)
+                 + vJointWeights.z * jointMatrix(vJointIndices.z)
+                 + vJointWeights.w * jointMatrix(vJointIndices.w);
+    gl_Position = mvpMatrix * (skinMtx * vec4(vPos, 1.0));
+
+    //LIGHTING (per-vertex diffuse with a little ambient)
+    //the joints only rotate and translate, so their upper 3x3 moves the normal too
+    vec3 N = normalize(normalMatrix * (mat3(skinMtx) * vNormal));
+    vec3 L = normalize(-lightDirection);
+    lighting = vec3(0.2) + max(dot(N, L), 0.0) * lightColor;
+
+    texCoord = vTexCoord;
+}
@@ -0,0 +1,24 @@
+/*
+ *   Fragment Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Screen space text
+ */
+
+#version 410 core
+
+// all inputs from vertex shader
+in vec2 texCoord;
+in vec4 glyphColor;
+
+//one channel atlas, 1 where a glyph pixel is lit
+uniform sampler2D glyphAtlas;
+
+// all fragment outputs
+out vec4 fragColor;
+
+void main() {
+    //the atlas is sampled nearest so every texel is either lit or not
+    if (texture(glyphAtlas, texCoord).r < 0.5) discard;
+    fragColor = glyphColor;
+}
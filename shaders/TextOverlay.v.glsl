@@ -0,0 +1,27 @@
+/*
+ *   Vertex Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Screen space text: one quad per glyph, positioned in pixels
+ */
+
+#version 410 core
+
+//glyph quad Attributes
+layout(location = 0) in vec2 vPosition; //pixels from the top left corner of the screen
+layout(location = 1) in vec2 vTexCoord; //position in the glyph atlas
+layout(location = 2) in vec4 vColor;
+
+//all Uniforms
+uniform vec2 screenSize; //framebuffer size in pixels
+
+//outputs to fragment shader
+out vec2 texCoord;
+out vec4 glyphColor;
+
+void main() {
+    //pixels (y down) to normalized device coordinates (y up)
+    gl_Position = vec4(vPosition.x / screenSize.x * 2.0 - 1.0, 1.0 - vPosition.y / screenSize.y * 2.0, 0.0, 1.0);
+    texCoord = vTexCoord;
+    glyphColor = vColor;
+}
@@ -0,0 +1,37 @@
+/*
+ *   Vertex Shader
+ *
+ *   CSCI 441, Computer Graphics, Colorado School of Mines
+ *   Single material color lit by one directional light (the A3 ground)
+ */
+
+#version 410 core
+
+//vertex Attributes
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+
+//all Uniforms
+uniform mat4 mvpMatrix;
+uniform mat3 normalMatrix;
+uniform vec3 materialColor;
+uniform vec3 lightDirection;
+uniform vec3 lightColor;
+
+//outputs to fragment shader
+out vec3 vertexColor;
+
+void main() {
+    //*****************************************
+    //********* Vertex Calculations  **********
+    //*****************************************
+    gl_Position = mvpMatrix * vec4(vPos, 1.0);
+
+    //LIGHTING (per-vertex diffuse with a little ambient)
+    vec3 N = normalize(normalMatrix * vNormal);
+    vec3 L = normalize(-lightDirection);
+
+    vec3 ambient = 0.2 * materialColor;
+    vec3 diffuse = max(dot(N, L), 0.0) * lightColor * materialColor;
+    vertexColor = ambient + diffuse;
+}